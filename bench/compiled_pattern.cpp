@@ -0,0 +1,47 @@
+// Micro-benchmark for compiled patterns: the default pattern interpreted by spdlog::pattern_formatter, against the same
+// pattern parsed at compile time.
+
+#include "unlog/pattern.hpp"
+
+#include <cstdio>
+
+namespace {
+    std::unique_ptr<spdlog::formatter> runtime_formatter() {
+        auto formatter = std::make_unique<spdlog::pattern_formatter>();
+        formatter->add_flag<un::log::startup_elapsed_flag>('*');
+        formatter->set_pattern(un::log::DEFAULT_PATTERN);
+        return formatter;
+    }
+
+    double run(spdlog::formatter& formatter, size_t iterations) {
+        spdlog::source_loc loc{"/src/bench/compiled_pattern.cpp", 42, "run"};
+        spdlog::details::log_msg msg{loc, "bench", spdlog::level::info, "a message of typical length for the bench"};
+        spdlog::memory_buf_t buf;
+        size_t total{0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            msg.time += std::chrono::microseconds{1};
+            buf.clear();
+            formatter.format(msg, buf);
+            total += buf.size();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (total == 0)
+            std::abort();
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoull(argv[1]) : 5'000'000;
+
+    auto runtime = run(*runtime_formatter(), iterations);
+    auto compiled = run(*un::log::DEFAULT_COMPILED_PATTERN.make(), iterations);
+
+    std::printf("default pattern, %zu messages\n", iterations);
+    std::printf("  runtime (pattern_formatter): %7.2f ns/msg\n", runtime);
+    std::printf("  compiled (_pattern)        : %7.2f ns/msg\n", compiled);
+    std::printf("  speedup: %.2fx\n", runtime / compiled);
+}
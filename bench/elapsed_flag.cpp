@@ -0,0 +1,79 @@
+// Micro-benchmark for the %* (elapsed since startup) pattern flag: the previous implementation, which read the steady
+// clock and built a temporary string through fmt::format per message, against the cached allocation-free flag.
+
+#include "unlog/pattern.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdio>
+
+namespace {
+    const auto legacy_started_at = std::chrono::steady_clock::now();
+
+    class legacy_elapsed_flag : public spdlog::custom_flag_formatter {
+        static constexpr fmt::format_string<
+                std::chrono::hours::rep,
+                std::chrono::minutes::rep,
+                std::chrono::seconds::rep,
+                std::chrono::milliseconds::rep>
+                format_hours{"+{0:d}h{1:02d}m{2:02d}.{3:03d}s"},
+                format_minutes{"+{1:d}m{2:02d}.{3:03d}s"},
+                format_seconds{"+{2:d}.{3:03d}s"};
+
+      public:
+        void format(const spdlog::details::log_msg&, const std::tm&, spdlog::memory_buf_t& dest) override {
+            using namespace std::literals;
+            auto elapsed = std::chrono::steady_clock::now() - legacy_started_at;
+
+            dest.append(
+                    fmt::format(
+                            elapsed >= 1h     ? format_hours
+                            : elapsed >= 1min ? format_minutes
+                                              : format_seconds,
+                            std::chrono::duration_cast<std::chrono::hours>(elapsed).count(),
+                            (std::chrono::duration_cast<std::chrono::minutes>(elapsed) % 1h).count(),
+                            (std::chrono::duration_cast<std::chrono::seconds>(elapsed) % 1min).count(),
+                            (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed) % 1s).count()));
+        }
+
+        std::unique_ptr<custom_flag_formatter> clone() const override {
+            return std::make_unique<legacy_elapsed_flag>();
+        }
+    };
+
+    template <typename Flag>
+    double run(size_t iterations) {
+        spdlog::pattern_formatter formatter;
+        formatter.add_flag<Flag>('*');
+        formatter.set_pattern("%*");
+
+        spdlog::details::log_msg msg{"bench", spdlog::level::info, "message"};
+        spdlog::memory_buf_t buf;
+        size_t total{0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            msg.time += std::chrono::microseconds{1};
+            buf.clear();
+            formatter.format(msg, buf);
+            total += buf.size();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (total == 0)
+            std::abort();
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoull(argv[1]) : 5'000'000;
+
+    auto legacy = run<legacy_elapsed_flag>(iterations);
+    auto cached = run<un::log::startup_elapsed_flag>(iterations);
+
+    std::printf("%%* flag, %zu messages\n", iterations);
+    std::printf("  legacy (clock read + fmt::format): %7.2f ns/msg\n", legacy);
+    std::printf("  cached (message time + prefix)   : %7.2f ns/msg\n", cached);
+    std::printf("  speedup: %.2fx\n", legacy / cached);
+}
@@ -0,0 +1,345 @@
+// unlog_bench: per-call latency and sustained throughput of the level functors for each Config variant, producer
+// thread count and message size. Prints one JSON object per case on stdout (JSON Lines), for comparing runs:
+//
+//     unlog_bench [-n MESSAGES] [-t MAX_PRODUCERS] [-s SIZE,...] [-c NAME] [-l]
+//
+//     -n  messages logged by each producer (default 100000)
+//     -t  largest producer count; runs 1, 2, 4, ... up to it (default: hardware threads)
+//     -s  payload sizes in bytes (default 16,128,1024)
+//     -c  only run configs whose name contains NAME (repeatable)
+//     -l  list the configs and exit
+//
+// Every case runs in a child process of its own: the async thread pool, the master sink and the clock are
+// process-wide and sized by the first logger, so sharing a process would measure whichever config ran first.
+// Console configs write to /dev/null; color sinks are forced to emit escape codes as they would on a terminal.
+//
+// Latency is the time spent in the logging call, read with steady_clock around each call (the clock read itself is
+// included, typically 15-25ns). Throughput counts from the first message to the last one leaving the process: the
+// async queues are drained and the sinks flushed before the clock stops.
+
+#include "unlog.hpp"
+
+#include <spdlog/sinks/ansicolor_sink.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <barrier>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    using namespace std::literals;
+    using namespace un::log::literals;
+    using un::log::Config;
+    using un::log::Flags;
+
+    struct bench_config {
+        std::string_view name;
+        std::function<Config(const un::log::fs::path& file)> make;
+    };
+
+    Config single_threaded(Config conf) {
+        conf.flags &= static_cast<uint8_t>(~Flags::threadsafe);
+        return conf;
+    }
+
+    Config with_flags(Config conf, uint8_t flags) {
+        conf.flags = flags;
+        return conf;
+    }
+
+    Config asynchronous(Config conf, uint8_t threads = 1, uint32_t pool_size = 8192) {
+        conf.flags |= Flags::async;
+        conf.threads = threads;
+        conf.pool_threads = pool_size;
+        return conf;
+    }
+
+    const std::vector<bench_config>& configs() {
+        static const std::vector<bench_config> all{
+                {"default", [](auto&) { return Config::make_default("bench"); }},
+                {"default_mt",
+                 [](auto&) { return with_flags(Config::make_default("bench"), Flags::color | Flags::threadsafe); }},
+                {"nocolor_st", [](auto&) { return with_flags(Config::make_default("bench"), 0); }},
+                {"nocolor_mt", [](auto&) { return with_flags(Config::make_default("bench"), Flags::threadsafe); }},
+                {"async_t1_q8k", [](auto&) { return Config::make_async("bench", 1, 8192); }},
+                {"async_t2_q8k", [](auto&) { return Config::make_async("bench", 2, 8192); }},
+                {"async_t1_q64k", [](auto&) { return Config::make_async("bench", 1, 65536); }},
+                {"async_t4_q64k", [](auto&) { return Config::make_async("bench", 4, 65536); }},
+                {"async_spsc", [](auto&) { return Config::make_async("bench", 1, 8192, un::log::Engine::spsc); }},
+                {"deferred", [](auto&) { return Config::make_deferred("bench"); }},
+                {"deferred_spsc",
+                 [](auto&) { return Config::make_deferred("bench", 1, 8192, un::log::Engine::spsc); }},
+                {"file_mt", [](auto& file) { return Config::make_file(file, "bench"); }},
+                {"file_st", [](auto& file) { return single_threaded(Config::make_file(file, "bench")); }},
+                {"file_async", [](auto& file) { return asynchronous(Config::make_file(file, "bench")); }},
+                {"file_mmap",
+                 [](auto& file) { return Config::make_file(file, "bench", un::log::FileBackend::mmap); }},
+                {"file_uring",
+                 [](auto& file) { return Config::make_file(file, "bench", un::log::FileBackend::uring); }},
+                {"binary", [](auto& file) { return Config::make_binary(file, "bench"); }},
+        };
+        return all;
+    }
+
+    // Log-linear histogram of nanosecond values: 16 linear buckets per power of two, so a bucket is within ~6% of
+    // any value in it
+    class histogram {
+        static constexpr int SUB_BITS{4};
+        static constexpr uint64_t SUB{1 << SUB_BITS};
+
+        std::array<uint64_t, 64 * SUB> counts{};
+        uint64_t total{0};
+        uint64_t largest{0};
+
+        static size_t bucket(uint64_t v) {
+            if (v < SUB)
+                return v;
+            auto e = static_cast<uint64_t>(63 - __builtin_clzll(v));
+            return ((e - SUB_BITS + 1) << SUB_BITS) + ((v >> (e - SUB_BITS)) & (SUB - 1));
+        }
+
+        // midpoint of the values falling in bucket `b`
+        static uint64_t value(size_t b) {
+            if (b < SUB)
+                return b;
+            auto e = (b >> SUB_BITS) + SUB_BITS - 1;
+            auto width = uint64_t{1} << (e - SUB_BITS);
+            return ((SUB + (b & (SUB - 1))) << (e - SUB_BITS)) + width / 2;
+        }
+
+      public:
+        void add(uint64_t ns) {
+            ++counts[bucket(ns)];
+            ++total;
+            largest = std::max(largest, ns);
+        }
+
+        void merge(const histogram& other) {
+            for (size_t i = 0; i < counts.size(); ++i)
+                counts[i] += other.counts[i];
+            total += other.total;
+            largest = std::max(largest, other.largest);
+        }
+
+        uint64_t percentile(double p) const {
+            auto rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < counts.size(); ++b) {
+                seen += counts[b];
+                if (seen > rank)
+                    return std::min(value(b), largest);
+            }
+            return largest;
+        }
+
+        uint64_t max() const { return largest; }
+    };
+
+    struct options {
+        size_t messages{100'000};
+        size_t max_producers{std::max(1u, std::thread::hardware_concurrency())};
+        std::vector<size_t> sizes{16, 128, 1024};
+        std::vector<std::string> filters;
+    };
+
+    struct result {
+        double seconds;
+        uint64_t p50, p99, p999, max;
+    };
+
+    // Color sinks only color a terminal; make them do the work regardless, since the benchmark writes to /dev/null
+    void force_colors() {
+        for (auto sink : *un::log::master_sink->sinks()) {
+            for (bool unwrapped = false; not unwrapped;) {
+                if (auto* s = dynamic_cast<un::log::serialized_sink*>(sink.get()))
+                    sink = s->wrapped();
+                else if (auto* d = dynamic_cast<un::log::dedup_sink*>(sink.get()))
+                    sink = d->wrapped();
+                else
+                    unwrapped = true;
+            }
+            if (auto* s = dynamic_cast<spdlog::sinks::ansicolor_stdout_sink_mt*>(sink.get()))
+                s->set_color_mode(spdlog::color_mode::always);
+            else if (auto* s = dynamic_cast<spdlog::sinks::ansicolor_stdout_sink_st*>(sink.get()))
+                s->set_color_mode(spdlog::color_mode::always);
+        }
+    }
+
+    // Waits for everything logged so far to reach the sinks
+    void drain(const un::log::logger_ptr& logger) {
+        logger->flush();
+        if (auto pool = spdlog::thread_pool())
+            while (pool->queue_size() > 0)
+                std::this_thread::yield();
+        un::log::flush();
+    }
+
+    result run_case(const bench_config& bc, const options& opts, size_t producers, size_t size) {
+        auto file = un::log::fs::temp_directory_path() / "unlog_bench_{}.log"_format(::getpid());
+        un::log::fs::remove(file);
+
+        un::log::make_logger(bc.make(file), true);
+        force_colors();
+        auto& logger = un::log::global_logger();
+
+        std::string payload(size, 'x');
+        std::vector<histogram> latencies(producers);
+        std::barrier start{static_cast<std::ptrdiff_t>(producers + 1)};
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < producers; ++t)
+            threads.emplace_back([&, t] {
+                auto& hist = latencies[t];
+                std::string_view text{payload};
+                start.arrive_and_wait();
+                for (size_t i = 0; i < opts.messages; ++i) {
+                    auto before = std::chrono::steady_clock::now();
+                    un::log::info(logger, "bench {} {}", i, text);
+                    auto after = std::chrono::steady_clock::now();
+                    hist.add(static_cast<uint64_t>(std::chrono::nanoseconds{after - before}.count()));
+                }
+            });
+
+        // read before releasing the producers, which may otherwise finish before this thread runs again
+        auto begin = std::chrono::steady_clock::now();
+        start.arrive_and_wait();
+        for (auto& th : threads)
+            th.join();
+        drain(logger);
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+
+        histogram all;
+        for (auto& h : latencies)
+            all.merge(h);
+        un::log::fs::remove(file);
+
+        return {std::chrono::duration<double>(elapsed).count(),
+                all.percentile(50.0),
+                all.percentile(99.0),
+                all.percentile(99.9),
+                all.max()};
+    }
+
+    // Runs one case in a child process with stdout sent to /dev/null; the result comes back through a pipe
+    std::optional<result> run_isolated(const bench_config& bc, const options& opts, size_t producers, size_t size) {
+        int fds[2];
+        if (::pipe(fds) != 0)
+            return std::nullopt;
+
+        auto pid = ::fork();
+        if (pid < 0)
+            return std::nullopt;
+        if (pid == 0) {
+            ::close(fds[0]);
+            if (int null = ::open("/dev/null", O_WRONLY); null >= 0)
+                ::dup2(null, STDOUT_FILENO);
+            int status = 1;
+            try {
+                auto r = run_case(bc, opts, producers, size);
+                status = ::write(fds[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1;
+            }
+            catch (const std::exception& e) {
+                std::fprintf(stderr, "%.*s: %s\n", static_cast<int>(bc.name.size()), bc.name.data(), e.what());
+            }
+            std::fflush(stderr);
+            ::_exit(status);
+        }
+
+        ::close(fds[1]);
+        result r{};
+        auto n = ::read(fds[0], &r, sizeof(r));
+        ::close(fds[0]);
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        if (n != sizeof(r) or not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+            return std::nullopt;
+        return r;
+    }
+
+    bool selected(const options& opts, std::string_view name) {
+        return opts.filters.empty() or
+               std::ranges::any_of(opts.filters, [&](const std::string& f) { return name.contains(f); });
+    }
+
+    std::vector<size_t> parse_sizes(std::string_view list) {
+        std::vector<size_t> sizes;
+        while (not list.empty()) {
+            auto comma = list.find(',');
+            sizes.push_back(std::stoull(std::string{list.substr(0, comma)}));
+            list.remove_prefix(comma == list.npos ? list.size() : comma + 1);
+        }
+        return sizes;
+    }
+
+    int usage(const char* argv0) {
+        std::fprintf(stderr, "Usage: %s [-n MESSAGES] [-t MAX_PRODUCERS] [-s SIZE,...] [-c NAME] [-l]\n", argv0);
+        return 2;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "-n") == 0 && has_value)
+                opts.messages = std::stoull(argv[++i]);
+            else if (std::strcmp(argv[i], "-t") == 0 && has_value)
+                opts.max_producers = std::max<size_t>(1, std::stoull(argv[++i]));
+            else if (std::strcmp(argv[i], "-s") == 0 && has_value)
+                opts.sizes = parse_sizes(argv[++i]);
+            else if (std::strcmp(argv[i], "-c") == 0 && has_value)
+                opts.filters.emplace_back(argv[++i]);
+            else if (std::strcmp(argv[i], "-l") == 0) {
+                for (auto& bc : configs())
+                    std::printf("%.*s\n", static_cast<int>(bc.name.size()), bc.name.data());
+                return 0;
+            }
+            else
+                return usage(argv[0]);
+        }
+    }
+    catch (const std::exception&) {
+        return usage(argv[0]);
+    }
+
+    std::vector<size_t> producer_counts;
+    for (size_t p = 1; p < opts.max_producers; p *= 2)
+        producer_counts.push_back(p);
+    producer_counts.push_back(opts.max_producers);
+
+    int status = 0;
+    for (auto& bc : configs()) {
+        if (not selected(opts, bc.name))
+            continue;
+        for (auto producers : producer_counts) {
+            for (auto size : opts.sizes) {
+                auto r = run_isolated(bc, opts, producers, size);
+                if (not r) {
+                    status = 1;
+                    continue;
+                }
+                auto total = opts.messages * producers;
+                fmt::print(
+                        "{{\"config\":\"{}\",\"producers\":{},\"size\":{},\"messages\":{},\"seconds\":{:.6f},"
+                        "\"msgs_per_sec\":{:.0f},\"latency_ns\":{{\"p50\":{},\"p99\":{},\"p999\":{},\"max\":{}}}}}\n",
+                        bc.name,
+                        producers,
+                        size,
+                        total,
+                        r->seconds,
+                        static_cast<double>(total) / r->seconds,
+                        r->p50,
+                        r->p99,
+                        r->p999,
+                        r->max);
+                std::fflush(stdout);
+            }
+        }
+    }
+    return status;
+}
@@ -1,169 +1,367 @@
 #pragma once
 
+#include "unlog/limit.hpp"
 #include "unlog/logger.hpp"
 
 namespace un::log {
     // Objects operating as functions, utilizing CTAD to statically initialize templates for all possible arguments at
-    // the point of invocation. This allows for the deduction of the default parameter providing the source location
-    // until the point of instantiation
+    // the point of invocation. The format string converts to a detail::site_string at compile time, which captures the
+    // source location of the call and describes the call site (see callsite.hpp)
+    //
+    // Levels below UNLOG_ACTIVE_LEVEL are discarded at compile time: the constructor body is empty, so nothing is
+    // formatted or dispatched. Above it, a message below detail::min_level is rejected by a single relaxed load before
+    // the logger is touched. Argument expressions at the call site are still evaluated, as for any function call;
+    // guard expensive ones with unlog::enabled(level).
     template <typename... Arg>
     struct trace {
-        trace(const logger_ptr& logger,
-              fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::trace, fmt, std::forward<Arg>(args)...);
+        trace([[maybe_unused]] const logger_ptr& logger,
+              [[maybe_unused]] detail::site_string<Arg...> fmt,
+              [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::trace)) {
+                if (detail::level_enabled(LogLevel::trace) && logger)
+                    detail::dispatch(logger, LogLevel::trace, fmt, std::forward<Arg>(args)...);
+            }
         }
 
-        trace(fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::trace, fmt, std::forward<Arg>(args)...);
+        trace([[maybe_unused]] detail::site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::trace)) {
+                if (detail::level_enabled(LogLevel::trace))
+                    detail::dispatch(global_logger(), LogLevel::trace, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct debug {
-        debug(const logger_ptr& logger,
-              fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::debug, fmt, std::forward<Arg>(args)...);
+        debug([[maybe_unused]] const logger_ptr& logger,
+              [[maybe_unused]] detail::site_string<Arg...> fmt,
+              [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::debug)) {
+                if (detail::level_enabled(LogLevel::debug) && logger)
+                    detail::dispatch(logger, LogLevel::debug, fmt, std::forward<Arg>(args)...);
+            }
         }
 
-        debug(fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::debug, fmt, std::forward<Arg>(args)...);
+        debug([[maybe_unused]] detail::site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::debug)) {
+                if (detail::level_enabled(LogLevel::debug))
+                    detail::dispatch(global_logger(), LogLevel::debug, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct info {
-        info(const logger_ptr& logger,
-             fmt::format_string<Arg...> fmt,
-             Arg&&... args,
-             const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::info, fmt, std::forward<Arg>(args)...);
+        info([[maybe_unused]] const logger_ptr& logger,
+             [[maybe_unused]] detail::site_string<Arg...> fmt,
+             [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::info)) {
+                if (detail::level_enabled(LogLevel::info) && logger)
+                    detail::dispatch(logger, LogLevel::info, fmt, std::forward<Arg>(args)...);
+            }
         }
 
-        info(fmt::format_string<Arg...> fmt,
-             Arg&&... args,
-             const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::info, fmt, std::forward<Arg>(args)...);
+        info([[maybe_unused]] detail::site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::info)) {
+                if (detail::level_enabled(LogLevel::info))
+                    detail::dispatch(global_logger(), LogLevel::info, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct warn {
-        warn(const logger_ptr& logger,
-             fmt::format_string<Arg...> fmt,
-             Arg&&... args,
-             const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::warn, fmt, std::forward<Arg>(args)...);
+        warn([[maybe_unused]] const logger_ptr& logger,
+             [[maybe_unused]] detail::site_string<Arg...> fmt,
+             [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::warn)) {
+                if (detail::level_enabled(LogLevel::warn) && logger)
+                    detail::dispatch(logger, LogLevel::warn, fmt, std::forward<Arg>(args)...);
+            }
         }
 
-        warn(fmt::format_string<Arg...> fmt,
-             Arg&&... args,
-             const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::warn, fmt, std::forward<Arg>(args)...);
+        warn([[maybe_unused]] detail::site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::warn)) {
+                if (detail::level_enabled(LogLevel::warn))
+                    detail::dispatch(global_logger(), LogLevel::warn, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct critical {
         critical(
-                const logger_ptr& logger,
-                fmt::format_string<Arg...> fmt,
-                Arg&&... args,
-                const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::critical, fmt, std::forward<Arg>(args)...);
+                [[maybe_unused]] const logger_ptr& logger,
+                [[maybe_unused]] detail::site_string<Arg...> fmt,
+                [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::critical)) {
+                if (detail::level_enabled(LogLevel::critical) && logger)
+                    detail::dispatch(logger, LogLevel::critical, fmt, std::forward<Arg>(args)...);
+            }
         }
 
         critical(
-                fmt::format_string<Arg...> fmt,
-                Arg&&... args,
-                const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::critical, fmt, std::forward<Arg>(args)...);
+                [[maybe_unused]] detail::site_string<Arg...> fmt,
+                [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::critical)) {
+                if (detail::level_enabled(LogLevel::critical))
+                    detail::dispatch(global_logger(), LogLevel::critical, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct error {
-        error(const logger_ptr& logger,
-              fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), LogLevel::err, fmt, std::forward<Arg>(args)...);
+        error([[maybe_unused]] const logger_ptr& logger,
+              [[maybe_unused]] detail::site_string<Arg...> fmt,
+              [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::err)) {
+                if (detail::level_enabled(LogLevel::err) && logger)
+                    detail::dispatch(logger, LogLevel::err, fmt, std::forward<Arg>(args)...);
+            }
         }
 
-        error(fmt::format_string<Arg...> fmt,
-              Arg&&... args,
-              const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), LogLevel::err, fmt, std::forward<Arg>(args)...);
+        error([[maybe_unused]] detail::site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (detail::level_active(LogLevel::err)) {
+                if (detail::level_enabled(LogLevel::err))
+                    detail::dispatch(global_logger(), LogLevel::err, fmt, std::forward<Arg>(args)...);
+            }
         }
     };
 
     template <typename... Arg>
     struct log {
-        log(const logger_ptr& logger,
-            LogLevel level,
-            fmt::format_string<Arg...> fmt,
-            Arg&&... args,
-            const std::source_location& source_location = std::source_location::current()) {
-            if (logger)
-                logger->log(detail::sloc(source_location), level, fmt, std::forward<Arg>(args)...);
+        log(const logger_ptr& logger, LogLevel level, detail::site_string<Arg...> fmt, Arg&&... args) {
+            if (detail::level_active(level) && detail::level_enabled(level) && logger)
+                detail::dispatch(logger, level, fmt, std::forward<Arg>(args)...);
         }
 
-        log(fmt::format_string<Arg...> fmt,
-            LogLevel level,
-            Arg&&... args,
-            const std::source_location& source_location = std::source_location::current()) {
-            global_logger()->log(detail::sloc(source_location), level, fmt, std::forward<Arg>(args)...);
+        log(detail::site_string<Arg...> fmt, LogLevel level, Arg&&... args) {
+            if (detail::level_active(level) && detail::level_enabled(level))
+                detail::dispatch(global_logger(), level, fmt, std::forward<Arg>(args)...);
         }
     };
 
     // Template deduction guides
     template <typename... Arg>
-    trace(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> trace<Arg...>;
+    trace(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> trace<Arg...>;
     template <typename... Arg>
-    trace(fmt::format_string<Arg...>, Arg&&...) -> trace<Arg...>;
+    trace(detail::site_string<Arg...>, Arg&&...) -> trace<Arg...>;
 
     template <typename... Arg>
-    debug(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> debug<Arg...>;
+    debug(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> debug<Arg...>;
     template <typename... Arg>
-    debug(fmt::format_string<Arg...>, Arg&&...) -> debug<Arg...>;
+    debug(detail::site_string<Arg...>, Arg&&...) -> debug<Arg...>;
 
     template <typename... Arg>
-    info(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> info<Arg...>;
+    info(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> info<Arg...>;
     template <typename... Arg>
-    info(fmt::format_string<Arg...>, Arg&&...) -> info<Arg...>;
+    info(detail::site_string<Arg...>, Arg&&...) -> info<Arg...>;
 
     template <typename... Arg>
-    warn(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> warn<Arg...>;
+    warn(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> warn<Arg...>;
     template <typename... Arg>
-    warn(fmt::format_string<Arg...>, Arg&&...) -> warn<Arg...>;
+    warn(detail::site_string<Arg...>, Arg&&...) -> warn<Arg...>;
 
     template <typename... Arg>
-    error(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> error<Arg...>;
+    error(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> error<Arg...>;
     template <typename... Arg>
-    error(fmt::format_string<Arg...>, Arg&&...) -> error<Arg...>;
+    error(detail::site_string<Arg...>, Arg&&...) -> error<Arg...>;
 
     template <typename... Arg>
-    critical(const logger_ptr&, fmt::format_string<Arg...>, Arg&&...) -> critical<Arg...>;
+    critical(const logger_ptr&, detail::site_string<Arg...>, Arg&&...) -> critical<Arg...>;
     template <typename... Arg>
-    critical(fmt::format_string<Arg...>, Arg&&...) -> critical<Arg...>;
+    critical(detail::site_string<Arg...>, Arg&&...) -> critical<Arg...>;
 
     template <typename... Arg>
-    log(const logger_ptr&, LogLevel, fmt::format_string<Arg...>, Arg&&...) -> log<Arg...>;
+    log(const logger_ptr&, LogLevel, detail::site_string<Arg...>, Arg&&...) -> log<Arg...>;
     template <typename... Arg>
-    log(fmt::format_string<Arg...>, LogLevel, Arg&&...) -> log<Arg...>;
+    log(detail::site_string<Arg...>, LogLevel, Arg&&...) -> log<Arg...>;
+
+    // Rate-limited functors, per call site (see limit.hpp):
+    //   <level>_every(n, fmt, args...)        the first of every n messages
+    //   <level>_per_sec(rate, fmt, args...)   bursts of up to rate messages, then rate per second
+    //   <level>_sampled(p, fmt, args...)      each message with probability p
+    // Each also takes a logger first, like the plain functors.
+    template <typename... Arg>
+    struct trace_every : detail::limited<LogLevel::trace, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::trace, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct trace_per_sec : detail::limited<LogLevel::trace, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::trace, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct trace_sampled : detail::limited<LogLevel::trace, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::trace, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct debug_every : detail::limited<LogLevel::debug, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::debug, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct debug_per_sec : detail::limited<LogLevel::debug, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::debug, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct debug_sampled : detail::limited<LogLevel::debug, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::debug, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct info_every : detail::limited<LogLevel::info, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::info, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct info_per_sec : detail::limited<LogLevel::info, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::info, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct info_sampled : detail::limited<LogLevel::info, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::info, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct warn_every : detail::limited<LogLevel::warn, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::warn, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct warn_per_sec : detail::limited<LogLevel::warn, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::warn, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct warn_sampled : detail::limited<LogLevel::warn, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::warn, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct error_every : detail::limited<LogLevel::err, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::err, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct error_per_sec : detail::limited<LogLevel::err, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::err, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct error_sampled : detail::limited<LogLevel::err, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::err, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct critical_every : detail::limited<LogLevel::critical, detail::every_n, Arg...> {
+        using detail::limited<LogLevel::critical, detail::every_n, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct critical_per_sec : detail::limited<LogLevel::critical, detail::per_second, Arg...> {
+        using detail::limited<LogLevel::critical, detail::per_second, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    struct critical_sampled : detail::limited<LogLevel::critical, detail::sampled, Arg...> {
+        using detail::limited<LogLevel::critical, detail::sampled, Arg...>::limited;
+    };
+
+    template <typename... Arg>
+    trace_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> trace_every<Arg...>;
+    template <typename... Arg>
+    trace_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> trace_every<Arg...>;
+
+    template <typename... Arg>
+    trace_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> trace_per_sec<Arg...>;
+    template <typename... Arg>
+    trace_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> trace_per_sec<Arg...>;
+
+    template <typename... Arg>
+    trace_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> trace_sampled<Arg...>;
+    template <typename... Arg>
+    trace_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> trace_sampled<Arg...>;
+
+    template <typename... Arg>
+    debug_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> debug_every<Arg...>;
+    template <typename... Arg>
+    debug_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> debug_every<Arg...>;
+
+    template <typename... Arg>
+    debug_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> debug_per_sec<Arg...>;
+    template <typename... Arg>
+    debug_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> debug_per_sec<Arg...>;
+
+    template <typename... Arg>
+    debug_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> debug_sampled<Arg...>;
+    template <typename... Arg>
+    debug_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> debug_sampled<Arg...>;
+
+    template <typename... Arg>
+    info_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> info_every<Arg...>;
+    template <typename... Arg>
+    info_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> info_every<Arg...>;
+
+    template <typename... Arg>
+    info_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> info_per_sec<Arg...>;
+    template <typename... Arg>
+    info_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> info_per_sec<Arg...>;
+
+    template <typename... Arg>
+    info_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> info_sampled<Arg...>;
+    template <typename... Arg>
+    info_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> info_sampled<Arg...>;
+
+    template <typename... Arg>
+    warn_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> warn_every<Arg...>;
+    template <typename... Arg>
+    warn_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> warn_every<Arg...>;
+
+    template <typename... Arg>
+    warn_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> warn_per_sec<Arg...>;
+    template <typename... Arg>
+    warn_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> warn_per_sec<Arg...>;
+
+    template <typename... Arg>
+    warn_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> warn_sampled<Arg...>;
+    template <typename... Arg>
+    warn_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> warn_sampled<Arg...>;
+
+    template <typename... Arg>
+    error_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> error_every<Arg...>;
+    template <typename... Arg>
+    error_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> error_every<Arg...>;
+
+    template <typename... Arg>
+    error_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> error_per_sec<Arg...>;
+    template <typename... Arg>
+    error_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> error_per_sec<Arg...>;
+
+    template <typename... Arg>
+    error_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> error_sampled<Arg...>;
+    template <typename... Arg>
+    error_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> error_sampled<Arg...>;
+
+    template <typename... Arg>
+    critical_every(const logger_ptr&, detail::every_n, detail::site_string<Arg...>, Arg&&...) -> critical_every<Arg...>;
+    template <typename... Arg>
+    critical_every(detail::every_n, detail::site_string<Arg...>, Arg&&...) -> critical_every<Arg...>;
+
+    template <typename... Arg>
+    critical_per_sec(const logger_ptr&, detail::per_second, detail::site_string<Arg...>, Arg&&...) -> critical_per_sec<Arg...>;
+    template <typename... Arg>
+    critical_per_sec(detail::per_second, detail::site_string<Arg...>, Arg&&...) -> critical_per_sec<Arg...>;
+
+    template <typename... Arg>
+    critical_sampled(const logger_ptr&, detail::sampled, detail::site_string<Arg...>, Arg&&...) -> critical_sampled<Arg...>;
+    template <typename... Arg>
+    critical_sampled(detail::sampled, detail::site_string<Arg...>, Arg&&...) -> critical_sampled<Arg...>;
 
     // Exposed API functions
     inline void make_logger(const Config& conf, bool make_default = false) {
@@ -178,9 +376,29 @@ namespace un::log {
         return detail::get_default_level();
     }
 
+    // Whether a message at `level` could be logged by some logger; false means every call site at `level` is a no-op
+    inline bool enabled(LogLevel level) {
+        return detail::level_active(level) && detail::level_enabled(level);
+    }
+
+    // Starts, reconfigures or (with policy.enabled false) stops the flight recorder; see recorder.hpp
+    inline void set_flight_recorder(const RecorderPolicy& policy) {
+        return detail::set_flight_recorder(policy);
+    }
+
+    // Writes the flight recorder's messages to its dump file, or stderr
+    inline void dump_flight_recorder() {
+        return detail::recorder.dump();
+    }
+
+    // Hands the flight recorder's messages to `sink`, which formats them with its own pattern
+    inline void dump_flight_recorder(spdlog::sinks::sink& sink) {
+        return detail::recorder.dump(sink);
+    }
+
     template <spdlog_sink_t T, typename... Arg>
     inline void add_sink(Arg... args) {
-        return detail::add_sink(std::make_shared<T>(std::forward<Arg>(args)...));
+        return detail::add_sink(std::make_shared<T>(std::forward<Arg>(args)...), locking_sink_t<T>);
     }
 
     void flush();
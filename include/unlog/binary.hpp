@@ -0,0 +1,90 @@
+#pragma once
+
+#include "callsite.hpp"
+#include "config.hpp"
+#include "sinks.hpp"
+
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <functional>
+#include <unordered_map>
+
+namespace un::log {
+    /*  Binary log stream (Type::Binary)
+
+        Messages are written as frames instead of rendered text. Each frame starts with a one-byte tag; integers are
+        native-endian (the header records the byte order) and strings are a u32 length followed by the bytes:
+
+            'U' header  "UNLOGBIN" | u32 version | u32 byte order | i64 writer start time (ns)
+            'S' site    u32 id | u32 line | str file | str function | str format | str argument types
+            'N' name    u32 id | str logger name
+            'R' record  u32 site | u8 level | i64 time (ns) | u64 thread | u32 name | u32 size | arguments
+            'T' text    u8 level | i64 time (ns) | u64 thread | u32 name | u32 line | str file | str function | str text
+
+        A site or name frame is written before the first record that refers to it. Records carry the argument bytes
+        exactly as a deferred logger captured them, so nothing is formatted when logging; call sites whose arguments
+        cannot be decoded offline (see detail::type_code), and messages from loggers that are not deferred, are
+        written as rendered text. Appending to an existing file starts a new header, which resets the dictionaries.
+    */
+    namespace binary {
+        inline constexpr std::string_view MAGIC{"UNLOGBIN"};
+        inline constexpr uint32_t VERSION{1};
+        inline constexpr uint32_t ENDIAN_MARK{0x0102'0304};
+
+        enum class frame : uint8_t { header = 'U', site = 'S', name = 'N', record = 'R', text = 'T' };
+    }  // namespace binary
+
+    class binary_sink final : public spdlog::sinks::base_sink<std::mutex>, public record_sink {
+        spdlog::details::file_helper file;
+        spdlog::memory_buf_t buf;
+        std::vector<bool> written_sites;
+        std::unordered_map<std::string, uint32_t> names;
+
+        uint32_t name_id(spdlog::string_view_t name);
+        bool write_record(const spdlog::details::log_msg& msg, detail::record_kind kind);
+        void write_text(const spdlog::details::log_msg& msg, spdlog::string_view_t text);
+        void write(const spdlog::details::log_msg& msg, detail::record_kind kind);
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override;
+        void set_pattern_(const std::string&) override {}
+        void set_formatter_(std::unique_ptr<spdlog::formatter>) override {}
+
+      public:
+        explicit binary_sink(const fs::path& filename, bool truncate = false);
+
+        void log_record(const spdlog::details::log_msg& msg, detail::record_kind kind) override;
+    };
+
+    // Decodes a binary log written by binary_sink
+    class binary_reader {
+        struct site {
+            std::string file;
+            std::string function;
+            std::string fmt;
+            std::string types;
+            uint32_t line;
+        };
+
+        std::string data;
+        std::unordered_map<uint32_t, site> sites;
+        std::unordered_map<uint32_t, std::string> names;
+        spdlog::log_clock::time_point origin{};
+
+      public:
+        using callback = std::function<void(const spdlog::details::log_msg& msg)>;
+
+        // Throws std::runtime_error if the file cannot be read or is not a binary log
+        explicit binary_reader(const fs::path& filename);
+
+        // Start time of the process that wrote the messages most recently handed out, for the %* flag
+        spdlog::log_clock::time_point started_at() const { return origin; }
+
+        // Hands every message to `fn` in file order with its payload rendered as text; returns false if the stream
+        // ends partway through a frame (a writer that is still running, or one that died mid-write)
+        bool read(const callback& fn);
+    };
+
+}  // namespace un::log
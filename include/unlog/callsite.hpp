@@ -0,0 +1,181 @@
+#pragma once
+
+#include "format.hpp"
+
+#include <mutex>
+#include <string_view>
+
+namespace un::log::detail {
+    /*  Call-site registry
+
+        Every logging statement is described by a callsite built at compile time from the format string and the
+        source location of the call: file basename, line, function and the format string itself. The first time a
+        call site logs, its descriptor is interned into a fixed-size table and given a small integer ID; after that
+        the lookup is a single probe. Deferred records carry the ID instead of the format string, and the ID is the
+        key for anything that wants to keep per-call-site state.
+    */
+
+    using callsite_id = uint32_t;
+
+    inline constexpr callsite_id NO_CALLSITE{~callsite_id{0}};
+
+    inline constexpr std::string_view basename(std::string_view path) {
+        if (auto p = path.rfind('/'); p != path.npos)
+            path.remove_prefix(p + 1);
+        return path;
+    }
+
+    // Argument type codes, recorded with each call site so a binary log can be decoded without the program that wrote
+    // it. 'x' marks a type that only the writing process knows how to format.
+    template <typename T, typename U = std::remove_cvref_t<T>>
+    consteval char type_code() {
+        if constexpr (std::same_as<U, bool>)
+            return 'b';
+        else if constexpr (std::same_as<U, char>)
+            return 'c';
+        else if constexpr (std::is_integral_v<U> && (sizeof(U) & (sizeof(U) - 1)) == 0 && sizeof(U) <= 8)
+            return (std::is_signed_v<U> ? "ahxixxxl" : "AHxIxxxL")[sizeof(U) - 1];
+        else if constexpr (std::same_as<U, float>)
+            return 'f';
+        else if constexpr (std::same_as<U, double>)
+            return 'd';
+        else if constexpr (
+                std::same_as<U, std::string> || std::same_as<U, std::string_view> || std::same_as<U, cspan> ||
+                std::same_as<std::decay_t<U>, const char*> || std::same_as<std::decay_t<U>, char*>)
+            return 's';
+        else if constexpr (std::same_as<U, uspan>)
+            return 'u';
+        else if constexpr (std::same_as<U, bspan>)
+            return 'y';
+        else
+            return 'x';
+    }
+
+    template <typename... T>
+    inline constexpr char type_signature[]{type_code<T>()..., '\0'};
+
+    // Spelling of a list of argument types, unique per list: the name of this function's specialization
+    template <typename... T>
+    consteval std::string_view type_names() {
+        return std::source_location::current().function_name();
+    }
+
+    // 64-bit FNV-1a over the full path, line, column and argument types (a statement in a template logs different
+    // types per instantiation, and each needs its own render function); never 0, which marks an unregistrable
+    // (runtime) call site
+    inline constexpr uint64_t callsite_key(const std::source_location& loc, std::string_view types) {
+        uint64_t hash{0xcbf2'9ce4'8422'2325};
+        auto mix = [&hash](uint8_t byte) {
+            hash ^= byte;
+            hash *= 0x100'0000'01b3;
+        };
+        for (char c : std::string_view{loc.file_name()})
+            mix(static_cast<uint8_t>(c));
+        for (auto n : {loc.line(), loc.column()})
+            for (int i = 0; i < 4; ++i)
+                mix(static_cast<uint8_t>(n >> (8 * i)));
+        for (char c : types)
+            mix(static_cast<uint8_t>(c));
+        return hash ? hash : 1;
+    }
+
+    struct callsite {
+        std::string_view file;
+        std::string_view function;
+        std::string_view fmt;
+        std::string_view types;
+        uint32_t line;
+        uint64_t key;
+
+        constexpr spdlog::source_loc loc() const {
+            return spdlog::source_loc{file.data(), static_cast<int>(line), function.data()};
+        }
+    };
+
+    /*  Format string tagged with its call site
+
+        Takes the place of fmt::format_string in the level functors. The conversion from a string literal is
+        consteval, so the source location default argument resolves to the logging statement and the whole
+        descriptor is a constant. fmt::runtime strings are accepted but are not registered (key 0), as their
+        storage may not outlive the call.
+    */
+    using runtime_string = decltype(fmt::runtime(fmt::string_view{}));
+
+    template <typename... Arg>
+    struct basic_site_string {
+        fmt::format_string<Arg...> fmt;
+        callsite site;
+
+        template <typename S>
+            requires std::convertible_to<const S&, std::string_view>
+        consteval basic_site_string(
+                const S& s, const std::source_location& loc = std::source_location::current()) :
+                fmt{s},
+                site{basename(loc.file_name()),
+                     loc.function_name(),
+                     std::string_view{s},
+                     type_signature<Arg...>,
+                     loc.line(),
+                     callsite_key(loc, type_names<std::remove_cvref_t<Arg>...>())} {}
+
+        basic_site_string(runtime_string s, const std::source_location& loc = std::source_location::current()) :
+                fmt{s},
+                site{basename(loc.file_name()), loc.function_name(), {}, type_signature<Arg...>, loc.line(), 0} {}
+    };
+
+    template <typename... Arg>
+    using site_string = basic_site_string<std::type_identity_t<Arg>...>;
+
+    // Formats the captured arguments of a deferred record (see deferred.hpp) with the call site's format string
+    using render_fn = void (*)(std::string_view fmt, const std::byte* args, spdlog::memory_buf_t& out);
+
+    class callsite_registry {
+      public:
+        static constexpr size_t CAPACITY{4096};
+
+        struct entry {
+            callsite site;
+            spdlog::level::level_enum level;
+            render_fn render;  // null when the arguments cannot be captured
+        };
+
+      private:
+        static constexpr size_t MASK{CAPACITY - 1};
+        static constexpr size_t MAX_PROBE{16};
+
+        // a key is published (release) only after its entry is written, so a matching key implies a valid entry
+        std::array<std::atomic<uint64_t>, CAPACITY> keys{};
+        std::array<entry, CAPACITY> entries{};
+        std::atomic<size_t> count{0};
+        std::mutex insert_mutex;
+
+        callsite_id insert(const callsite& site, spdlog::level::level_enum level, render_fn render);
+
+      public:
+        // Returns the ID of `site`, registering it with the render function of its argument types on first use;
+        // NO_CALLSITE for runtime format strings or once the table is full
+        callsite_id intern(const callsite& site, spdlog::level::level_enum level, render_fn render = nullptr) {
+            if (site.key == 0)
+                return NO_CALLSITE;
+            auto i = site.key & MASK;
+            for (size_t probe = 0; probe < MAX_PROBE; ++probe, i = (i + 1) & MASK) {
+                auto k = keys[i].load(std::memory_order_acquire);
+                if (k == site.key)
+                    return static_cast<callsite_id>(i);
+                if (k == 0)
+                    break;
+            }
+            return insert(site, level, render);
+        }
+
+        const entry* find(callsite_id id) const {
+            if (id >= CAPACITY or keys[id].load(std::memory_order_acquire) == 0)
+                return nullptr;
+            return &entries[id];
+        }
+
+        size_t size() const { return count.load(std::memory_order_relaxed); }
+    };
+
+    extern callsite_registry callsites;
+}  // namespace un::log::detail
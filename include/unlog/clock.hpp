@@ -0,0 +1,90 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace un::log {
+    using namespace std::literals;
+
+    // timestamp source for log messages
+    enum class Clock : uint8_t { system, tsc };
+
+    inline constexpr auto clock_string(Clock c) {
+        switch (c) {
+            case Clock::system:
+                return "system"sv;
+            case Clock::tsc:
+                return "tsc"sv;
+            default:
+                [[unlikely]] return "ERR"sv;
+        }
+    }
+
+    namespace detail {
+        /*  Calibrated TSC clock
+
+            Reads the CPU timestamp counter instead of asking the OS for the time. A mapping from ticks to wall-clock
+            nanoseconds is measured when the clock is enabled and refreshed once a second by a calibration thread;
+            the mapping is published through a seqlock, so a timestamp costs one rdtsc, two loads and a multiply.
+            Without an invariant TSC (or off x86-64), steady_clock stands in for the counter.
+        */
+        class tsc_clock {
+            // wall_ns = anchor_ns + ((ticks - anchor_ticks) * mult) >> 32
+            std::atomic<uint64_t> sequence{0};
+            std::atomic<uint64_t> anchor_ticks{0};
+            std::atomic<int64_t> anchor_ns{0};
+            std::atomic<uint64_t> mult{uint64_t{1} << 32};
+
+            // first sample, used as the baseline for measuring the tick rate
+            uint64_t base_ticks{0};
+            std::chrono::steady_clock::time_point base_steady{};
+
+            bool use_tsc{false};
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool stopping{false};
+            std::thread calibrator;
+
+            void publish(uint64_t ticks, int64_t ns, uint64_t multiplier);
+
+          public:
+            static constexpr auto RECALIBRATE_INTERVAL{1s};
+
+            tsc_clock() = default;
+            ~tsc_clock();
+
+            // Whether the CPU advertises an invariant (constant rate, never stopped) timestamp counter
+            static bool invariant_tsc();
+
+            uint64_t ticks() const;
+
+            spdlog::log_clock::time_point now() const;
+
+            // Calibrates and starts the recalibration thread; idempotent
+            void start();
+
+            // Measures the tick rate against steady_clock and re-anchors the mapping at the current wall time
+            void recalibrate();
+
+            bool using_tsc() const { return use_tsc; }
+        };
+
+        extern tsc_clock tsc_source;
+        extern std::atomic<bool> tsc_enabled;
+
+        void set_clock(Clock clock);
+
+        // Timestamp for a new message from the configured clock
+        inline spdlog::log_clock::time_point now() {
+            if (tsc_enabled.load(std::memory_order_acquire))
+                return tsc_source.now();
+            return spdlog::log_clock::now();
+        }
+    }  // namespace detail
+
+}  // namespace un::log
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "clock.hpp"
 #include "format.hpp"
+#include "pattern.hpp"
 
 #include <bitset>
 #include <filesystem>
@@ -15,10 +17,129 @@ namespace un::log {
 
     using LogLevel = spdlog::level::level_enum;
 
-    // stdout, stderr, file, async (threadpool)
-    enum class Type : uint8_t { cout, cerr, File };
+    // stdout, stderr, file, binary file (see binary.hpp), shared memory ring drained by a collector (see shm.hpp)
+    enum class Type : uint8_t { cout, cerr, File, Binary, Shm };
 
-    enum Flags : uint8_t { threadsafe = 1 << 1, color = 1 << 2, async = 1 << 3 };
+    enum Flags : uint8_t { threadsafe = 1 << 1, color = 1 << 2, async = 1 << 3, deferred = 1 << 4 };
+
+    // async backend: spdlog's shared thread pool, or per-thread SPSC rings merged by a single backend thread
+    enum class Engine : uint8_t { pool, spsc };
+
+    inline constexpr auto engine_string(Engine e) {
+        switch (e) {
+            case Engine::pool:
+                return "pool"sv;
+            case Engine::spsc:
+                return "spsc"sv;
+            default:
+                [[unlikely]] return "ERR"sv;
+        }
+    }
+
+    // what an async logger does with a message when its queue is full: wait for room, drop the message, drop the
+    // oldest queued message (Engine::pool only), or append it to a spill file that the backend replays alongside the
+    // queue (Engine::spsc only)
+    enum class Overflow : uint8_t { block, drop_newest, overwrite_oldest, spill };
+
+    inline constexpr auto overflow_string(Overflow o) {
+        switch (o) {
+            case Overflow::block:
+                return "block"sv;
+            case Overflow::drop_newest:
+                return "drop_newest"sv;
+            case Overflow::overwrite_oldest:
+                return "overwrite_oldest"sv;
+            case Overflow::spill:
+                return "spill"sv;
+            default:
+                [[unlikely]] return "ERR"sv;
+        }
+    }
+
+    // how a sink renders messages: the sink's pattern (Config::format), or one JSON object / logfmt line per message
+    // with structured fields (see fields.hpp) written as typed keys
+    enum class Layout : uint8_t { pattern, json, logfmt };
+
+    inline constexpr auto layout_string(Layout l) {
+        switch (l) {
+            case Layout::pattern:
+                return "pattern"sv;
+            case Layout::json:
+                return "json"sv;
+            case Layout::logfmt:
+                return "logfmt"sv;
+            default:
+                [[unlikely]] return "ERR"sv;
+        }
+    }
+
+    // how Type::File writes: spdlog's stdio basic_file_sink, a preallocated memory mapping, or batches handed to a
+    // writer thread that submits them with io_uring (pwritev where io_uring is unavailable); see file_sinks.hpp
+    enum class FileBackend : uint8_t { stdio, mmap, uring };
+
+    inline constexpr auto file_backend_string(FileBackend b) {
+        switch (b) {
+            case FileBackend::stdio:
+                return "stdio"sv;
+            case FileBackend::mmap:
+                return "mmap"sv;
+            case FileBackend::uring:
+                return "uring"sv;
+            default:
+                [[unlikely]] return "ERR"sv;
+        }
+    }
+
+    // FileBackend::mmap tuning: the file grows (fallocate) and is mapped one chunk at a time
+    struct MmapPolicy {
+        // what a flush does with the written pages; the data survives a process crash regardless, since it is already
+        // in the page cache, while Sync::sync also makes it survive a power loss
+        enum class Sync : uint8_t { none, async, sync };
+
+        size_t chunk_size{64 << 20};
+        Sync sync{Sync::none};
+        // start writeback of finished chunks and drop them from the page cache, for logs nobody reads back soon
+        bool drop_behind{false};
+    };
+
+    // FileBackend::uring tuning: messages are formatted into buffers of buffer_size; a full buffer wakes the writer,
+    // which also picks up a partly filled one every interval. Producers wait once max_buffers are queued.
+    struct BatchPolicy {
+        size_t buffer_size{256 << 10};
+        size_t max_buffers{64};
+        std::chrono::milliseconds interval{10};
+    };
+
+    // Rotation of a FileBackend::stdio Type::File log: by size once the live file reaches max_size bytes, and/or by time
+    // at every multiple of interval since the epoch (UTC, so a day rotates at midnight UTC). Archives are numbered
+    // name.1.ext, name.2.ext, ...; compression is a zlib level (1-9) for gzipping them, 0 for none; max_files
+    // archives are kept, 0 keeps all.
+    struct RotationPolicy {
+        size_t max_size{0};
+        std::chrono::seconds interval{0};
+        size_t max_files{0};
+        int compression{0};
+
+        bool enabled() const { return max_size > 0 || interval.count() > 0; }
+    };
+
+    // Flight recorder (see recorder.hpp): keeps the last `records` messages of every thread down to `level`, whatever
+    // the loggers' levels, and writes them to dump_file (stderr when unset) on a crash or on dump_flight_recorder().
+    // Process-wide, like the clock: the last logger made with it enabled sets it.
+    struct RecorderPolicy {
+        bool enabled{false};
+        LogLevel level{LogLevel::trace};
+        size_t records{256};
+        std::optional<fs::path> dump_file{std::nullopt};
+        bool dump_on_crash{true};
+    };
+
+    // Type::Shm: the channel names the collector group (segments are /dev/shm/unlog.<channel>.<pid>); ring_size is the
+    // data bytes of this process' ring, rounded up to a power of two
+    struct ShmPolicy {
+        std::string channel{"unlog"};
+        size_t ring_size{4 << 20};
+    };
 
     inline constexpr auto type_string(Type t) {
         switch (t) {
@@ -28,6 +149,10 @@ namespace un::log {
                 return "cerr"sv;
             case Type::File:
                 return "file"sv;
+            case Type::Binary:
+                return "binary"sv;
+            case Type::Shm:
+                return "shm"sv;
             default:
                 [[unlikely]] return "ERR"sv;
         }
@@ -38,6 +163,24 @@ namespace un::log {
             - threadsafe (mt vs st)
             - color (yes vs no)
             - async (no vs yes)
+            - deferred (format on the calling thread vs the async backend; requires async)
+        - engine: async backend; for Engine::spsc, pool_threads is the ring size of each producer thread
+        - overflow, spill_file, spill_limit: full-queue policy of an async logger; the spill file defaults to
+          unlog-<pid>.spill in the temporary directory and is shared by every spilling logger (the first spilling
+          logger made names and caps it); once it holds spill_limit bytes, spilling loggers block until it is replayed
+        - layout: pattern text, JSON lines or logfmt; format is only used by Layout::pattern
+        - compiled: a pattern parsed at compile time ("..."_pattern, see pattern.hpp), used instead of format; without
+          either, the default pattern is compiled too
+        - sanitize: write control bytes (ANSI escapes and line breaks included) and invalid UTF-8 in the message text of
+          a Layout::pattern sink as \xHH; the other layouts always escape (see escape.hpp)
+        - utc: pattern dates and times in UTC rather than local time, skipping the timezone lookup; the other layouts
+          are always UTC
+        - clock: timestamp source; Clock::tsc switches the whole process over when the logger is made
+        - file_backend, mmap, batch: how Type::File writes, and the tuning for FileBackend::mmap and ::uring
+        - rotation: size/time rotation of a FileBackend::stdio file, off by default
+        - dedup_window: collapse consecutive identical messages arriving within this window (see dedup_sink); 0 is off
+        - recorder: per-thread flight recorder of recent messages, dumped on a crash; off by default
+        - shm: channel and ring size of a Type::Shm logger
     */
     struct Config {
         std::string name;
@@ -46,7 +189,23 @@ namespace un::log {
         uint8_t threads;
         uint32_t pool_threads;
         std::optional<std::string> format{std::nullopt};
+        compiled_pattern compiled{};
         std::optional<fs::path> filename{std::nullopt};
+        Engine engine{Engine::pool};
+        Overflow overflow{Overflow::block};
+        std::optional<fs::path> spill_file{std::nullopt};
+        uint64_t spill_limit{uint64_t{256} << 20};
+        Layout layout{Layout::pattern};
+        bool sanitize{false};
+        bool utc{false};
+        Clock clock{Clock::system};
+        FileBackend file_backend{FileBackend::stdio};
+        MmapPolicy mmap{};
+        BatchPolicy batch{};
+        RotationPolicy rotation{};
+        std::chrono::milliseconds dedup_window{0};
+        RecorderPolicy recorder{};
+        ShmPolicy shm{};
 
         Config() = delete;
 
@@ -62,8 +221,10 @@ namespace un::log {
                 threads{_threads},
                 pool_threads{_pool_size},
                 format{std::move(_format)} {
-            if (type == Type::File)
+            if (type == Type::File || type == Type::Binary)
                 throw std::invalid_argument{"File logger must have filename"};
+            if (deferred() && not async())
+                throw std::invalid_argument{"Deferred formatting requires an async logger"};
         }
 
         Config(std::string_view _name,
@@ -80,32 +241,125 @@ namespace un::log {
                 pool_threads{_pool_size},
                 format{std::move(_format)},
                 filename{std::move(_filename)} {
-            if (type != Type::File)
+            if (type != Type::File && type != Type::Binary)
                 throw std::invalid_argument{"File logger must use file type"};
             if (filename->empty())
                 throw std::invalid_argument{"File logger must have a non-empty filename"};
+            if (deferred() && not async())
+                throw std::invalid_argument{"Deferred formatting requires an async logger"};
         }
 
         static Config make_default(std::string_view n = "unlog"sv) { return Config{n, Type::cout, Flags::color, 0, 0}; }
 
-        static Config make_async(std::string_view n = "unlog"sv, uint8_t thread_count = 1, uint32_t pool_size = 8192) {
-            return Config{n, Type::cout, Flags::color | Flags::threadsafe | Flags::async, thread_count, pool_size};
+        static Config make_async(
+                std::string_view n = "unlog"sv,
+                uint8_t thread_count = 1,
+                uint32_t pool_size = 8192,
+                Engine engine = Engine::pool) {
+            auto conf = Config{n, Type::cout, Flags::color | Flags::threadsafe | Flags::async, thread_count, pool_size};
+            conf.engine = engine;
+            return conf;
+        }
+
+        static Config make_deferred(
+                std::string_view n = "unlog"sv,
+                uint8_t thread_count = 1,
+                uint32_t pool_size = 8192,
+                Engine engine = Engine::pool) {
+            auto conf = Config{
+                    n,
+                    Type::cout,
+                    Flags::color | Flags::threadsafe | Flags::async | Flags::deferred,
+                    thread_count,
+                    pool_size};
+            conf.engine = engine;
+            return conf;
+        }
+
+        static Config make_file(
+                const fs::path& file, std::string_view n = "unlog"sv, FileBackend backend = FileBackend::stdio) {
+            auto conf = Config{n, file, Type::File, Flags::threadsafe, 0, 0};
+            conf.file_backend = backend;
+            return conf;
+        }
+
+        static Config make_rotating(const fs::path& file, RotationPolicy rotation, std::string_view n = "unlog"sv) {
+            if (not rotation.enabled())
+                throw std::invalid_argument{"Rotation needs a size or an interval"};
+            if (rotation.compression < 0 || rotation.compression > 9)
+                throw std::invalid_argument{"Compression level must be between 0 and 9"};
+            auto conf = make_file(file, n);
+            conf.rotation = rotation;
+            return conf;
+        }
+
+        // Deferred, so records reach the binary sink with their arguments still encoded
+        static Config make_binary(
+                const fs::path& file,
+                std::string_view n = "unlog"sv,
+                uint8_t thread_count = 1,
+                uint32_t pool_size = 8192,
+                Engine engine = Engine::pool) {
+            auto conf = Config{
+                    n,
+                    file,
+                    Type::Binary,
+                    Flags::threadsafe | Flags::async | Flags::deferred,
+                    thread_count,
+                    pool_size};
+            conf.engine = engine;
+            return conf;
         }
 
-        static Config make_file(const fs::path& file, std::string_view n = "unlog"sv) {
-            return Config{n, file, Type::File, Flags::threadsafe, 0, 0};
+        // Synchronous, since a message only costs a copy into the ring; the collector does the formatting and I/O
+        static Config make_shm(
+                std::string_view channel = "unlog"sv, std::string_view n = "unlog"sv, size_t ring_size = 4 << 20) {
+            auto conf = Config{n, Type::Shm, Flags::threadsafe, 0, 0};
+            conf.shm = {std::string{channel}, ring_size};
+            return conf;
         }
 
         constexpr bool threadsafe() const { return flags & Flags::threadsafe; }
         constexpr bool color() const { return flags & Flags::color; }
         constexpr bool async() const { return flags & Flags::async; }
+        constexpr bool deferred() const { return flags & Flags::deferred; }
         constexpr bool cout_log() const { return type == Type::cout; }
         constexpr bool cerr_log() const { return type == Type::cerr; }
         constexpr bool file_log() const { return type == Type::File && filename.has_value(); }
+        constexpr bool binary_log() const { return type == Type::Binary && filename.has_value(); }
+        constexpr bool shm_log() const { return type == Type::Shm; }
 
         fs::path file() const { return filename.value_or(fs::path{"INVALID"}); }
 
-        std::string to_string() const { return "Config[ name={} | type={} ]"_format(name, type_string(type)); }
+        // Checks the settings made after construction; make_logger calls it before it changes anything
+        void validate() const {
+            if (overflow != Overflow::block && not async())
+                throw std::invalid_argument{"Overflow::{} requires an async logger"_format(overflow_string(overflow))};
+            if (async() && engine == Engine::spsc && overflow == Overflow::overwrite_oldest)
+                throw std::invalid_argument{"Overflow::overwrite_oldest is not supported by Engine::spsc"};
+#if SPDLOG_VERSION >= 11300
+            if (async() && engine == Engine::pool && overflow == Overflow::spill)
+#else
+            if (async() && engine == Engine::pool && (overflow == Overflow::spill || overflow == Overflow::drop_newest))
+#endif
+                throw std::invalid_argument{
+                        "Overflow::{} is not supported by Engine::pool"_format(overflow_string(overflow))};
+            if (rotation.enabled() && file_backend != FileBackend::stdio)
+                throw std::invalid_argument{"Rotation is only supported by FileBackend::stdio"};
+            if (recorder.enabled && recorder.records == 0)
+                throw std::invalid_argument{"The flight recorder must keep at least one record per thread"};
+        }
+
+        template <typename Out>
+        Out format_to(Out out) const {
+            return "Config[ name={} | type={} ]"_format_to(out, name, type_string(type));
+        }
+
+        std::string to_string() const {
+            std::string out;
+            format_to(std::back_inserter(out));
+            return out;
+        }
 
         static constexpr auto to_string_formattable = true;
     };
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "callsite.hpp"
+#include "clock.hpp"
+#include "fields.hpp"
+#include "format.hpp"
+#include "record.hpp"
+#include "sinks.hpp"
+
+#include <cstring>
+#include <new>
+#include <string>
+#include <tuple>
+
+namespace un::log::detail {
+    /*  Deferred (backend-side) formatting
+
+        Loggers made from a Config with Flags::deferred do not run fmt on the calling thread. Instead, the arguments
+        are captured by value into a record which is queued as the message payload:
+
+            [ record_header | arg 0 | arg 1 | ... ]
+
+        The header carries the ID of the call site, whose registry entry holds the format string and the render
+        function instantiated for the argument types when the call site was interned; the backend thread rebuilds the
+        arguments and formats them before handing the message to the sinks. The message is delivered as a record by
+        the path it takes, not by anything it holds (see record.hpp). Call sites that cannot be registered
+        (fmt::runtime strings, or a full registry) are formatted on the calling thread instead.
+    */
+
+    // Strings are copied into the record and read back as std::string_view
+    template <typename T, typename U = std::remove_cvref_t<T>>
+    concept deferred_string = std::same_as<U, std::string> || std::same_as<U, std::string_view> ||
+                              std::same_as<std::decay_t<U>, const char*> || std::same_as<std::decay_t<U>, char*>;
+
+    // Anything else captured by value must not refer to memory it does not own; fields refer to their key and value
+    template <typename T, typename U = std::remove_cvref_t<T>>
+    concept deferred_value = std::is_trivially_copyable_v<U> && !std::is_pointer_v<U> && !std::is_array_v<U> &&
+                             !std::ranges::range<U> && !field_type<U>;
+
+    template <typename T>
+    concept deferrable = deferred_string<T> || const_span_type<T> || deferred_value<T>;
+
+    struct record_header {
+        callsite_id site;
+    };
+
+    template <typename T>
+    struct capture;
+
+    // Whether `val` is a null C string, which fmt rejects; such a call is formatted by spdlog instead of deferred, so
+    // the logger reports the error as it would for any other logger
+    template <typename T>
+    constexpr bool null_string(const T& val) {
+        if constexpr (std::is_pointer_v<std::remove_cvref_t<T>>)
+            return val == nullptr;
+        else
+            return false;
+    }
+
+    template <deferred_string T>
+    struct capture<T> {
+        using type = std::string_view;
+
+        // marks a null C string, kept as an empty one (the flight recorder captures it before it can be rejected)
+        static constexpr size_t NULL_SIZE{~size_t{0}};
+
+        static void write(spdlog::memory_buf_t& buf, std::string_view val) {
+            auto size = val.size();
+            buf.append(reinterpret_cast<const char*>(&size), reinterpret_cast<const char*>(&size) + sizeof(size));
+            buf.append(val.data(), val.data() + size);
+        }
+
+        static void write(spdlog::memory_buf_t& buf, const char* val) {
+            if (val)
+                return write(buf, std::string_view{val});
+            auto size = NULL_SIZE;
+            buf.append(reinterpret_cast<const char*>(&size), reinterpret_cast<const char*>(&size) + sizeof(size));
+        }
+
+        static type read(const std::byte*& data) {
+            size_t size;
+            std::memcpy(&size, data, sizeof(size));
+            data += sizeof(size);
+            if (size == NULL_SIZE)
+                return {};
+            type val{reinterpret_cast<const char*>(data), size};
+            data += size;
+            return val;
+        }
+    };
+
+    template <const_span_type T>
+    struct capture<T> {
+        using type = std::remove_cvref_t<T>;
+
+        static void write(spdlog::memory_buf_t& buf, const type& val) {
+            capture<std::string_view>::write(buf, {reinterpret_cast<const char*>(val.data()), val.size()});
+        }
+
+        static type read(const std::byte*& data) {
+            auto sv = capture<std::string_view>::read(data);
+            return {reinterpret_cast<const typename type::element_type*>(sv.data()), sv.size()};
+        }
+    };
+
+    template <typename T>
+        requires(!deferred_string<T> && !const_span_type<T> && deferred_value<T>)
+    struct capture<T> {
+        using type = std::remove_cvref_t<T>;
+
+        static void write(spdlog::memory_buf_t& buf, const type& val) {
+            buf.append(reinterpret_cast<const char*>(&val), reinterpret_cast<const char*>(&val) + sizeof(type));
+        }
+
+        static type read(const std::byte*& data) {
+            alignas(type) std::byte storage[sizeof(type)];
+            std::memcpy(storage, data, sizeof(type));
+            data += sizeof(type);
+            return *std::launder(reinterpret_cast<type*>(storage));
+        }
+    };
+
+    template <typename... T>
+    void render_record(std::string_view fmt, [[maybe_unused]] const std::byte* args, spdlog::memory_buf_t& out) {
+        // braced initialization guarantees left-to-right evaluation, matching the order the arguments were written
+        std::tuple<typename capture<T>::type...> values{capture<T>::read(args)...};
+        std::apply(
+                [&](const auto&... vals) { fmt::vformat_to(fmt::appender(out), fmt, fmt::make_format_args(vals...)); },
+                values);
+    }
+
+    // The render function registered with a call site: one for its argument types if they can all be captured
+    template <typename... Arg>
+    consteval render_fn renderer() {
+        if constexpr ((deferrable<Arg> && ...))
+            return &render_record<std::remove_cvref_t<Arg>...>;
+        else
+            return nullptr;
+    }
+
+    template <typename... Arg>
+    void log_deferred(
+            spdlog::logger& logger,
+            spdlog::source_loc loc,
+            spdlog::level::level_enum level,
+            callsite_id site,
+            const Arg&... args) {
+        spdlog::memory_buf_t buf;
+        record_header header{site};
+        buf.append(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+        (capture<std::remove_cvref_t<Arg>>::write(buf, args), ...);
+        log_record(logger, now(), loc, level, spdlog::string_view_t{buf.data(), buf.size()}, record_kind::deferred);
+    }
+
+    // Renders `payload`, a record of `kind`, into `out`; returns false for text and for records that cannot be
+    // rendered
+    bool render_deferred(record_kind kind, spdlog::string_view_t payload, spdlog::memory_buf_t& out);
+
+    // The copy of record `msg` a sink that takes text is given, its payload rendered into `buf`; while `fields` is in
+    // scope, the structured formatters can find the fields behind it
+    spdlog::details::log_msg rendered_copy(
+            const spdlog::details::log_msg& msg, record_kind kind, spdlog::memory_buf_t& buf, fields_scope& fields);
+
+    // Hands messages from deferred loggers to the master sink, which renders records on the backend thread for the
+    // sinks that want text
+    class deferred_sink final : public spdlog::sinks::sink, public record_sink {
+      public:
+        void log(const spdlog::details::log_msg& msg) override;
+        void log_record(const spdlog::details::log_msg& msg, record_kind kind) override;
+        void flush() override;
+        void set_pattern(const std::string&) override {}
+        void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+    };
+
+    const std::shared_ptr<deferred_sink>& get_deferred_sink();
+
+    // Loggers created with Config::deferred() are the ones whose sink is the deferred sink; checked by the level
+    // functors to select the capture path
+    inline bool is_deferred(const spdlog::logger* logger) {
+        const auto& sinks = logger->sinks();
+        return sinks.size() == 1 and sinks.front() == get_deferred_sink();
+    }
+}  // namespace un::log::detail
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <string_view>
+
+namespace un::log {
+    /*  Escaping and sanitizing
+
+        Message text can carry bytes a log must not pass through: control characters, ANSI escape sequences that
+        recolor or rewrite a terminal, line breaks that forge extra log lines, and byte sequences that are not UTF-8.
+        The scan for such bytes runs 32 (AVX2) or 16 (SSE2) bytes at a time, selected once at startup, with a scalar
+        loop elsewhere; only the bytes it stops at are looked at one by one, so clean text is copied in bulk. Where the
+        scan stops at a multibyte UTF-8 sequence, the text from there is validated 32 bytes at a time with AVX2 and
+        copied through up to the first block holding invalid UTF-8 or a byte to escape; from that block on, sequences
+        are validated one at a time until the scan takes over again.
+
+        - escape_json writes the body of a JSON string: '"' and '\\' escaped, control bytes as \n, \t, ... or \u00XX,
+          invalid UTF-8 as \ufffd; always used by Layout::json and for quoted Layout::logfmt values
+        - escape_text writes control bytes (other than tab) and invalid UTF-8 as \xHH, leaving everything else; used
+          for the message text of sinks made with Config::sanitize
+    */
+    namespace detail {
+        // Index of the first byte of `s` that is a control byte, DEL or non-ASCII, or (for JSON) '"' or '\\'; s.size()
+        // if there is none
+        size_t scan_special(std::string_view s, bool json);
+
+        // The portable loop behind scan_special, for comparison
+        size_t scan_special_scalar(std::string_view s, bool json);
+
+        // Name of the scan_special implementation in use: "avx2", "sse2" or "scalar"
+        std::string_view escape_kernel();
+
+        // Length of the longest prefix of `s` that is valid UTF-8 without a byte scan_special stops at other than
+        // non-ASCII, as far as the kernel in use can tell: it may stop short of the scalar loop, but only at the
+        // start of a sequence
+        size_t scan_utf8(std::string_view s, bool json);
+
+        // The portable loop behind scan_utf8, for comparison
+        size_t scan_utf8_scalar(std::string_view s, bool json);
+
+        // Length of the valid UTF-8 sequence starting at s[0], or 0 if it is not one
+        size_t utf8_sequence(std::string_view s);
+
+        void escape_json(std::string_view s, spdlog::memory_buf_t& out);
+
+        void escape_text(std::string_view s, spdlog::memory_buf_t& out);
+
+        // Sanitizes the message text before handing the message to the formatter it wraps
+        class sanitizing_formatter final : public spdlog::formatter {
+            std::unique_ptr<spdlog::formatter> inner;
+
+          public:
+            explicit sanitizing_formatter(std::unique_ptr<spdlog::formatter> inner) : inner{std::move(inner)} {}
+
+            void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override;
+
+            std::unique_ptr<spdlog::formatter> clone() const override {
+                return std::make_unique<sanitizing_formatter>(inner->clone());
+            }
+        };
+    }  // namespace detail
+}  // namespace un::log
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "clock.hpp"
+#include "format.hpp"
+#include "record.hpp"
+
+#include <cstring>
+
+namespace un::log {
+    /*  Structured fields
+
+        kv("status", 200) tags a value with a key; passing fields to a level functor logs them alongside the message:
+
+            unlog::info("request {} done", id, kv("status", 200), kv("dur_us", elapsed));
+
+        The message text is formatted from the format string and the other arguments as usual, then text and fields
+        are captured on the calling thread into a record that travels as the message payload, delivered as a fields
+        record (see record.hpp), without building any strings:
+
+            [ fields_header | text | field 0 | field 1 | ... ]
+            field:  u8 key size | key | u8 type | value
+            value:  'b' u8 | 'l' i64 | 'L' u64 | 'd' double | 's' u32 size + bytes
+
+        Integers, floating point and bool keep their type; strings, and any other type fmt can format, are stored as
+        text. Sinks with Layout::json or Layout::logfmt write the fields as typed keys; every other sink gets the text
+        followed by the fields as key=value pairs. Keys are cut to 255 bytes; JSON escapes them, logfmt replaces the
+        bytes a key cannot hold with '_'. A field refers to its value, so it is meant to be made in the logging statement
+        itself.
+    */
+    template <typename T>
+    struct field {
+        std::string_view key;
+        T value;
+    };
+
+    template <typename T>
+    inline constexpr bool is_field_v = false;
+
+    template <typename T>
+    inline constexpr bool is_field_v<field<T>> = true;
+
+    template <typename T>
+    concept field_type = is_field_v<std::remove_cvref_t<T>>;
+
+    namespace detail {
+        // Arithmetic values are copied, strings viewed, and anything else referred to until the message is captured
+        template <typename T, typename U = std::remove_cvref_t<T>>
+        using field_value_t = std::conditional_t<
+                std::is_arithmetic_v<U>,
+                U,
+                std::conditional_t<std::convertible_to<const U&, std::string_view>, std::string_view, const U&>>;
+    }  // namespace detail
+
+    template <typename T>
+    constexpr auto kv(std::string_view key, const T& value) {
+        return field<detail::field_value_t<T>>{key, value};
+    }
+
+    namespace detail {
+        struct fields_header {
+            uint32_t text_size;
+            uint32_t count;
+        };
+
+        struct field_view {
+            std::string_view key;
+            char type;
+            bool b{false};
+            int64_t l{0};
+            uint64_t u{0};
+            double d{0};
+            std::string_view s{};
+        };
+
+        // A fields record read back from a payload; views into it
+        struct fields_view {
+            std::string_view text;
+            std::string_view data;
+            uint32_t count{0};
+
+            // Calls `fn` with each field; returns false, having stopped, at a field that does not fit in the record
+            template <typename F>
+            bool each(F&& fn) const;
+        };
+
+        // Reads `payload` as a fields record, checking every field against its bounds; returns false if it is not a
+        // well-formed one
+        bool read_fields(spdlog::string_view_t payload, fields_view& out);
+
+        template <typename T>
+        void put_field(spdlog::memory_buf_t& buf, T val) {
+            buf.append(reinterpret_cast<const char*>(&val), reinterpret_cast<const char*>(&val) + sizeof(T));
+        }
+
+        inline void put_field_text(spdlog::memory_buf_t& buf, std::string_view s) {
+            put_field(buf, 's');
+            put_field(buf, static_cast<uint32_t>(s.size()));
+            buf.append(s.data(), s.data() + s.size());
+        }
+
+        template <typename T>
+        void write_field(spdlog::memory_buf_t&, const T&, uint32_t&) {}
+
+        template <typename T>
+        void write_field(spdlog::memory_buf_t& buf, const field<T>& f, uint32_t& count) {
+            using U = std::remove_cvref_t<T>;
+            auto key = f.key.substr(0, 255);
+            put_field(buf, static_cast<uint8_t>(key.size()));
+            buf.append(key.data(), key.data() + key.size());
+
+            if constexpr (std::same_as<U, bool>) {
+                put_field(buf, 'b');
+                put_field(buf, static_cast<uint8_t>(f.value));
+            }
+            else if constexpr (std::same_as<U, char>)
+                put_field_text(buf, {&f.value, 1});
+            else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+                put_field(buf, 'l');
+                put_field(buf, static_cast<int64_t>(f.value));
+            }
+            else if constexpr (std::is_integral_v<U>) {
+                put_field(buf, 'L');
+                put_field(buf, static_cast<uint64_t>(f.value));
+            }
+            else if constexpr (std::is_floating_point_v<U>) {
+                put_field(buf, 'd');
+                put_field(buf, static_cast<double>(f.value));
+            }
+            else if constexpr (std::same_as<U, std::string_view>)
+                put_field_text(buf, f.value);
+            else {
+                // formatted straight into the record, then the size is patched in
+                put_field(buf, 's');
+                auto at = buf.size();
+                put_field(buf, uint32_t{0});
+                fmt::format_to(fmt::appender(buf), "{}", f.value);
+                auto size = static_cast<uint32_t>(buf.size() - at - sizeof(uint32_t));
+                std::memcpy(buf.data() + at, &size, sizeof(size));
+            }
+            ++count;
+        }
+
+        template <typename... Arg>
+        void log_fields(
+                spdlog::logger& logger,
+                spdlog::source_loc loc,
+                spdlog::level::level_enum level,
+                std::string_view suffix,
+                fmt::string_view fmt,
+                const Arg&... args) {
+            spdlog::memory_buf_t buf;
+            fields_header header{0, 0};
+            buf.append(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+            fmt::vformat_to(fmt::appender(buf), fmt, fmt::make_format_args(args...));
+            buf.append(suffix.data(), suffix.data() + suffix.size());
+            header.text_size = static_cast<uint32_t>(buf.size() - sizeof(header));
+            (write_field(buf, args, header.count), ...);
+            std::memcpy(buf.data(), &header, sizeof(header));
+            log_record(logger, now(), loc, level, spdlog::string_view_t{buf.data(), buf.size()}, record_kind::fields);
+        }
+
+        template <typename F>
+        bool fields_view::each(F&& fn) const {
+            auto rest = data;
+            auto take = [&rest](void* out, size_t n) {
+                if (rest.size() < n)
+                    return false;
+                std::memcpy(out, rest.data(), n);
+                rest.remove_prefix(n);
+                return true;
+            };
+            auto take_text = [&rest](std::string_view& out, size_t n) {
+                if (rest.size() < n)
+                    return false;
+                out = rest.substr(0, n);
+                rest.remove_prefix(n);
+                return true;
+            };
+            for (uint32_t i = 0; i < count; ++i) {
+                field_view f;
+                uint8_t key_size;
+                if (not take(&key_size, sizeof(key_size)) or not take_text(f.key, key_size) or
+                    not take(&f.type, sizeof(f.type)))
+                    return false;
+                bool complete;
+                switch (f.type) {
+                    case 'b': {
+                        uint8_t b{0};
+                        complete = take(&b, sizeof(b));
+                        f.b = b != 0;
+                        break;
+                    }
+                    case 'l':
+                        complete = take(&f.l, sizeof(f.l));
+                        break;
+                    case 'L':
+                        complete = take(&f.u, sizeof(f.u));
+                        break;
+                    case 'd':
+                        complete = take(&f.d, sizeof(f.d));
+                        break;
+                    case 's': {
+                        uint32_t size;
+                        complete = take(&size, sizeof(size)) and take_text(f.s, size);
+                        break;
+                    }
+                    default:
+                        complete = false;
+                }
+                if (not complete)
+                    return false;
+                fn(f);
+            }
+            return true;
+        }
+
+        // Text for sinks without a structured layout: the message followed by " key=value" for each field
+        void render_fields(const fields_view& fields, spdlog::memory_buf_t& out);
+
+        // Appends a logfmt value, quoted and escaped where needed
+        void append_logfmt(std::string_view s, spdlog::memory_buf_t& out);
+
+        // Appends a logfmt key: logfmt has no quoting for keys, so each byte that would end or break one (space,
+        // control bytes, '=', '"', invalid UTF-8) is written as '_', and an empty key as "_"
+        void append_logfmt_key(std::string_view s, spdlog::memory_buf_t& out);
+
+        // Appends a JSON string, quoted and escaped
+        void append_json(std::string_view s, spdlog::memory_buf_t& out);
+
+        // Set by the master sink while it hands the rendered text of a fields record to its sinks, so structured
+        // formatters can find the fields behind the text on the same thread
+        class fields_scope {
+            bool active{false};
+
+          public:
+            fields_scope() = default;
+            ~fields_scope();
+
+            fields_scope(const fields_scope&) = delete;
+            fields_scope& operator=(const fields_scope&) = delete;
+
+            // `text` is the rendered payload the sinks are given for `payload`, a record of `kind`
+            void set(record_kind kind, spdlog::string_view_t payload, spdlog::string_view_t text);
+        };
+
+        // The fields behind `msg` if a fields record is being delivered as `msg` on this thread
+        const fields_view* delivered_fields(const spdlog::details::log_msg& msg);
+
+        // Common part of the structured formatters: caches the "YYYY-MM-DDTHH:MM:SS" prefix per second
+        class structured_formatter : public spdlog::formatter {
+            int64_t cached_second{std::numeric_limits<int64_t>::min()};
+            std::array<char, 24> prefix{};
+            size_t prefix_size{0};
+
+          protected:
+            void append_time(spdlog::log_clock::time_point time, spdlog::memory_buf_t& dest);
+        };
+    }  // namespace detail
+
+    // One JSON object per line: time (RFC 3339, UTC), level, logger, source, msg, then the fields
+    class json_formatter final : public detail::structured_formatter {
+      public:
+        void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override;
+        std::unique_ptr<spdlog::formatter> clone() const override { return std::make_unique<json_formatter>(); }
+    };
+
+    // One logfmt line per message: time=... level=... logger=... source=... msg=... then the fields
+    class logfmt_formatter final : public detail::structured_formatter {
+      public:
+        void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override;
+        std::unique_ptr<spdlog::formatter> clone() const override { return std::make_unique<logfmt_formatter>(); }
+    };
+}  // namespace un::log
+
+namespace fmt {
+    // A field formatted in the message text itself: key=value
+    template <typename T>
+    struct formatter<un::log::field<T>, char> {
+        constexpr auto parse(format_parse_context& ctx) { return ctx.begin(); }
+
+        template <typename FormatContext>
+        auto format(const un::log::field<T>& f, FormatContext& ctx) const {
+            return fmt::format_to(ctx.out(), "{}={}", f.key, f.value);
+        }
+    };
+}  // namespace fmt
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace un::log {
+
+    /*  Memory-mapped file sink (FileBackend::mmap)
+
+        The file is grown with fallocate one chunk at a time and the current chunk is mapped MAP_SHARED, so writing a
+        message is a memcpy into the page cache; there is no write syscall and no stdio buffer. Pages dirtied through
+        the mapping belong to the file, so everything written survives the process being killed: the kernel writes it
+        back as usual. MmapPolicy::sync controls what a flush adds on top of that (msync), and drop_behind releases
+        finished chunks from the page cache.
+
+        The preallocated tail of the last chunk reads as NUL bytes until the sink is closed, which trims the file to
+        the bytes written. A sink reopening a file left untrimmed by a crash resumes after the last non-NUL byte.
+    */
+    template <typename Mutex>
+    class mmap_file_sink final : public spdlog::sinks::base_sink<Mutex> {
+        int fd{-1};
+        MmapPolicy policy;
+        char* chunk{nullptr};
+        size_t chunk_offset{0};
+        size_t position{0};
+        size_t synced{0};
+        spdlog::memory_buf_t formatted;
+
+        void map_chunk(size_t offset);
+        void unmap_chunk(bool finished);
+        void sync_range(size_t from, size_t to, int flags);
+        void write(const char* data, size_t size);
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override;
+
+      public:
+        explicit mmap_file_sink(const fs::path& filename, MmapPolicy policy = {});
+        ~mmap_file_sink() override;
+
+        mmap_file_sink(const mmap_file_sink&) = delete;
+        mmap_file_sink& operator=(const mmap_file_sink&) = delete;
+
+        // Bytes of log data in the file
+        size_t size() const { return chunk_offset + position; }
+    };
+
+    using mmap_file_sink_mt = mmap_file_sink<std::mutex>;
+    using mmap_file_sink_st = mmap_file_sink<spdlog::details::null_mutex>;
+
+    extern template class mmap_file_sink<std::mutex>;
+    extern template class mmap_file_sink<spdlog::details::null_mutex>;
+
+    namespace detail {
+        class uring;
+    }
+
+    struct batch_stats {
+        uint64_t batches{0};
+        uint64_t messages{0};
+        uint64_t bytes{0};
+        uint64_t largest_batch{0};
+        uint64_t write_errors{0};
+        bool uring{false};
+
+        double average_batch() const { return batches ? static_cast<double>(bytes) / batches : 0.0; }
+    };
+
+    /*  Batched file sink (FileBackend::uring)
+
+        Producers format messages straight into large in-memory buffers and hand full ones to a dedicated writer
+        thread; they never make a write syscall. The writer gathers every queued buffer into one vectored write,
+        submitted through io_uring (set up with raw syscalls, no liburing) or, where the kernel or a seccomp policy
+        refuses io_uring, with pwritev. A partly filled buffer is picked up every BatchPolicy::interval, and flush()
+        waits until everything logged before it has been written.
+
+        Only one write is in flight at a time: batching, not queue depth, is what saves the syscalls here. stats()
+        reports the batch sizes achieved.
+    */
+    template <typename Mutex>
+    class batched_file_sink final : public spdlog::sinks::base_sink<Mutex> {
+        struct buffer {
+            spdlog::memory_buf_t data;
+            uint64_t messages{0};
+        };
+        using buffer_ptr = std::unique_ptr<buffer>;
+
+        int fd{-1};
+        BatchPolicy policy;
+        spdlog::memory_buf_t formatted;
+
+        // shared with the writer, guarded by queue_mutex
+        std::mutex queue_mutex;
+        std::condition_variable writer_cv;
+        std::condition_variable producer_cv;
+        buffer_ptr current;
+        std::deque<buffer_ptr> full;
+        std::vector<buffer_ptr> spare;
+        uint64_t flush_requested{0};
+        uint64_t flush_completed{0};
+        bool stopping{false};
+        batch_stats totals;
+
+        // writer thread only
+        std::unique_ptr<detail::uring> ring;
+        size_t offset{0};
+        uint64_t write_errors{0};
+        std::thread writer;
+
+        buffer_ptr fresh_buffer();
+        void hand_off(std::unique_lock<std::mutex>& lock);
+        void run();
+        size_t write_batch(const std::vector<buffer_ptr>& batch);
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override;
+
+      public:
+        explicit batched_file_sink(const fs::path& filename, BatchPolicy policy = {});
+        ~batched_file_sink() override;
+
+        batched_file_sink(const batched_file_sink&) = delete;
+        batched_file_sink& operator=(const batched_file_sink&) = delete;
+
+        batch_stats stats();
+    };
+
+    using batched_file_sink_mt = batched_file_sink<std::mutex>;
+    using batched_file_sink_st = batched_file_sink<spdlog::details::null_mutex>;
+
+    extern template class batched_file_sink<std::mutex>;
+    extern template class batched_file_sink<spdlog::details::null_mutex>;
+
+    /*  Rotating file sink (Config::rotation)
+
+        Rotation never makes the logging thread wait on the filesystem. A worker thread keeps the next file open ahead
+        of time under a hidden name next to the live one; rotating is then only a swap to that descriptor. The worker
+        takes it from there: it renames the old file to its archive name and the new one into place, opens the next
+        spare, then gzips the archive and prunes old ones. Messages written between the swap and the renames land in
+        the new file under its temporary name, so no line is lost or duplicated (unlike copytruncate). If the worker
+        has not got the next file ready yet, the sink keeps writing to the current one and retries on the next message.
+
+        Writes go through a small buffer flushed by flush() or when it fills, like the stdio file sink.
+    */
+    template <typename Mutex>
+    class rotating_file_sink final : public spdlog::sinks::base_sink<Mutex> {
+        fs::path live;
+        fs::path spare_path;
+        RotationPolicy policy;
+
+        // producer side, guarded by the base_sink mutex
+        int fd{-1};
+        size_t written{0};
+        spdlog::log_clock::time_point next_rotation{spdlog::log_clock::time_point::max()};
+        spdlog::memory_buf_t formatted;
+        spdlog::memory_buf_t pending;
+
+        // shared with the worker, guarded by rotation_mutex
+        std::mutex rotation_mutex;
+        std::condition_variable worker_cv;
+        int spare_fd{-1};
+        int retired_fd{-1};
+        bool stopping{false};
+
+        // worker thread only
+        uint64_t sequence{0};
+        std::thread worker;
+
+        void write_pending();
+        bool rotate();
+        void run();
+        fs::path archive_path(uint64_t n) const;
+        void archive(const fs::path& file);
+        void prune();
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override;
+
+      public:
+        // Throws std::invalid_argument if compression is requested and unlog was built without zlib
+        rotating_file_sink(const fs::path& filename, RotationPolicy policy);
+        ~rotating_file_sink() override;
+
+        rotating_file_sink(const rotating_file_sink&) = delete;
+        rotating_file_sink& operator=(const rotating_file_sink&) = delete;
+    };
+
+    using rotating_file_sink_mt = rotating_file_sink<std::mutex>;
+    using rotating_file_sink_st = rotating_file_sink<spdlog::details::null_mutex>;
+
+    extern template class rotating_file_sink<std::mutex>;
+    extern template class rotating_file_sink<spdlog::details::null_mutex>;
+
+}  // namespace un::log
@@ -10,15 +10,6 @@
 namespace un::log {
     using namespace std::literals;
 
-    inline const auto DEFAULT_PATTERN = "[%H:%M:%S.%e] [%*] [%n:%l|%g:%#] >> %v"s;
-    inline const auto DEFAULT_PATTERN_COLOR = "[%H:%M:%S.%e] [%*] [%n:%^%l%$|%g:%#] >> %v"s;
-
-    // Types can opt-in to being fmt-formattable by ensuring they have a ::to_string() method defined
-    template <typename T>
-    concept to_string_formattable = T::to_string_formattable && requires(T a) {
-        { a.to_string() } -> std::convertible_to<std::string_view>;
-    };
-
     namespace detail {
         template <size_t N>
         struct string_literal {
@@ -28,6 +19,25 @@ namespace un::log {
             consteval std::string_view sv() const { return {str.data(), N - 1}; }
         };
 
+        // The default patterns as literals, so they can be compiled (see pattern.hpp)
+        inline constexpr string_literal default_pattern{"[%H:%M:%S.%e] [%*] [%n:%l|%g:%#] >> %v"};
+        inline constexpr string_literal default_pattern_color{"[%H:%M:%S.%e] [%*] [%n:%^%l%$|%g:%#] >> %v"};
+    }  // namespace detail
+
+    inline const auto DEFAULT_PATTERN = std::string{detail::default_pattern.sv()};
+    inline const auto DEFAULT_PATTERN_COLOR = std::string{detail::default_pattern_color.sv()};
+
+    // Types can opt-in to being fmt-formattable by ensuring they have a ::to_string() method defined, or a
+    // ::format_to(fmt::appender) method returning the advanced iterator, which is preferred as it writes straight into
+    // the output without building a string first
+    template <typename T>
+    concept to_string_formattable = T::to_string_formattable && (requires(const T a) {
+        { a.to_string() } -> std::convertible_to<std::string_view>;
+    } || requires(const T a, fmt::appender out) {
+        { a.format_to(out) } -> std::same_as<fmt::appender>;
+    });
+
+    namespace detail {
         template <string_literal Format>
         struct fmt_wrapper {
             consteval fmt_wrapper() = default;
@@ -40,6 +50,108 @@ namespace un::log {
                 return fmt::format(Format.sv(), std::forward<T>(args)...);
             }
         };
+
+        template <typename Out>
+        concept fmt_buffer = std::constructible_from<fmt::appender, Out&>;
+
+        template <string_literal Format>
+        struct fmt_to_wrapper {
+            consteval fmt_to_wrapper() = default;
+
+            /// Appends the formatted values to `out`, either a fmt buffer (such as fmt::memory_buffer or
+            /// spdlog::memory_buf_t) or an output iterator, and returns the iterator past the output ("..."_format_to).
+            template <typename Out, typename... T>
+            constexpr auto operator()(Out&& out, T&&... args) && {
+                if constexpr (fmt_buffer<Out>)
+                    return fmt::format_to(fmt::appender{out}, Format.sv(), std::forward<T>(args)...);
+                else
+                    return fmt::format_to(std::forward<Out>(out), Format.sv(), std::forward<T>(args)...);
+            }
+        };
+
+        // This thread's buffer behind "..."_format_view; kept between calls so it stops allocating once grown
+        fmt::memory_buffer& scratch_buffer();
+
+        template <string_literal Format>
+        struct fmt_view_wrapper {
+            consteval fmt_view_wrapper() = default;
+
+            /// Formats into the thread's scratch buffer and returns a view of the (null-terminated) result, valid until
+            /// the next "..."_format_view on the same thread; a view from it must not be one of the arguments.
+            template <typename... T>
+            std::string_view operator()(T&&... args) && {
+                auto& buf = scratch_buffer();
+                buf.clear();
+                fmt::format_to(fmt::appender{buf}, Format.sv(), std::forward<T>(args)...);
+                buf.push_back('\0');
+                return {buf.data(), buf.size() - 1};
+            }
+        };
+
+        /*  Byte spans (uspan, bspan) render as text through a format spec of a mode and an optional byte limit:
+
+                {}, {:x}    0a1bff              lowercase hex
+                {:X}        0A1BFF              uppercase hex
+                {:b64}      Chv/                base64 (RFC 4648, padded)
+                {:dump}     hexdump -C style lines of offset, hex and ASCII columns, each starting with a newline
+                {:x.64}     at most the first 64 bytes, followed by "...(+N bytes)" for the rest
+
+            Bytes are encoded a chunk at a time into a stack buffer and written to the output in one piece; hex is
+            converted 16 bytes at a time with SSE2 where available and base64 through a table of character pairs.
+        */
+        enum class bytes_mode : char { hex = 'x', upper_hex = 'X', base64 = 'b', dump = 'd' };
+
+        // Input bytes per encode_bytes call: whole base64 groups (3) and whole dump lines (16)
+        inline constexpr size_t BYTES_CHUNK{192};
+
+        // Room for the encoding of one chunk; dump lines are the longest at up to 87 chars per 16 bytes
+        inline constexpr size_t BYTES_CHUNK_OUT{1056};
+
+        // Encodes data[0, size), with size <= BYTES_CHUNK, into `out` and returns the number of chars written. `offset`
+        // is the position of data[0] in the whole span, printed by dump lines.
+        size_t encode_bytes(bytes_mode mode, const unsigned char* data, size_t size, size_t offset, char* out);
+
+        struct bytes_formatter {
+            bytes_mode mode{bytes_mode::hex};
+            size_t limit{std::numeric_limits<size_t>::max()};
+
+            constexpr auto parse(fmt::format_parse_context& ctx) {
+                auto it = ctx.begin(), end = ctx.end();
+                std::string_view spec{it, static_cast<size_t>(end - it)};
+
+                if (spec.starts_with("b64"))
+                    mode = bytes_mode::base64, it += 3;
+                else if (spec.starts_with("dump"))
+                    mode = bytes_mode::dump, it += 4;
+                else if (spec.starts_with('x') or spec.starts_with('X'))
+                    mode = static_cast<bytes_mode>(*it++);
+
+                if (it != end and *it == '.') {
+                    if (++it == end or *it < '0' or *it > '9')
+                        throw fmt::format_error{"Byte span limit needs digits"};
+                    for (limit = 0; it != end and *it >= '0' and *it <= '9'; ++it)
+                        limit = limit * 10 + static_cast<size_t>(*it - '0');
+                }
+
+                if (it != end and *it != '}')
+                    throw fmt::format_error{"Invalid byte span format; expected x, X, b64 or dump and a .limit"};
+                return it;
+            }
+
+            template <typename FormatContext>
+            auto format(const unsigned char* data, size_t size, FormatContext& ctx) const {
+                auto out = ctx.out();
+                auto shown = std::min(size, limit);
+                std::array<char, BYTES_CHUNK_OUT> buf;
+                for (size_t at = 0; at < shown; at += BYTES_CHUNK) {
+                    auto n = encode_bytes(mode, data + at, std::min(BYTES_CHUNK, shown - at), at, buf.data());
+                    out = fmt::format_to(out, "{}", std::string_view{buf.data(), n});
+                }
+                if (shown < size)
+                    out = fmt::format_to(out, "{}...(+{} bytes)", mode == bytes_mode::dump ? "\n" : "", size - shown);
+                return out;
+            }
+        };
     }  //  namespace detail
 
     namespace literals {
@@ -48,6 +160,16 @@ namespace un::log {
             return detail::fmt_wrapper<Format>{};
         }
 
+        template <detail::string_literal Format>
+        inline consteval auto operator""_format_to() {
+            return detail::fmt_to_wrapper<Format>{};
+        }
+
+        template <detail::string_literal Format>
+        inline consteval auto operator""_format_view() {
+            return detail::fmt_view_wrapper<Format>{};
+        }
+
     }  // namespace literals
 
 }  // namespace un::log
@@ -55,9 +177,28 @@ namespace un::log {
 namespace fmt {
     template <un::log::to_string_formattable T>
     struct formatter<T, char> : formatter<std::string_view> {
+        bool plain{true};
+
+        template <typename ParseContext>
+        constexpr auto parse(ParseContext& ctx) {
+            plain = ctx.begin() == ctx.end() || *ctx.begin() == '}';
+            return formatter<std::string_view>::parse(ctx);
+        }
+
         template <typename FormatContext>
         auto format(const T& val, FormatContext& ctx) const {
-            return formatter<std::string_view>::format(val.to_string(), ctx);
+            // width and alignment need the length up front, so only a plain {} writes straight into the output
+            if constexpr (requires { val.format_to(ctx.out()); })
+                if (plain)
+                    return val.format_to(ctx.out());
+
+            if constexpr (requires(fmt::appender out) { val.format_to(out); }) {
+                fmt::memory_buffer buf;
+                val.format_to(fmt::appender{buf});
+                return formatter<std::string_view>::format(std::string_view{buf.data(), buf.size()}, ctx);
+            }
+            else
+                return formatter<std::string_view>::format(val.to_string(), ctx);
         }
     };
 
@@ -71,20 +212,18 @@ namespace fmt {
     };
 
     template <>
-    struct formatter<un::log::uspan, unsigned char> : formatter<std::string_view> {
+    struct formatter<un::log::uspan, char> : un::log::detail::bytes_formatter {
         template <typename FormatContext>
         auto format(const un::log::uspan& val, FormatContext& ctx) const {
-            return formatter<std::string_view>::format(
-                    std::string_view{reinterpret_cast<const char*>(val.data()), val.size()}, ctx);
+            return bytes_formatter::format(val.data(), val.size(), ctx);
         }
     };
 
     template <>
-    struct formatter<un::log::bspan, std::byte> : formatter<std::string_view> {
+    struct formatter<un::log::bspan, char> : un::log::detail::bytes_formatter {
         template <typename FormatContext>
         auto format(const un::log::bspan& val, FormatContext& ctx) const {
-            return formatter<std::string_view>::format(
-                    std::string_view{reinterpret_cast<const char*>(val.data()), val.size()}, ctx);
+            return bytes_formatter::format(reinterpret_cast<const unsigned char*>(val.data()), val.size(), ctx);
         }
     };
 }  // namespace fmt
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "logger.hpp"
+
+#include <random>
+
+namespace un::log::detail {
+    /*  Per-call-site rate limiting
+
+        The *_every, *_per_sec and *_sampled functors keep their state in a slot indexed by the call-site ID, so every
+        logging statement is limited on its own and the check is one or two relaxed atomic operations on its slot.
+        Call sites the registry could not take (runtime format strings, a full table) get a slot in a smaller table
+        keyed by their location instead; a call site that finds no free slot there either is not limited at all. The
+        first message a call site lets through after suppressing some reports how many: "... [N suppressed]". That
+        message is formatted on the calling thread even for a deferred logger, but otherwise takes the same path as
+        any other: its fields are kept and the flight recorder sees it.
+
+        Only messages the logger would accept count: a limited call site below the logger's level is not suppressed,
+        it is simply disabled, though the flight recorder still keeps every one of its messages, as for any other call
+        site.
+    */
+    struct limit_state {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> suppressed{0};
+    };
+
+    extern std::array<limit_state, callsite_registry::CAPACITY> limits;
+
+    // Slots of the call sites without an ID, keyed by limit_key; claimed on first use and never given back
+    class limit_table {
+      public:
+        static constexpr size_t CAPACITY{1024};
+
+      private:
+        static constexpr size_t MASK{CAPACITY - 1};
+        static constexpr size_t MAX_PROBE{16};
+
+        std::array<std::atomic<uint64_t>, CAPACITY> keys{};
+        std::array<limit_state, CAPACITY> states{};
+
+      public:
+        // The slot of `key`, claiming one if it has none; null when every slot it could take belongs to another key
+        limit_state* find(uint64_t key) {
+            auto i = key & MASK;
+            for (size_t probe = 0; probe < MAX_PROBE; ++probe, i = (i + 1) & MASK) {
+                auto k = keys[i].load(std::memory_order_relaxed);
+                if (k == 0 and keys[i].compare_exchange_strong(k, key, std::memory_order_relaxed))
+                    return &states[i];
+                if (k == key)
+                    return &states[i];
+            }
+            return nullptr;
+        }
+    };
+
+    extern limit_table overflow_limits;
+
+    // The registry's key, or for a runtime format string (key 0) 64-bit FNV-1a over the file, function, line and
+    // argument types; never 0
+    inline uint64_t limit_key(const callsite& site) {
+        if (site.key != 0)
+            return site.key;
+        uint64_t hash{0xcbf2'9ce4'8422'2325};
+        auto mix = [&hash](uint8_t byte) {
+            hash ^= byte;
+            hash *= 0x100'0000'01b3;
+        };
+        for (auto part : {site.file, site.function, site.types})
+            for (char c : part)
+                mix(static_cast<uint8_t>(c));
+        for (int i = 0; i < 4; ++i)
+            mix(static_cast<uint8_t>(site.line >> (8 * i)));
+        return hash ? hash : 1;
+    }
+
+    // State of call site `site` with registry ID `id`; null if it cannot have any, in which case it is not limited
+    inline limit_state* limit_slot(const callsite& site, callsite_id id) {
+        if (id < callsite_registry::CAPACITY)
+            return &limits[id];
+        return overflow_limits.find(limit_key(site));
+    }
+
+    // Admits the first of every n messages; count is the number of calls so far
+    struct every_n {
+        uint64_t n;
+
+        constexpr every_n(uint64_t _n) : n{_n} {}
+
+        bool admit(limit_state& state, uint64_t& suppressed) const {
+            auto seen = state.count.fetch_add(1, std::memory_order_relaxed);
+            if (n > 1 and seen % n != 0)
+                return false;
+            suppressed = seen == 0 || n <= 1 ? 0 : n - 1;
+            return true;
+        }
+    };
+
+    // Generic cell rate algorithm: a burst of up to `rate` messages, then `rate` per second. count holds the
+    // theoretical arrival time of the next message (ns); a message may arrive up to one second ahead of it. Times are
+    // taken from the steady clock, not the message clock: a wall clock stepped back would otherwise leave the arrival
+    // time in the future and silence the call site until the clock caught up.
+    struct per_second {
+        // below this the interval between messages would not fit in 64 bits of nanoseconds
+        static constexpr double MIN_RATE{1e-9};
+
+        double rate;
+
+        constexpr per_second(double _rate) : rate{_rate} {}
+
+        bool admit(limit_state& state, uint64_t& suppressed) const {
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch());
+            return admit(state, suppressed, static_cast<uint64_t>(now.count()));
+        }
+
+        // As above, at steady clock time `now` (ns)
+        bool admit(limit_state& state, uint64_t& suppressed, uint64_t now) const {
+            constexpr uint64_t SECOND{1'000'000'000};
+            if (not(rate > 0)) {
+                state.suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            auto interval = static_cast<uint64_t>(SECOND / std::max(rate, MIN_RATE));
+            auto burst = std::max(SECOND, interval);
+
+            auto tat = state.count.load(std::memory_order_relaxed);
+            uint64_t next;
+            do {
+                next = std::max(tat, now) + interval;
+                if (next - now > burst) {
+                    state.suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (not state.count.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+
+            suppressed = state.suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    // Admits each message with probability p, from a per-thread xorshift generator
+    struct sampled {
+        double p;
+
+        constexpr sampled(double _p) : p{_p} {}
+
+        static double random_unit() {
+            thread_local uint64_t x = (uint64_t{std::random_device{}()} << 32) | std::random_device{}() | 1;
+            x ^= x >> 12;
+            x ^= x << 25;
+            x ^= x >> 27;
+            return static_cast<double>((x * 0x2545'f491'4f6c'dd1d) >> 11) * 0x1.0p-53;
+        }
+
+        bool admit(limit_state& state, uint64_t& suppressed) const {
+            if (random_unit() >= p) {
+                state.suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            suppressed = state.suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    template <typename Policy, typename... Arg>
+    void dispatch_limited(
+            const logger_ptr& logger,
+            LogLevel level,
+            const Policy& policy,
+            const site_string<Arg...>& fmt,
+            Arg&&... args) {
+        auto enabled = logger->should_log(level);
+        auto recorded = recorder.accepts(level);
+        if (not(enabled or recorded))
+            return;
+
+        auto id = callsites.intern(fmt.site, level, renderer<Arg...>());
+        uint64_t suppressed = 0;
+        if (not enabled)
+            return recorder.record<Arg...>(*logger, level, id, fmt, args...);
+        if (auto* slot = limit_slot(fmt.site, id); slot and not policy.admit(*slot, suppressed))
+            return;
+        if (recorded)
+            recorder.record<Arg...>(*logger, level, id, fmt, args...);
+        if (suppressed == 0)
+            return emit(logger, level, id, {}, fmt, std::forward<Arg>(args)...);
+
+        char suffix[48];
+        auto end = fmt::format_to_n(suffix, sizeof(suffix), " [{} suppressed]", suppressed).out;
+        emit(logger, level, id, std::string_view{suffix, end}, fmt, std::forward<Arg>(args)...);
+    }
+
+    // Shared body of the rate-limited functors in unlog.hpp, which differ only in level and policy
+    template <LogLevel L, typename Policy, typename... Arg>
+    struct limited {
+        limited([[maybe_unused]] const logger_ptr& logger,
+                [[maybe_unused]] Policy policy,
+                [[maybe_unused]] site_string<Arg...> fmt,
+                [[maybe_unused]] Arg&&... args) {
+            if constexpr (level_active(L)) {
+                if (level_enabled(L) && logger)
+                    dispatch_limited(logger, L, policy, fmt, std::forward<Arg>(args)...);
+            }
+        }
+
+        limited([[maybe_unused]] Policy policy, [[maybe_unused]] site_string<Arg...> fmt, [[maybe_unused]] Arg&&... args) {
+            if constexpr (level_active(L)) {
+                if (level_enabled(L))
+                    dispatch_limited(global_logger(), L, policy, fmt, std::forward<Arg>(args)...);
+            }
+        }
+    };
+}  // namespace un::log::detail
@@ -1,7 +1,15 @@
 #pragma once
 
 #include "config.hpp"
+#include "deferred.hpp"
+#include "fields.hpp"
 #include "format.hpp"
+#include "recorder.hpp"
+#include "sinks.hpp"
+#include "spsc.hpp"
+#include "stats.hpp"
+
+#include <spdlog/sinks/base_sink.h>
 
 namespace un::log {
 
@@ -11,6 +19,10 @@ namespace un::log {
     template <typename T>
     concept spdlog_sink_t = std::derived_from<T, spdlog::sinks::sink>;
 
+    // spdlog's _mt sinks, which take a lock of their own
+    template <typename T>
+    concept locking_sink_t = std::derived_from<T, spdlog::sinks::base_sink<std::mutex>>;
+
     struct Logger {
       private:
         std::atomic<bool> have_logger{false};
@@ -59,20 +71,89 @@ namespace un::log {
 
     // Global default logger
     const logger_ptr& global_logger();
-    // Global distribution sink multiplexer: holds a vector of sink
-    extern std::shared_ptr<spdlog::sinks::dist_sink_mt> master_sink;
+    // Global distribution sink multiplexer: holds a copy-on-write vector of sinks
+    extern std::shared_ptr<fanout_sink> master_sink;
 
     namespace detail {
+        // Lowest level accepted by any unlog logger: the default level or a level given to Logger::set_level. The
+        // level functors test it before anything else, so a disabled message costs one relaxed load and a branch.
+        // Levels set directly on an spdlog::logger bypass it; a message below it is dropped whatever that logger says.
+        // The flight recorder's level counts too.
+        extern std::atomic<LogLevel> min_level;
+
+        inline bool level_enabled(LogLevel level) {
+            return level >= min_level.load(std::memory_order_relaxed);
+        }
+
         LogLevel get_default_level();
 
         void set_default_level(LogLevel level);
 
         void make_logger(const Config& conf, bool make_default);
 
-        void add_sink(sink_ptr sink);
+        // Adds a sink with the default format; unless `threadsafe`, it is given a lock of its own (see wrap)
+        void add_sink(sink_ptr sink, bool threadsafe = false);
 
         void add_sink(const Config& conf, sink_ptr sink);
 
         void set_sinks(const Config& conf, sink_ptr sink);
+
+        // Formats on the calling thread, followed by `suffix`, stamping the message from the configured clock rather
+        // than spdlog's
+        template <typename... Arg>
+        void log_timestamped(
+                spdlog::logger& logger,
+                spdlog::source_loc loc,
+                LogLevel level,
+                std::string_view suffix,
+                fmt::format_string<Arg...> fmt,
+                Arg&&... args) {
+            spdlog::memory_buf_t buf;
+            fmt::format_to(fmt::appender(buf), fmt, std::forward<Arg>(args)...);
+            buf.append(suffix.data(), suffix.data() + suffix.size());
+            logger.log(now(), loc, level, spdlog::string_view_t{buf.data(), buf.size()});
+        }
+
+        // Messages with fields are captured into a fields record; deferred loggers capture the arguments for the
+        // backend to format; everything else formats through spdlog on the calling thread. A non-empty `suffix` is
+        // appended to the message text, which is then always formatted on the calling thread.
+        template <typename... Arg>
+        void emit(
+                const logger_ptr& logger,
+                LogLevel level,
+                [[maybe_unused]] callsite_id id,
+                std::string_view suffix,
+                const site_string<Arg...>& fmt,
+                Arg&&... args) {
+            count_logged(level);
+            if constexpr ((field_type<Arg> || ...))
+                return log_fields(*logger, fmt.site.loc(), level, suffix, fmt::string_view{fmt.fmt}, args...);
+            if constexpr ((deferrable<Arg> && ...)) {
+                if (id != NO_CALLSITE and suffix.empty() and is_deferred(logger.get())) {
+                    if ((null_string(args) or ...))
+                        return logger->log(fmt.site.loc(), level, fmt.fmt, std::forward<Arg>(args)...);
+                    return log_deferred(*logger, fmt.site.loc(), level, id, args...);
+                }
+            }
+            if (not suffix.empty() or tsc_enabled.load(std::memory_order_relaxed))
+                return log_timestamped(*logger, fmt.site.loc(), level, suffix, fmt.fmt, std::forward<Arg>(args)...);
+            logger->log(fmt.site.loc(), level, fmt.fmt, std::forward<Arg>(args)...);
+        }
+
+        // Common path for the level functors: registers the call site on first use, keeps the message in the flight
+        // recorder if it records this level, then emits it if the logger wants it
+        template <typename... Arg>
+        void dispatch(const logger_ptr& logger, LogLevel level, const site_string<Arg...>& fmt, Arg&&... args) {
+            auto enabled = logger->should_log(level);
+            auto recorded = recorder.accepts(level);
+            if (not(enabled or recorded))
+                return;
+
+            auto id = callsites.intern(fmt.site, level, renderer<Arg...>());
+            if (recorded)
+                recorder.record<Arg...>(*logger, level, id, fmt, args...);
+            if (enabled)
+                emit(logger, level, id, {}, fmt, std::forward<Arg>(args)...);
+        }
     }  // namespace detail
 }  // namespace un::log
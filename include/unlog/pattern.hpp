@@ -0,0 +1,336 @@
+#pragma once
+
+#include "format.hpp"
+
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/os.h>
+
+namespace un::log {
+
+    // Time the process started logging; the origin of the %* flag
+    spdlog::log_clock::time_point startup_time();
+
+    // Custom log formatting flag (%*) that prints the elapsed time since startup. The elapsed time is taken from the
+    // message timestamp, and the "+XhYYmZZ." prefix is cached per second so only the milliseconds are rendered for
+    // each message; nothing is allocated. Tools rendering another process' messages pass that process' start time.
+    class startup_elapsed_flag : public spdlog::custom_flag_formatter {
+        spdlog::log_clock::time_point origin;
+        int64_t cached_second{-1};
+        size_t prefix_size{0};
+        std::array<char, 32> prefix{};
+
+      public:
+        startup_elapsed_flag() : origin{startup_time()} {}
+        explicit startup_elapsed_flag(spdlog::log_clock::time_point origin) : origin{origin} {}
+
+        void format(const spdlog::details::log_msg& msg, const std::tm&, spdlog::memory_buf_t& dest) override;
+
+        std::unique_ptr<custom_flag_formatter> clone() const override {
+            return std::make_unique<startup_elapsed_flag>(origin);
+        }
+    };
+
+    /*  Compiled patterns
+
+        "..."_pattern parses a pattern at compile time into literal segments and flags, and makes a formatter that
+        writes them in sequence: literal text is copied with its size known at compile time and each flag is a direct
+        call rather than a virtual flag formatter. Date and time flags with the literals around them ("[%H:%M:%S." of
+        the default pattern) form runs that are rendered once per second and copied for each message; only the
+        sub-second digits (%e %f %F) are written per message. The default patterns are always compiled;
+        Config::compiled selects another one.
+
+        Supported flags: %Y %m %d %H %M %S %e %f %F (date, time, sub-second), %n %l %L %v (logger, level, short level,
+        message), %t %P (thread, process), %g %s %# %! (source file, its base name, line, function), %* (elapsed time,
+        see startup_elapsed_flag), %^ %$ (color range) and %%. Other flags and padding (%8l) are compile errors; use a
+        runtime Config::format for those. The output matches spdlog::pattern_formatter, in local time or, with
+        Config::utc, in UTC, which needs no timezone lookup.
+    */
+    namespace detail {
+        inline constexpr std::string_view COMPILED_FLAGS{"YmdHMSefFnlLvtPgs#!*^$"};
+
+        // Flags that only change with the second
+        inline constexpr std::string_view SECOND_FLAGS{"YmdHMS"};
+
+        // A piece of a compiled pattern: literal text at [begin, begin + size) of the pattern, or a flag. In the plan of
+        // a pattern (pattern_plan), a cached piece stands for the segments [begin, begin + size) rendered together into
+        // the cache numbered `run`.
+        struct pattern_segment {
+            char flag{0};
+            size_t begin{0};
+            size_t size{0};
+            bool cached{false};
+            size_t run{0};
+        };
+
+        template <string_literal Pattern>
+        consteval auto parse_pattern() {
+            constexpr auto text = Pattern.sv();
+            // a flag, "%%" and a literal run each make at most one segment, so twice the number of '%' + 1 bounds them
+            std::array<pattern_segment, std::ranges::count(text, '%') * 2 + 1> buf{};
+            size_t n = 0;
+
+            for (size_t i = 0; i < text.size();) {
+                if (text[i] != '%') {
+                    auto end = std::min(text.find('%', i), text.size());
+                    buf[n++] = {0, i, end - i};
+                    i = end;
+                    continue;
+                }
+                if (i + 1 == text.size())
+                    throw "Pattern ends with a lone '%'";
+                auto flag = text[i + 1];
+                if (flag == '%')
+                    buf[n++] = {0, i + 1, 1};
+                else if (COMPILED_FLAGS.contains(flag))
+                    buf[n++] = {flag, 0, 0};
+                else
+                    throw "Flag (or padding) not supported by compiled patterns";
+                i += 2;
+            }
+            return std::pair{buf, n};
+        }
+
+        template <string_literal Pattern>
+        inline constexpr auto pattern_segments = [] {
+            constexpr auto parsed = parse_pattern<Pattern>();
+            std::array<pattern_segment, parsed.second> out{};
+            std::ranges::copy_n(parsed.first.begin(), parsed.second, out.begin());
+            return out;
+        }();
+
+        // Groups each stretch of second flags and literals that holds at least one second flag into a cached piece
+        template <string_literal Pattern>
+        consteval auto plan_pattern() {
+            constexpr auto& segments = pattern_segments<Pattern>;
+            std::array<pattern_segment, segments.size()> buf{};
+            size_t n = 0, runs = 0;
+
+            for (size_t i = 0; i < segments.size();) {
+                auto j = i;
+                bool timed = false;
+                while (j < segments.size() and (segments[j].flag == 0 or SECOND_FLAGS.contains(segments[j].flag)))
+                    timed |= segments[j++].flag != 0;
+
+                if (timed) {
+                    buf[n++] = {0, i, j - i, true, runs++};
+                    i = j;
+                }
+                else
+                    do
+                        buf[n++] = segments[i++];
+                    while (i < j);
+            }
+            return std::tuple{buf, n, runs};
+        }
+
+        template <string_literal Pattern>
+        inline constexpr auto pattern_plan = [] {
+            constexpr auto planned = plan_pattern<Pattern>();
+            std::array<pattern_segment, std::get<1>(planned)> out{};
+            std::ranges::copy_n(std::get<0>(planned).begin(), std::get<1>(planned), out.begin());
+            return out;
+        }();
+
+        // Widest rendering of any cached run: a year may take up to 11 chars, the other second flags 2
+        template <string_literal Pattern>
+        consteval size_t cached_run_width() {
+            size_t widest = 0;
+            for (const auto& piece : pattern_plan<Pattern>) {
+                if (not piece.cached)
+                    continue;
+                size_t width = 0;
+                for (size_t i = piece.begin; i < piece.begin + piece.size; ++i) {
+                    const auto& s = pattern_segments<Pattern>[i];
+                    width += s.flag == 0 ? s.size : s.flag == 'Y' ? 11 : 2;
+                }
+                widest = std::max(widest, width);
+            }
+            return widest;
+        }
+
+        // The last N decimal digits of `value`, zero-padded
+        template <size_t N>
+        void append_digits(size_t value, spdlog::memory_buf_t& dest) {
+            char digits[N];
+            for (size_t i = N; i-- > 0; value /= 10)
+                digits[i] = static_cast<char>('0' + value % 10);
+            dest.append(digits, digits + N);
+        }
+
+        template <string_literal Pattern>
+        class compiled_formatter final : public spdlog::formatter {
+            static constexpr auto& segments = pattern_segments<Pattern>;
+            static constexpr auto& plan = pattern_plan<Pattern>;
+            static constexpr size_t runs = std::get<2>(plan_pattern<Pattern>());
+
+            struct cached_run {
+                std::array<char, cached_run_width<Pattern>()> text{};
+                size_t size{0};
+            };
+
+            bool utc;
+            startup_elapsed_flag elapsed;
+            int64_t cached_second{std::numeric_limits<int64_t>::min()};
+            std::array<cached_run, runs> cache{};
+
+            // Re-renders the cached runs for the second of `time`
+            void refresh(spdlog::log_clock::time_point time) {
+                auto second = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+                if (second == cached_second)
+                    return;
+                cached_second = second;
+
+                auto t = static_cast<std::time_t>(second);
+                auto tm = utc ? spdlog::details::os::gmtime(t) : spdlog::details::os::localtime(t);
+                for (const auto& piece : plan) {
+                    if (not piece.cached)
+                        continue;
+                    spdlog::memory_buf_t buf;
+                    for (size_t i = piece.begin; i < piece.begin + piece.size; ++i)
+                        render_second(segments[i], tm, buf);
+                    auto& run = cache[piece.run];
+                    run.size = std::min(buf.size(), run.text.size());
+                    std::memcpy(run.text.data(), buf.data(), run.size);
+                }
+            }
+
+            static void render_second(const pattern_segment& s, const std::tm& tm, spdlog::memory_buf_t& dest) {
+                namespace helper = spdlog::details::fmt_helper;
+                switch (s.flag) {
+                    case 0:
+                        return dest.append(Pattern.str.data() + s.begin, Pattern.str.data() + s.begin + s.size);
+                    case 'Y':
+                        return helper::append_int(tm.tm_year + 1900, dest);
+                    case 'm':
+                        return helper::pad2(tm.tm_mon + 1, dest);
+                    case 'd':
+                        return helper::pad2(tm.tm_mday, dest);
+                    case 'H':
+                        return helper::pad2(tm.tm_hour, dest);
+                    case 'M':
+                        return helper::pad2(tm.tm_min, dest);
+                    default:
+                        return helper::pad2(tm.tm_sec, dest);
+                }
+            }
+
+            template <pattern_segment S>
+            void put(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) {
+                namespace helper = spdlog::details::fmt_helper;
+                using namespace std::chrono;
+                static_assert(S.cached or not SECOND_FLAGS.contains(S.flag), "The planner caches every second flag");
+
+                if constexpr (S.cached)
+                    dest.append(cache[S.run].text.data(), cache[S.run].text.data() + cache[S.run].size);
+                else if constexpr (S.flag == 0)
+                    dest.append(Pattern.str.data() + S.begin, Pattern.str.data() + S.begin + S.size);
+                else if constexpr (S.flag == 'e')
+                    append_digits<3>(fraction<milliseconds>(msg), dest);
+                else if constexpr (S.flag == 'f')
+                    append_digits<6>(fraction<microseconds>(msg), dest);
+                else if constexpr (S.flag == 'F')
+                    append_digits<9>(fraction<nanoseconds>(msg), dest);
+                else if constexpr (S.flag == 'n')
+                    helper::append_string_view(msg.logger_name, dest);
+                else if constexpr (S.flag == 'l')
+                    helper::append_string_view(spdlog::level::to_string_view(msg.level), dest);
+                else if constexpr (S.flag == 'L')
+                    dest.push_back(*spdlog::level::to_short_c_str(msg.level));
+                else if constexpr (S.flag == 'v')
+                    helper::append_string_view(msg.payload, dest);
+                else if constexpr (S.flag == 't')
+                    helper::append_int(msg.thread_id, dest);
+                else if constexpr (S.flag == 'P')
+                    helper::append_int(process_id(), dest);
+                else if constexpr (S.flag == 'g') {
+                    if (not msg.source.empty())
+                        helper::append_string_view(msg.source.filename, dest);
+                }
+                else if constexpr (S.flag == 's') {
+                    if (not msg.source.empty())
+                        helper::append_string_view(basename(msg.source.filename), dest);
+                }
+                else if constexpr (S.flag == '#') {
+                    if (not msg.source.empty())
+                        helper::append_int(msg.source.line, dest);
+                }
+                else if constexpr (S.flag == '!') {
+                    if (not msg.source.empty())
+                        helper::append_string_view(msg.source.funcname, dest);
+                }
+                else if constexpr (S.flag == '*')
+                    elapsed.format(msg, {}, dest);
+                else if constexpr (S.flag == '^')
+                    msg.color_range_start = dest.size();
+                else if constexpr (S.flag == '$')
+                    msg.color_range_end = dest.size();
+            }
+
+            template <typename Duration>
+            static size_t fraction(const spdlog::details::log_msg& msg) {
+                return static_cast<size_t>(spdlog::details::fmt_helper::time_fraction<Duration>(msg.time).count());
+            }
+
+            static size_t process_id() {
+                static const auto pid = spdlog::details::os::pid();
+                return pid;
+            }
+
+            static spdlog::string_view_t basename(const char* filename) {
+                std::string_view file{filename};
+                auto sep = file.find_last_of(spdlog::details::os::folder_seps);
+                return sep == file.npos ? spdlog::string_view_t{filename} : spdlog::string_view_t{filename + sep + 1};
+            }
+
+          public:
+            explicit compiled_formatter(bool utc = false) : utc{utc} {}
+
+            static constexpr std::string_view pattern() { return Pattern.sv(); }
+
+            void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+                if constexpr (runs > 0)
+                    refresh(msg.time);
+
+                [&]<size_t... I>(std::index_sequence<I...>) {
+                    (put<plan[I]>(msg, dest), ...);
+                }(std::make_index_sequence<plan.size()>{});
+
+                constexpr std::string_view eol{spdlog::details::os::default_eol};
+                dest.append(eol.data(), eol.data() + eol.size());
+            }
+
+            std::unique_ptr<spdlog::formatter> clone() const override {
+                return std::make_unique<compiled_formatter>(utc);
+            }
+        };
+
+        template <string_literal Pattern>
+        std::unique_ptr<spdlog::formatter> make_compiled_formatter(bool utc) {
+            return std::make_unique<compiled_formatter<Pattern>>(utc);
+        }
+    }  // namespace detail
+
+    // A pattern compiled by "..."_pattern; selected with Config::compiled
+    struct compiled_pattern {
+        std::string_view text;
+        std::unique_ptr<spdlog::formatter> (*factory)(bool utc){nullptr};
+
+        // A formatter for the pattern, in local time or UTC
+        std::unique_ptr<spdlog::formatter> make(bool utc = false) const { return factory(utc); }
+
+        constexpr explicit operator bool() const { return factory != nullptr; }
+    };
+
+    inline constexpr compiled_pattern DEFAULT_COMPILED_PATTERN{
+            detail::default_pattern.sv(), &detail::make_compiled_formatter<detail::default_pattern>};
+    inline constexpr compiled_pattern DEFAULT_COMPILED_PATTERN_COLOR{
+            detail::default_pattern_color.sv(), &detail::make_compiled_formatter<detail::default_pattern_color>};
+
+    namespace literals {
+        template <detail::string_literal Pattern>
+        inline consteval auto operator""_pattern() {
+            return compiled_pattern{Pattern.sv(), &detail::make_compiled_formatter<Pattern>};
+        }
+    }  // namespace literals
+
+}  // namespace un::log
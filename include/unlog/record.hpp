@@ -0,0 +1,79 @@
+#pragma once
+
+#include "format.hpp"
+
+#include <spdlog/async_logger.h>
+#include <spdlog/logger.h>
+
+namespace un::log::detail {
+    /*  Record messages
+
+        Deferred records (deferred.hpp) and fields records (fields.hpp) travel as the payload of an ordinary log
+        message. What makes a payload a record is the path it takes, never its bytes or any field of the message: the
+        capture paths hand it to record_logger::log_record with its kind, the async engines queue the kind beside the
+        message, and the backend delivers it through record_sink::log_record. Any text, whatever it holds, goes through
+        spdlog's log path and is delivered as text. Sinks that only take text get a copy holding the rendered record.
+    */
+    enum class record_kind : uint8_t { text, deferred, fields };
+
+    // Implemented by the loggers unlog makes: queues or delivers a record together with its kind
+    class record_logger {
+      public:
+        virtual void log_record(const spdlog::details::log_msg& msg, record_kind kind) = 0;
+
+      protected:
+        ~record_logger() = default;
+    };
+
+    // Hands record `msg` to each of `logger`'s sinks that wants its level: record sinks take it as it is, the others a
+    // rendered copy; then flushes them if the level calls for it. Sink exceptions are left to the caller.
+    void deliver_record(spdlog::logger& logger, const spdlog::details::log_msg& msg, record_kind kind);
+
+    // Logs a record captured on the calling thread; a logger unlog did not make gets the rendered text instead
+    void log_record(
+            spdlog::logger& logger,
+            spdlog::log_clock::time_point time,
+            spdlog::source_loc loc,
+            spdlog::level::level_enum level,
+            spdlog::string_view_t payload,
+            record_kind kind);
+
+    // Synchronous logger; delivers records on the calling thread
+    class sync_logger final : public spdlog::logger, public record_logger {
+      public:
+        using spdlog::logger::logger;
+
+        void log_record(const spdlog::details::log_msg& msg, record_kind kind) override;
+
+        std::shared_ptr<spdlog::logger> clone(std::string new_name) override;
+    };
+
+    /*  Thread pool logger (Engine::pool)
+
+        spdlog's async_logger, plus records. spdlog's queue carries a message and the logger it came from, so a record
+        is posted with a carrier of its kind in place of the logger: an async_logger member whose only sink hands the
+        messages it is given to the owning logger's sinks as records. The carrier's pointer shares the owner's
+        reference count, keeping the owner alive while the record is queued just as text keeps its logger alive.
+    */
+    class pool_logger final : public spdlog::async_logger, public record_logger {
+        class carrier_sink;
+
+        std::weak_ptr<spdlog::details::thread_pool> pool;
+        spdlog::async_overflow_policy overflow;
+        spdlog::async_logger deferred_carrier;
+        spdlog::async_logger fields_carrier;
+
+      public:
+        pool_logger(
+                std::string name,
+                spdlog::sink_ptr sink,
+                std::weak_ptr<spdlog::details::thread_pool> pool,
+                spdlog::async_overflow_policy overflow);
+
+        pool_logger(const pool_logger& other);
+
+        void log_record(const spdlog::details::log_msg& msg, record_kind kind) override;
+
+        std::shared_ptr<spdlog::logger> clone(std::string new_name) override;
+    };
+}  // namespace un::log::detail
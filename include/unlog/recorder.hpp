@@ -0,0 +1,144 @@
+#pragma once
+
+#include "config.hpp"
+#include "deferred.hpp"
+
+#include <spdlog/sinks/sink.h>
+
+namespace un::log::detail {
+    /*  Flight recorder (Config::recorder)
+
+        Keeps the most recent messages of every thread in a per-thread ring, below the level of any logger, so that a
+        crash report comes with the debug and trace lines leading up to it without paying to write them out. Each
+        thread owns its ring: recording a message is an unshared store into a fixed-size slot, with no lock and no
+        atomic read-modify-write. Arguments are captured as for deferred loggers (see deferred.hpp) and only formatted
+        when the recorder is dumped; call sites whose arguments cannot be captured are formatted on the spot. A message
+        larger than a slot is kept rendered and truncated.
+
+        Slots are written under a per-slot sequence number, so a dump taken while threads keep logging skips the slots
+        being overwritten rather than reading torn ones. A thread's ring outlives it and is handed to a later thread,
+        preferably one of the configured size; rings are never freed, so a crash handler can always read them. Once
+        MAX_RINGS rings exist, a new thread takes any released ring, whatever its size, and a thread that finds none
+        goes unrecorded, which the dump reports, until another thread gives its ring back. The recorder is dumped on
+        SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT and std::terminate when RecorderPolicy::dump_on_crash is set, and on
+        request. The crash dump is best effort: it formats and allocates, which is not async-signal-safe, but runs only
+        once and then re-raises the signal with its default action. Handlers run on an alternate signal stack, which
+        each recording thread (and the thread enabling dump_on_crash) gets unless it already has one, so a stack
+        overflow is dumped too.
+    */
+    class flight_recorder {
+      public:
+        static constexpr size_t SLOT_SIZE{256};
+        static constexpr size_t MAX_RINGS{256};
+
+        enum class kind : uint8_t { record, text };
+
+        struct slot_header {
+            std::atomic<uint32_t> sequence{0};  // odd while the slot is being written
+            uint16_t size{0};
+            uint8_t level{0};
+            kind type{kind::text};
+            int64_t time{0};
+            uint64_t thread{0};
+            spdlog::source_loc loc{};
+            std::array<char, 15> name{};
+            uint8_t name_size{0};
+        };
+
+        struct slot : slot_header {
+            std::array<char, SLOT_SIZE - sizeof(slot_header)> data;
+        };
+
+        static_assert(sizeof(slot) == SLOT_SIZE);
+
+        struct ring {
+            std::atomic<bool> owned{true};
+            std::atomic<uint64_t> written{0};
+            size_t capacity;
+            std::unique_ptr<slot[]> slots;
+
+            explicit ring(size_t capacity) : capacity{capacity}, slots{std::make_unique<slot[]>(capacity)} {}
+        };
+
+      private:
+        std::atomic<LogLevel> threshold{LogLevel::off};
+        std::atomic<size_t> capacity{256};
+        std::array<std::atomic<ring*>, MAX_RINGS> rings{};
+        std::atomic<size_t> unrecorded_threads{0};
+
+        // dump destination, replaced under dump_mutex
+        std::mutex dump_mutex;
+        int dump_fd{-1};
+        std::unique_ptr<spdlog::formatter> formatter;
+        std::atomic<bool> crashed{false};
+
+        ring* acquire_ring();
+        ring* local_ring();
+        void commit(
+                std::string_view logger,
+                LogLevel level,
+                spdlog::source_loc loc,
+                kind type,
+                const char* data,
+                size_t size);
+        void write_dump(std::string_view reason);
+
+      public:
+        constexpr flight_recorder() = default;
+        ~flight_recorder();
+
+        flight_recorder(const flight_recorder&) = delete;
+        flight_recorder& operator=(const flight_recorder&) = delete;
+
+        // Applies `policy`: a disabled policy stops recording and keeps what was recorded. A new ring size applies to
+        // rings created afterwards, and to none once MAX_RINGS rings exist. Throws std::runtime_error if the dump file cannot be opened.
+        void configure(const RecorderPolicy& policy);
+
+        LogLevel level() const { return threshold.load(std::memory_order_relaxed); }
+
+        bool accepts(LogLevel level) const { return level >= threshold.load(std::memory_order_relaxed); }
+
+        // Arg is given explicitly, as the functors deduce it
+        template <typename... Arg>
+        void record(
+                const spdlog::logger& logger,
+                LogLevel level,
+                [[maybe_unused]] callsite_id id,
+                const site_string<Arg...>& fmt,
+                const std::remove_reference_t<Arg>&... args) {
+            spdlog::memory_buf_t buf;
+            if constexpr ((deferrable<Arg> && ...)) {
+                if (id != NO_CALLSITE) {
+                    record_header header{id};
+                    buf.append(
+                            reinterpret_cast<const char*>(&header),
+                            reinterpret_cast<const char*>(&header) + sizeof(header));
+                    (capture<std::remove_cvref_t<Arg>>::write(buf, args), ...);
+                    return commit(logger.name(), level, fmt.site.loc(), kind::record, buf.data(), buf.size());
+                }
+            }
+            fmt::vformat_to(fmt::appender(buf), fmt::string_view{fmt.fmt}, fmt::make_format_args(args...));
+            commit(logger.name(), level, fmt.site.loc(), kind::text, buf.data(), buf.size());
+        }
+
+        // Number of messages currently held across all rings
+        size_t size() const;
+
+        // Number of threads that logged at the recorder level but found no ring to record into
+        size_t unrecorded() const { return unrecorded_threads.load(std::memory_order_relaxed); }
+
+        // Writes the recorded messages, oldest first, to the dump file (or stderr)
+        void dump();
+
+        // Hands the recorded messages, oldest first and rendered, to `sink`, then flushes it
+        void dump(spdlog::sinks::sink& sink);
+
+        // Used by the crash handlers: dumps to the dump file once per process, whatever else is going on
+        void crash_dump(std::string_view reason);
+    };
+
+    extern flight_recorder recorder;
+
+    // Configures the flight recorder and folds its level into min_level
+    void set_flight_recorder(const RecorderPolicy& policy);
+}  // namespace un::log::detail
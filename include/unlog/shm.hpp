@@ -0,0 +1,135 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace un::log {
+    /*  Shared-memory transport (Type::Shm)
+
+        Each producer process writes its messages into a ring in a POSIX shared memory segment of its own,
+        /dev/shm/unlog.<channel>.<pid>, and a collector, the unlog-collector tool or a shm_collector in any process,
+        delivers the messages of every ring on the channel to its own sinks. Producers pay for a copy into the ring;
+        formatting and I/O happen once, in the collector.
+
+        A ring is a byte buffer with one producer (the sink, under its lock) and one consumer (the collector). Records
+        are 8-byte aligned and never wrap; one that does not fit before the end of the buffer is preceded by a padding
+        record. The producer publishes a record by storing the tail after writing it, so a producer that dies partway
+        through a record leaves nothing visible, and the collector, which only reads below the tail and checks every
+        record against the buffer bounds, cannot be led astray by it. When the ring is full the message is dropped and
+        counted; the collector reports the count. Records carry what a sink needs to render the message again:
+
+            u32 size | u8 kind | u8 level | u16 name size | i64 time (ns) | u64 thread | u32 line | u16 file size |
+            u16 function size | u32 text size | u32 reserved | name | file\0 | function\0 | text
+
+        The collector merges the rings in timestamp order among the records available when it polls, and removes the
+        segment of a producer that has closed it or exited once the ring is empty. Messages keep the producer's time,
+        thread and source location; %P and %* of the collector's sinks describe the collector itself.
+    */
+    namespace shm {
+        inline constexpr std::string_view MAGIC{"UNLOGSHM"};
+        inline constexpr uint32_t VERSION{1};
+
+        enum class kind : uint8_t { message = 'M', padding = 'P' };
+
+        struct ring_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t pid;
+            uint64_t capacity;  // data bytes, a power of two
+            int64_t started_at;  // producer start time (ns)
+            std::atomic<uint32_t> ready;  // set once the header is complete
+            std::atomic<uint32_t> closed;  // the producer closed the ring
+            std::atomic<uint64_t> dropped;  // messages that found the ring full
+
+            alignas(64) std::atomic<uint64_t> head;  // next byte to consume, written by the collector
+            alignas(64) std::atomic<uint64_t> tail;  // next byte to produce, written by the producer
+        };
+
+        struct record_header {
+            uint32_t size;  // the whole record, header and padding included
+            kind type;
+            uint8_t level;
+            uint16_t name_size;
+            int64_t time;
+            uint64_t thread;
+            uint32_t line;
+            uint16_t file_size;
+            uint16_t function_size;
+            uint32_t text_size;
+            uint32_t reserved;
+        };
+
+        inline constexpr size_t DATA_OFFSET{(sizeof(ring_header) + 63) / 64 * 64};
+
+        // Shared memory object name of the ring of `pid` on `channel`
+        std::string segment_name(std::string_view channel, uint32_t pid);
+    }  // namespace shm
+
+    class shm_sink final : public spdlog::sinks::base_sink<std::mutex> {
+        std::string name;
+        shm::ring_header* ring{nullptr};
+        char* data{nullptr};
+        size_t mapped{0};
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override {}
+        void set_pattern_(const std::string&) override {}
+        void set_formatter_(std::unique_ptr<spdlog::formatter>) override {}
+
+      public:
+        // Creates this process' ring on the policy's channel, replacing a stale one left by an earlier process with the
+        // same pid. Throws std::runtime_error if the segment cannot be created.
+        explicit shm_sink(const ShmPolicy& policy);
+        ~shm_sink() override;
+
+        shm_sink(const shm_sink&) = delete;
+        shm_sink& operator=(const shm_sink&) = delete;
+    };
+
+    /*  Collector for a Type::Shm channel
+
+        poll() attaches the rings that appeared since the last call, delivers every published record to the master
+        sink (the sinks of the collecting process' loggers; none of them may be a Type::Shm sink on the same channel),
+        and detaches rings whose producer is gone. start() runs poll() on a thread of its own until stop() or
+        destruction, sleeping for `interval` whenever there was nothing to deliver.
+    */
+    class shm_collector {
+        struct attached;
+
+        std::string channel;
+        std::vector<std::unique_ptr<attached>> rings;
+        std::chrono::milliseconds interval;
+
+        std::atomic<bool> running{false};
+        std::thread worker;
+
+        // file and function names of the message being delivered, each NUL-terminated
+        std::string source;
+
+        void discover();
+        void deliver(const shm::record_header& record, const char* body);
+        void retire();
+
+      public:
+        explicit shm_collector(std::string_view channel = "unlog"sv, std::chrono::milliseconds interval = 5ms);
+        ~shm_collector();
+
+        shm_collector(const shm_collector&) = delete;
+        shm_collector& operator=(const shm_collector&) = delete;
+
+        // Delivers what the producers have published so far; returns the number of messages delivered
+        size_t poll();
+
+        void start();
+        void stop();
+
+        // Rings currently attached
+        size_t producers() const { return rings.size(); }
+    };
+}  // namespace un::log
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "record.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace un::log {
+
+    // A sink that takes records as they were captured (see record.hpp) rather than rendered text; such sinks lock
+    // themselves and are never wrapped in a serialized_sink
+    struct record_sink {
+        virtual ~record_sink() = default;
+
+        virtual void log_record(const spdlog::details::log_msg& msg, detail::record_kind kind) = 0;
+    };
+
+    /*  Fan-out sink with a copy-on-write sink list
+
+        Replaces spdlog's dist_sink as the master sink. The list of sinks is an immutable snapshot published
+        atomically: logging loads the current snapshot and writes to each sink without taking any lock, while
+        add_sink/remove_sink/set_sinks build a new list and swap it in. Writers are serialized among themselves only.
+        Sinks are responsible for their own thread safety; single-threaded sinks go through serialized_sink.
+
+        Records arrive through log_record (see record.hpp): record sinks get the record itself, and it is rendered
+        (once) only if a text sink wants it. While the text of a fields record (see fields.hpp) is handed out,
+        structured formatters can find the fields behind it.
+    */
+    class fanout_sink final : public spdlog::sinks::sink, public record_sink {
+      public:
+        using sink_list = std::vector<spdlog::sink_ptr>;
+        using snapshot = std::shared_ptr<const sink_list>;
+
+      private:
+        struct state {
+            sink_list sinks;
+            std::vector<record_sink*> record_sinks;  // null for sinks that take text
+            std::vector<std::shared_ptr<detail::sink_meter>> meters;
+
+            state() = default;
+            explicit state(sink_list list);
+        };
+        using state_ptr = std::shared_ptr<const state>;
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+        std::atomic<state_ptr> current;
+
+        state_ptr load() const { return current.load(std::memory_order_acquire); }
+        void store(state_ptr s) { current.store(std::move(s), std::memory_order_release); }
+#else
+        state_ptr current;
+
+        state_ptr load() const { return std::atomic_load_explicit(&current, std::memory_order_acquire); }
+        void store(state_ptr s) { std::atomic_store_explicit(&current, std::move(s), std::memory_order_release); }
+#endif
+        std::mutex writer_mutex;
+
+      public:
+        fanout_sink();
+
+        void log(const spdlog::details::log_msg& msg) override;
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+        void log_record(const spdlog::details::log_msg& msg, detail::record_kind kind) override;
+
+        void add_sink(spdlog::sink_ptr sink);
+        // Removes `sink`, also where it sits behind the serialized_sink or dedup_sink it was added in
+        void remove_sink(const spdlog::sink_ptr& sink);
+        void set_sinks(sink_list sinks);
+
+        // Current sink list; stays valid (and unchanged) for as long as the caller holds it
+        snapshot sinks() const {
+            auto s = load();
+            return snapshot{s, &s->sinks};
+        }
+    };
+
+    // Gives a single-threaded sink its own lock, so it can sit in the fan-out without a global lock around every sink
+    class serialized_sink final : public spdlog::sinks::sink {
+        spdlog::sink_ptr inner;
+        std::mutex mutex;
+
+      public:
+        explicit serialized_sink(spdlog::sink_ptr sink) : inner{std::move(sink)} {}
+
+        void log(const spdlog::details::log_msg& msg) override;
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+        const spdlog::sink_ptr& wrapped() const { return inner; }
+    };
+
+    /*  Duplicate-collapsing sink (Config::dedup_window)
+
+        Wraps a sink and drops a message identical to the last one written (same logger, level, call site and rendered
+        payload) while it arrives within the window of it. The next message that differs, a flush, or a repeat after
+        the window has run out first writes "last message repeated N times" for the dropped ones.
+
+        Repeats are counted without a lock: the 48-bit hash of the last message and its repeat count share one atomic
+        word, and only a message that differs takes the mutex to write. A distinct message is mistaken for a repeat
+        only if its hash collides, about once in 2^48.
+    */
+    class dedup_sink final : public spdlog::sinks::sink {
+        static constexpr uint64_t COUNT_MASK{0xffff};
+
+        spdlog::sink_ptr inner;
+        std::chrono::nanoseconds window;
+        std::atomic<uint64_t> last{0};
+        std::atomic<int64_t> written_at{0};
+
+        // the last message written, for the summary line
+        std::mutex mutex;
+        std::string logger_name;
+        spdlog::level::level_enum level{};
+        // copies: the message's source may point into a buffer its sender reuses as soon as log() returns
+        std::string source_file;
+        std::string source_function;
+        int source_line{0};
+        size_t thread_id{0};
+
+        void write_summary(uint64_t repeats);
+
+      public:
+        dedup_sink(spdlog::sink_ptr sink, std::chrono::milliseconds window);
+        ~dedup_sink() override;
+
+        void log(const spdlog::details::log_msg& msg) override;
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+        const spdlog::sink_ptr& wrapped() const { return inner; }
+    };
+
+}  // namespace un::log
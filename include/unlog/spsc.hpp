@@ -0,0 +1,194 @@
+#pragma once
+
+#include "config.hpp"
+#include "record.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace un::log::detail {
+    /*  Per-thread SPSC async engine
+
+        Alternative to spdlog's shared MPMC thread pool (Engine::spsc). Every producer thread lazily registers its own
+        fixed-size ring; pushing a message touches only that ring, so producers never contend with one another. A
+        single backend thread drains all rings, always delivering the oldest queued message first so the output stays
+        in timestamp order across threads.
+    */
+
+    class spsc_logger;
+
+    // The engine keeps the logger alive while the message is queued (see spsc_engine::pin)
+    struct spsc_slot {
+        spsc_logger* logger{nullptr};
+        record_kind kind{record_kind::text};
+        spdlog::details::log_msg_buffer msg;
+    };
+
+    class spsc_ring {
+        std::vector<spsc_slot> slots;
+        const size_t mask;
+
+        alignas(64) std::atomic<size_t> head{0};  // next slot to consume, written by the backend
+        alignas(64) std::atomic<size_t> tail{0};  // next slot to produce, written by the owning thread
+
+      public:
+        std::atomic<bool> orphaned{false};  // owning thread has exited
+
+        explicit spsc_ring(size_t capacity);
+
+        // Producer side; returns false when the ring is full
+        bool try_push(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind = record_kind::text);
+
+        // Consumer side
+        const spsc_slot* front() const;
+        void pop();
+
+        size_t produced() const { return tail.load(std::memory_order_acquire); }
+        size_t consumed() const { return head.load(std::memory_order_acquire); }
+        bool empty() const { return consumed() == produced(); }
+        size_t capacity() const { return slots.size(); }
+    };
+
+    /*  Spill file (Overflow::spill)
+
+        Overflow for spilling loggers. Producers whose ring is full append the message to the file under a lock; from
+        then until the file has been replayed, every message from a spilling logger goes to the file, so none of them
+        overtakes an earlier spilled one. The backend replays the file in chunks: while the rings are busy, a chunk of
+        the spilled messages older than the ring traffic after every chunk of it, so the merge stays in timestamp
+        order, and back to back once the rings are empty. It truncates the file once it has caught up. The file holds
+        at most Config::spill_limit bytes; while it is full, spilling loggers block until it has been replayed.
+        Replayed messages keep their timestamps. Records name their logger by an index into a table of loggers the
+        engine keeps alive until the file has been replayed, and deferred records name their call site by its ID, so
+        the file is only meaningful to the process that wrote it and is removed when the engine shuts down.
+    */
+    class spill_file {
+        std::mutex mutex;
+        int fd{-1};
+        fs::path path;
+        uint64_t limit{0};
+        uint64_t written{0};  // guarded by mutex
+        std::vector<spsc_logger*> loggers;  // guarded by mutex
+        uint64_t replayed{0};  // backend only
+        std::vector<spsc_logger*> replaying;  // backend only, a copy of loggers
+        std::atomic<bool> pending{false};
+        spdlog::memory_buf_t chunk;  // backend only
+
+      public:
+        enum class result : uint8_t { written, full, failed };
+
+        spill_file() = default;
+        ~spill_file();
+
+        spill_file(const spill_file&) = delete;
+        spill_file& operator=(const spill_file&) = delete;
+
+        // Opens (truncating) `file`, capped at `max_size` bytes, on first use; later calls keep the file and the cap
+        // already set. Throws std::runtime_error if it cannot be created.
+        void open(const fs::path& file, uint64_t max_size);
+
+        bool is_open() const { return fd >= 0; }
+        bool has_pending() const { return pending.load(std::memory_order_acquire); }
+
+        // Appends a message, unless that would take the file past its cap; on a failed write the caller falls back to
+        // blocking on its ring
+        result write(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind);
+
+        // Backend side: delivers up to `max` spilled messages, oldest first, stopping at the first one logged after
+        // `until`; returns how many it delivered
+        size_t replay(size_t max, spdlog::log_clock::time_point until = spdlog::log_clock::time_point::max());
+    };
+
+    class spsc_engine {
+        static constexpr size_t SPILL_CHUNK{256};
+
+        const size_t ring_capacity;
+        spill_file spill;
+
+        std::mutex rings_mutex;
+        std::vector<std::shared_ptr<spsc_ring>> rings;
+        std::atomic<uint64_t> generation{0};
+
+        // Every logger that has pushed a message. Slots and spill records refer to their logger by raw pointer, so
+        // the engine owns it until nothing queued refers to it any more; the backend then releases loggers nobody
+        // else holds, and all of them once it has drained at shutdown.
+        std::mutex loggers_mutex;
+        std::vector<std::shared_ptr<spsc_logger>> loggers;
+
+        std::atomic<bool> running{true};
+        std::thread backend;
+
+        spsc_ring& local_ring();
+
+        void pin(spsc_logger& logger);
+
+        // Spills a message, waiting while the file is full; false sends it to the ring after all
+        bool spill_message(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind);
+
+        // Backend side, with the rings in `local` read as empty at generation `seen`
+        void release_dropped(const std::vector<std::shared_ptr<spsc_ring>>& local, uint64_t seen);
+
+        void run();
+
+      public:
+        explicit spsc_engine(size_t capacity);
+        ~spsc_engine();
+
+        spsc_engine(const spsc_engine&) = delete;
+        spsc_engine& operator=(const spsc_engine&) = delete;
+
+        // Queues a copy of `msg` on the calling thread's ring; when the ring is full, applies the logger's overflow
+        // policy (spinning for Overflow::block)
+        void push(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind = record_kind::text);
+
+        // Blocks until everything queued before the call, spilled messages included, has been delivered to the sinks
+        void drain();
+
+        // Opens the spill file for Overflow::spill loggers
+        void enable_spill(const fs::path& file, uint64_t max_size) { spill.open(file, max_size); }
+
+        size_t capacity() const { return ring_capacity; }
+
+        // Messages queued on all rings and not yet delivered
+        size_t depth();
+
+        static bool on_backend_thread();
+    };
+
+    // Global engine shared by all Engine::spsc loggers; sized by the first logger that creates it
+    spsc_engine& spsc_pool(uint32_t ring_size = 8192);
+
+    class spsc_logger final : public std::enable_shared_from_this<spsc_logger>,
+                              public spdlog::logger,
+                              public record_logger {
+        friend class spsc_engine;
+        friend class spill_file;
+
+        spsc_engine& engine;
+        Overflow overflow;
+        std::atomic<bool> pinned{false};  // held by the engine (see spsc_engine::pin)
+
+        // Backend side
+        void backend_sink_it_(const spdlog::details::log_msg& msg, record_kind kind);
+
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override;
+
+      public:
+        // Throws std::invalid_argument for Overflow::overwrite_oldest, which a producer cannot do to an SPSC ring
+        spsc_logger(
+                std::string name, spdlog::sink_ptr sink, spsc_engine& engine, Overflow overflow = Overflow::block);
+
+        // A copy is pinned on its own first push
+        spsc_logger(const spsc_logger& other);
+
+        Overflow overflow_policy() const { return overflow; }
+
+        void log_record(const spdlog::details::log_msg& msg, record_kind kind) override;
+
+        std::shared_ptr<spdlog::logger> clone(std::string new_name) override;
+    };
+
+}  // namespace un::log::detail
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace un::log {
+
+    struct sink_stats {
+        std::string name;  // "<config name>:<type>" of the Config that added it, or "sink"
+        uint64_t messages{0};
+        uint64_t bytes{0};  // formatted bytes handed to the sink
+        uint64_t flushes{0};
+        std::chrono::nanoseconds flush_time{0};
+        std::chrono::nanoseconds max_flush{0};
+    };
+
+    struct queue_stats {
+        bool running{false};  // whether the engine has been started at all
+        uint64_t depth{0};
+        uint64_t high_water{0};
+        uint64_t overrun{0};    // oldest message overwritten by a full queue
+        uint64_t discarded{0};  // new message dropped by a full queue
+        uint64_t spilled{0};    // written to the spill file by a full queue (Overflow::spill)
+        uint64_t replayed{0};   // read back from the spill file and delivered
+        uint64_t delivered{0};
+        std::chrono::nanoseconds busy{0};  // time the backend threads spent delivering and flushing
+    };
+
+    struct stats_snapshot {
+        std::array<uint64_t, spdlog::level::n_levels> logged{};  // messages emitted, indexed by level
+        queue_stats pool;                                        // Engine::pool (spdlog's thread pool)
+        queue_stats spsc;                                        // Engine::spsc
+        std::vector<sink_stats> sinks;
+
+        uint64_t logged_total() const {
+            uint64_t total = 0;
+            for (auto n : logged)
+                total += n;
+            return total;
+        }
+    };
+
+    /*  Runtime statistics
+
+        Counters are kept where they cost the least: messages per level in cache-line-sized shards, one per group of
+        threads, so producers do not share a line; queue and busy-time figures only on the backend threads; sink bytes
+        inside the sink's formatter, which already runs under the sink's lock. High-water marks are sampled by the
+        backend every SAMPLE_INTERVAL messages (and on every snapshot), so a burst shorter than that can exceed them.
+        Sink figures cover sinks added through a Config or add_sink; a formatter installed directly on the sink, rather
+        than through the logger or master sink, stops its byte count.
+    */
+    stats_snapshot stats();
+
+    namespace detail {
+        inline constexpr size_t STAT_SHARDS{16};
+        inline constexpr uint64_t SAMPLE_INTERVAL{64};
+
+        struct alignas(64) stat_shard {
+            std::array<std::atomic<uint64_t>, spdlog::level::n_levels> logged{};
+        };
+
+        extern std::array<stat_shard, STAT_SHARDS> stat_shards;
+        extern std::atomic<size_t> next_stat_shard;
+
+        inline stat_shard& local_stat_shard() {
+            thread_local auto& shard = stat_shards[next_stat_shard.fetch_add(1, std::memory_order_relaxed) % STAT_SHARDS];
+            return shard;
+        }
+
+        inline void count_logged(spdlog::level::level_enum level) {
+            local_stat_shard().logged[level].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Figures kept by the backend threads of one engine
+        struct backend_meter {
+            std::atomic<uint64_t> delivered{0};
+            std::atomic<uint64_t> busy_ns{0};
+            std::atomic<uint64_t> high_water{0};
+            // overflow, counted by the producers (spdlog keeps its own for the pool)
+            std::atomic<uint64_t> discarded{0};
+            std::atomic<uint64_t> spilled{0};
+            std::atomic<uint64_t> replayed{0};
+            std::atomic<size_t (*)()> depth{nullptr};  // set once the engine is running
+
+            // Called by a backend thread after delivering a message that it started on at `start`
+            void delivered_since(std::chrono::steady_clock::time_point start);
+            void busy_since(std::chrono::steady_clock::time_point start);
+            uint64_t sample();
+        };
+
+        extern backend_meter pool_meter;
+        extern backend_meter spsc_meter;
+
+        // Marks the calling thread as a backend of `meter`; the master sink then times what it delivers
+        void set_backend_meter(backend_meter* meter);
+        backend_meter* current_backend_meter();
+
+        struct sink_meter {
+            std::string name;
+            const spdlog::sinks::sink* sink{nullptr};  // the sink as held by the master sink
+            std::weak_ptr<spdlog::sinks::sink> alive;
+            std::atomic<uint64_t> messages{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<uint64_t> flushes{0};
+            std::atomic<uint64_t> flush_ns{0};
+            std::atomic<uint64_t> max_flush_ns{0};
+
+            void flushed(std::chrono::nanoseconds took);
+        };
+
+        // Meters registered for sinks in the master sink; find() returns nullptr for a sink without one
+        class sink_meters {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<sink_meter>> meters;
+
+          public:
+            std::shared_ptr<sink_meter> create(std::string name);
+            void attach(const std::shared_ptr<sink_meter>& meter, const spdlog::sink_ptr& sink);
+            std::shared_ptr<sink_meter> find(const spdlog::sinks::sink* sink);
+            std::vector<std::shared_ptr<sink_meter>> live();
+        };
+
+        sink_meters& meters();
+
+        // Counts what a sink formats, then hands the text back to it
+        class metered_formatter final : public spdlog::formatter {
+            std::unique_ptr<spdlog::formatter> inner;
+            std::shared_ptr<sink_meter> meter;
+
+          public:
+            metered_formatter(std::unique_ptr<spdlog::formatter> inner, std::shared_ptr<sink_meter> meter) :
+                    inner{std::move(inner)}, meter{std::move(meter)} {}
+
+            void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+                auto before = dest.size();
+                inner->format(msg, dest);
+                meter->messages.fetch_add(1, std::memory_order_relaxed);
+                meter->bytes.fetch_add(dest.size() - before, std::memory_order_relaxed);
+            }
+
+            std::unique_ptr<spdlog::formatter> clone() const override {
+                return std::make_unique<metered_formatter>(inner->clone(), meter);
+            }
+        };
+    }  // namespace detail
+}  // namespace un::log
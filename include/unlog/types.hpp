@@ -67,7 +67,7 @@ namespace un::log {
 
         template <size_t N>
         struct bsp_literal : span_literal<std::byte, N> {
-            consteval bsp_literal(const char (&s)[N]) : span_literal<char, N>{s} {}
+            consteval bsp_literal(const char (&s)[N]) : span_literal<std::byte, N>{s} {}
         };
 
     }  // namespace detail
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <spdlog/async.h>
-#include <spdlog/sinks/dist_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -17,15 +16,20 @@
 #include <source_location>
 #include <utility>
 
+// Lowest level compiled into the unlog call sites; uses the SPDLOG_LEVEL_* values (set via the UNLOG_ACTIVE_LEVEL
+// cmake option or the //:active_level bazel flag). Call sites below this level compile to nothing.
+#ifndef UNLOG_ACTIVE_LEVEL
+#define UNLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
 namespace un::log {
     //
 
     namespace detail {
-        inline constexpr spdlog::source_loc sloc(const std::source_location& loc) {
-            std::string_view sv{loc.file_name()};
-            if (auto p = sv.rfind('/'); p != sv.npos)
-                sv.remove_prefix(p + 1);
-            return spdlog::source_loc{sv.data(), static_cast<int>(loc.line()), loc.function_name()};
+        inline constexpr auto active_level = static_cast<spdlog::level::level_enum>(UNLOG_ACTIVE_LEVEL);
+
+        inline constexpr bool level_active(spdlog::level::level_enum level) {
+            return level >= active_level;
         }
     }  // namespace detail
 }  // namespace un::log
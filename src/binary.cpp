@@ -0,0 +1,361 @@
+#include "unlog/binary.hpp"
+
+#include "unlog/deferred.hpp"
+#include "unlog/pattern.hpp"
+
+#include <fmt/args.h>
+
+#include <fstream>
+
+namespace un::log {
+
+    namespace {
+        template <typename T>
+        void put(spdlog::memory_buf_t& buf, T val) {
+            buf.append(reinterpret_cast<const char*>(&val), reinterpret_cast<const char*>(&val) + sizeof(T));
+        }
+
+        void put_str(spdlog::memory_buf_t& buf, std::string_view s) {
+            put(buf, static_cast<uint32_t>(s.size()));
+            buf.append(s.data(), s.data() + s.size());
+        }
+
+        void put_frame(spdlog::memory_buf_t& buf, binary::frame f) {
+            put(buf, static_cast<uint8_t>(f));
+        }
+
+        int64_t nanos(spdlog::log_clock::time_point t) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        }
+
+        spdlog::log_clock::time_point from_nanos(int64_t ns) {
+            return spdlog::log_clock::time_point{
+                    std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds{ns})};
+        }
+
+        // Bounds-checked cursor over the file contents; any short read marks the frame as truncated
+        struct cursor {
+            std::string_view data;
+            bool truncated{false};
+
+            template <typename T>
+            T get() {
+                T val{};
+                if (data.size() < sizeof(T)) {
+                    truncated = true;
+                    data = {};
+                    return val;
+                }
+                std::memcpy(&val, data.data(), sizeof(T));
+                data.remove_prefix(sizeof(T));
+                return val;
+            }
+
+            std::string_view bytes(size_t n) {
+                if (data.size() < n) {
+                    truncated = true;
+                    data = {};
+                    return {};
+                }
+                auto s = data.substr(0, n);
+                data.remove_prefix(n);
+                return s;
+            }
+
+            std::string_view str() { return bytes(get<uint32_t>()); }
+        };
+
+        // Rebuilds the arguments of a record from its type signature, in the layout written by detail::capture
+        void decode_args(std::string_view types, cursor args, fmt::dynamic_format_arg_store<fmt::format_context>& out) {
+            for (char code : types) {
+                switch (code) {
+                    case 'b':
+                        out.push_back(args.get<bool>());
+                        break;
+                    case 'c':
+                        out.push_back(args.get<char>());
+                        break;
+                    case 'a':
+                        out.push_back(args.get<int8_t>());
+                        break;
+                    case 'h':
+                        out.push_back(args.get<int16_t>());
+                        break;
+                    case 'i':
+                        out.push_back(args.get<int32_t>());
+                        break;
+                    case 'l':
+                        out.push_back(args.get<int64_t>());
+                        break;
+                    case 'A':
+                        out.push_back(args.get<uint8_t>());
+                        break;
+                    case 'H':
+                        out.push_back(args.get<uint16_t>());
+                        break;
+                    case 'I':
+                        out.push_back(args.get<uint32_t>());
+                        break;
+                    case 'L':
+                        out.push_back(args.get<uint64_t>());
+                        break;
+                    case 'f':
+                        out.push_back(args.get<float>());
+                        break;
+                    case 'd':
+                        out.push_back(args.get<double>());
+                        break;
+                    case 's':
+                        out.push_back(args.bytes(args.get<size_t>()));
+                        break;
+                    case 'u': {
+                        auto s = args.bytes(args.get<size_t>());
+                        out.push_back(uspan{reinterpret_cast<const unsigned char*>(s.data()), s.size()});
+                        break;
+                    }
+                    case 'y': {
+                        auto s = args.bytes(args.get<size_t>());
+                        out.push_back(bspan{reinterpret_cast<const std::byte*>(s.data()), s.size()});
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error{"Unknown argument type '{}'"_format(code)};
+                }
+                if (args.truncated)
+                    throw std::runtime_error{"Record is shorter than its argument types"};
+            }
+        }
+    }  // namespace
+
+    binary_sink::binary_sink(const fs::path& filename, bool truncate) :
+            written_sites(detail::callsite_registry::CAPACITY) {
+        file.open(filename.native(), truncate);
+
+        put_frame(buf, binary::frame::header);
+        buf.append(binary::MAGIC.data(), binary::MAGIC.data() + binary::MAGIC.size());
+        put(buf, binary::VERSION);
+        put(buf, binary::ENDIAN_MARK);
+        put(buf, nanos(startup_time()));
+        file.write(buf);
+        buf.clear();
+    }
+
+    uint32_t binary_sink::name_id(spdlog::string_view_t name) {
+        std::string key{name.data(), name.size()};
+        if (auto it = names.find(key); it != names.end())
+            return it->second;
+
+        auto id = static_cast<uint32_t>(names.size());
+        put_frame(buf, binary::frame::name);
+        put(buf, id);
+        put_str(buf, key);
+        names.emplace(std::move(key), id);
+        return id;
+    }
+
+    bool binary_sink::write_record(const spdlog::details::log_msg& msg, detail::record_kind kind) {
+        detail::record_header header;
+        if (kind != detail::record_kind::deferred or msg.payload.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, msg.payload.data(), sizeof(header));
+
+        auto* entry = detail::callsites.find(header.site);
+        if (not entry or entry->site.types.contains('x'))
+            return false;
+
+        if (not written_sites[header.site]) {
+            put_frame(buf, binary::frame::site);
+            put(buf, header.site);
+            put(buf, entry->site.line);
+            put_str(buf, entry->site.file);
+            put_str(buf, entry->site.function);
+            put_str(buf, entry->site.fmt);
+            put_str(buf, entry->site.types);
+            written_sites[header.site] = true;
+        }
+
+        auto name = name_id(msg.logger_name);
+        auto args = std::string_view{msg.payload.data(), msg.payload.size()}.substr(sizeof(header));
+
+        put_frame(buf, binary::frame::record);
+        put(buf, header.site);
+        put(buf, static_cast<uint8_t>(msg.level));
+        put(buf, nanos(msg.time));
+        put(buf, static_cast<uint64_t>(msg.thread_id));
+        put(buf, name);
+        put_str(buf, args);
+        return true;
+    }
+
+    void binary_sink::write_text(const spdlog::details::log_msg& msg, spdlog::string_view_t text) {
+        auto name = name_id(msg.logger_name);
+
+        put_frame(buf, binary::frame::text);
+        put(buf, static_cast<uint8_t>(msg.level));
+        put(buf, nanos(msg.time));
+        put(buf, static_cast<uint64_t>(msg.thread_id));
+        put(buf, name);
+        put(buf, static_cast<uint32_t>(msg.source.line));
+        put_str(buf, msg.source.filename ? msg.source.filename : "");
+        put_str(buf, msg.source.funcname ? msg.source.funcname : "");
+        put_str(buf, {text.data(), text.size()});
+    }
+
+    void binary_sink::write(const spdlog::details::log_msg& msg, detail::record_kind kind) {
+        buf.clear();
+
+        // only a record is more than its text; a record the decoder could not rebuild is written rendered
+        if (kind == detail::record_kind::text)
+            write_text(msg, msg.payload);
+        else if (not write_record(msg, kind)) {
+            spdlog::memory_buf_t rendered;
+            if (detail::render_deferred(kind, msg.payload, rendered))
+                write_text(msg, {rendered.data(), rendered.size()});
+            else
+                write_text(msg, msg.payload);
+        }
+
+        file.write(buf);
+    }
+
+    void binary_sink::sink_it_(const spdlog::details::log_msg& msg) {
+        write(msg, detail::record_kind::text);
+    }
+
+    void binary_sink::log_record(const spdlog::details::log_msg& msg, detail::record_kind kind) {
+        std::lock_guard lock{mutex_};
+        write(msg, kind);
+    }
+
+    void binary_sink::flush_() {
+        file.flush();
+    }
+
+    binary_reader::binary_reader(const fs::path& filename) {
+        std::ifstream in{filename, std::ios::binary};
+        if (not in)
+            throw std::runtime_error{"Cannot open binary log {}"_format(filename.string())};
+        data.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+
+        if (data.size() < 1 + binary::MAGIC.size() or
+            data[0] != static_cast<char>(binary::frame::header) or
+            std::string_view{data}.substr(1, binary::MAGIC.size()) != binary::MAGIC)
+            throw std::runtime_error{"{} is not an unlog binary log"_format(filename.string())};
+    }
+
+    bool binary_reader::read(const callback& fn) {
+        cursor in{data};
+        spdlog::memory_buf_t text;
+
+        while (not in.data.empty()) {
+            auto frame = cursor{in.data};
+            auto tag = static_cast<binary::frame>(frame.get<uint8_t>());
+
+            switch (tag) {
+                case binary::frame::header: {
+                    auto magic = frame.bytes(binary::MAGIC.size());
+                    auto version = frame.get<uint32_t>();
+                    auto order = frame.get<uint32_t>();
+                    auto start = frame.get<int64_t>();
+                    if (frame.truncated)
+                        return false;
+                    if (magic != binary::MAGIC or version != binary::VERSION)
+                        throw std::runtime_error{"Unsupported binary log header (version {})"_format(version)};
+                    if (order != binary::ENDIAN_MARK)
+                        throw std::runtime_error{"Binary log was written with a different byte order"};
+                    sites.clear();
+                    names.clear();
+                    origin = from_nanos(start);
+                    break;
+                }
+                case binary::frame::site: {
+                    auto id = frame.get<uint32_t>();
+                    site s;
+                    s.line = frame.get<uint32_t>();
+                    s.file = frame.str();
+                    s.function = frame.str();
+                    s.fmt = frame.str();
+                    s.types = frame.str();
+                    if (frame.truncated)
+                        return false;
+                    sites[id] = std::move(s);
+                    break;
+                }
+                case binary::frame::name: {
+                    auto id = frame.get<uint32_t>();
+                    auto name = frame.str();
+                    if (frame.truncated)
+                        return false;
+                    names[id] = name;
+                    break;
+                }
+                case binary::frame::record: {
+                    auto id = frame.get<uint32_t>();
+                    auto level = static_cast<LogLevel>(frame.get<uint8_t>());
+                    auto time = from_nanos(frame.get<int64_t>());
+                    auto thread = frame.get<uint64_t>();
+                    auto name = frame.get<uint32_t>();
+                    auto args = frame.str();
+                    if (frame.truncated)
+                        return false;
+
+                    auto it = sites.find(id);
+                    if (it == sites.end())
+                        throw std::runtime_error{"Record refers to unknown call site {}"_format(id)};
+                    auto& s = it->second;
+
+                    text.clear();
+                    try {
+                        fmt::dynamic_format_arg_store<fmt::format_context> store;
+                        decode_args(s.types, cursor{args}, store);
+                        fmt::vformat_to(fmt::appender(text), s.fmt, store);
+                    }
+                    catch (const std::exception& e) {
+                        text.clear();
+                        fmt::format_to(fmt::appender(text), "<undecodable record: {}> {}", e.what(), s.fmt);
+                    }
+
+                    spdlog::details::log_msg msg{
+                            time,
+                            spdlog::source_loc{s.file.c_str(), static_cast<int>(s.line), s.function.c_str()},
+                            names[name],
+                            level,
+                            spdlog::string_view_t{text.data(), text.size()}};
+                    msg.thread_id = thread;
+                    fn(msg);
+                    break;
+                }
+                case binary::frame::text: {
+                    auto level = static_cast<LogLevel>(frame.get<uint8_t>());
+                    auto time = from_nanos(frame.get<int64_t>());
+                    auto thread = frame.get<uint64_t>();
+                    auto name = frame.get<uint32_t>();
+                    auto line = frame.get<uint32_t>();
+                    std::string file{frame.str()}, function{frame.str()};
+                    auto payload = frame.str();
+                    if (frame.truncated)
+                        return false;
+
+                    spdlog::details::log_msg msg{
+                            time,
+                            spdlog::source_loc{
+                                    file.empty() ? nullptr : file.c_str(),
+                                    static_cast<int>(line),
+                                    function.empty() ? nullptr : function.c_str()},
+                            names[name],
+                            level,
+                            spdlog::string_view_t{payload.data(), payload.size()}};
+                    msg.thread_id = thread;
+                    fn(msg);
+                    break;
+                }
+                default:
+                    throw std::runtime_error{"Corrupt binary log: unknown frame tag {}"_format(static_cast<int>(tag))};
+            }
+
+            in.data = frame.data;
+        }
+        return true;
+    }
+
+}  // namespace un::log
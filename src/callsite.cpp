@@ -0,0 +1,26 @@
+#include "unlog/callsite.hpp"
+
+namespace un::log::detail {
+
+    callsite_registry callsites{};
+
+    callsite_id callsite_registry::insert(const callsite& site, spdlog::level::level_enum level, render_fn render) {
+        std::lock_guard lock{insert_mutex};
+
+        // another thread may have registered the same site while we waited
+        auto i = site.key & MASK;
+        for (size_t probe = 0; probe < MAX_PROBE; ++probe, i = (i + 1) & MASK) {
+            auto k = keys[i].load(std::memory_order_relaxed);
+            if (k == site.key)
+                return static_cast<callsite_id>(i);
+            if (k == 0) {
+                entries[i] = entry{site, level, render};
+                keys[i].store(site.key, std::memory_order_release);
+                count.fetch_add(1, std::memory_order_relaxed);
+                return static_cast<callsite_id>(i);
+            }
+        }
+        return NO_CALLSITE;
+    }
+
+}  // namespace un::log::detail
@@ -0,0 +1,140 @@
+#include "unlog/clock.hpp"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define UNLOG_HAVE_RDTSC 1
+#endif
+
+namespace un::log::detail {
+
+    tsc_clock tsc_source{};
+    std::atomic<bool> tsc_enabled{false};
+
+    namespace {
+        int64_t wall_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(spdlog::log_clock::now().time_since_epoch())
+                    .count();
+        }
+
+        uint64_t steady_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now().time_since_epoch())
+                                                 .count());
+        }
+
+        // nanoseconds per tick as 32.32 fixed point
+        uint64_t multiplier(int64_t elapsed_ns, uint64_t elapsed_ticks) {
+            if (elapsed_ns <= 0 or elapsed_ticks == 0)
+                return uint64_t{1} << 32;
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(elapsed_ns) << 32) / elapsed_ticks);
+        }
+    }  // namespace
+
+    tsc_clock::~tsc_clock() {
+        tsc_enabled.store(false, std::memory_order_release);
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        cv.notify_all();
+        if (calibrator.joinable())
+            calibrator.join();
+    }
+
+    bool tsc_clock::invariant_tsc() {
+#ifdef UNLOG_HAVE_RDTSC
+        unsigned int eax, ebx, ecx, edx;
+        if (not __get_cpuid(0x8000'0000, &eax, &ebx, &ecx, &edx) or eax < 0x8000'0007)
+            return false;
+        __get_cpuid(0x8000'0007, &eax, &ebx, &ecx, &edx);
+        return edx & (1u << 8);
+#else
+        return false;
+#endif
+    }
+
+    uint64_t tsc_clock::ticks() const {
+#ifdef UNLOG_HAVE_RDTSC
+        if (use_tsc)
+            return __rdtsc();
+#endif
+        return steady_ns();
+    }
+
+    spdlog::log_clock::time_point tsc_clock::now() const {
+        auto t = ticks();
+
+        uint64_t seq, at, m;
+        int64_t an;
+        do {
+            seq = sequence.load(std::memory_order_acquire);
+            at = anchor_ticks.load(std::memory_order_relaxed);
+            an = anchor_ns.load(std::memory_order_relaxed);
+            m = mult.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (seq & 1 or seq != sequence.load(std::memory_order_relaxed));
+
+        // the counter may have been read just before a recalibration moved the anchor past it
+        auto delta = t >= at ? static_cast<int64_t>(static_cast<unsigned __int128>(t - at) * m >> 32)
+                             : -static_cast<int64_t>(static_cast<unsigned __int128>(at - t) * m >> 32);
+
+        return spdlog::log_clock::time_point{
+                std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds{an + delta})};
+    }
+
+    void tsc_clock::publish(uint64_t ticks, int64_t ns, uint64_t multiplier) {
+        auto seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchor_ticks.store(ticks, std::memory_order_relaxed);
+        anchor_ns.store(ns, std::memory_order_relaxed);
+        mult.store(multiplier, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    void tsc_clock::start() {
+        std::unique_lock lock{mutex};
+        if (calibrator.joinable())
+            return;
+
+        use_tsc = invariant_tsc();
+        base_ticks = ticks();
+        base_steady = std::chrono::steady_clock::now();
+
+        // a short initial measurement, refined by every recalibration as the baseline grows
+        if (use_tsc)
+            std::this_thread::sleep_for(10ms);
+        lock.unlock();
+        recalibrate();
+        lock.lock();
+
+        calibrator = std::thread{[this] {
+            std::unique_lock lock{mutex};
+            while (not cv.wait_for(lock, RECALIBRATE_INTERVAL, [this] { return stopping; })) {
+                lock.unlock();
+                recalibrate();
+                lock.lock();
+            }
+        }};
+    }
+
+    void tsc_clock::recalibrate() {
+        auto t = ticks();
+        auto steady = std::chrono::steady_clock::now();
+        auto wall = wall_ns();
+
+        auto m = use_tsc ? multiplier(
+                                   std::chrono::duration_cast<std::chrono::nanoseconds>(steady - base_steady).count(),
+                                   t - base_ticks)
+                         : uint64_t{1} << 32;
+        publish(t, wall, m);
+    }
+
+    void set_clock(Clock clock) {
+        if (clock == Clock::tsc)
+            tsc_source.start();
+        tsc_enabled.store(clock == Clock::tsc, std::memory_order_release);
+    }
+
+}  // namespace un::log::detail
@@ -0,0 +1,53 @@
+#include "unlog/deferred.hpp"
+
+#include "unlog/logger.hpp"
+
+namespace un::log::detail {
+
+    bool render_deferred(record_kind kind, spdlog::string_view_t payload, spdlog::memory_buf_t& out) {
+        if (fields_view fields; kind == record_kind::fields and read_fields(payload, fields)) {
+            render_fields(fields, out);
+            return true;
+        }
+
+        record_header header;
+        if (kind != record_kind::deferred or payload.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, payload.data(), sizeof(header));
+
+        auto* entry = callsites.find(header.site);
+        if (not entry or not entry->render)
+            return false;
+
+        entry->render(entry->site.fmt, reinterpret_cast<const std::byte*>(payload.data() + sizeof(header)), out);
+        return true;
+    }
+
+    spdlog::details::log_msg rendered_copy(
+            const spdlog::details::log_msg& msg, record_kind kind, spdlog::memory_buf_t& buf, fields_scope& fields) {
+        spdlog::details::log_msg text{msg};
+        if (render_deferred(kind, msg.payload, buf)) {
+            text.payload = spdlog::string_view_t{buf.data(), buf.size()};
+            fields.set(kind, msg.payload, text.payload);
+        }
+        return text;
+    }
+
+    void deferred_sink::log(const spdlog::details::log_msg& msg) {
+        master_sink->log(msg);
+    }
+
+    void deferred_sink::log_record(const spdlog::details::log_msg& msg, record_kind kind) {
+        master_sink->log_record(msg, kind);
+    }
+
+    void deferred_sink::flush() {
+        master_sink->flush();
+    }
+
+    const std::shared_ptr<deferred_sink>& get_deferred_sink() {
+        static auto sink = std::make_shared<deferred_sink>();
+        return sink;
+    }
+
+}  // namespace un::log::detail
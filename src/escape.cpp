@@ -0,0 +1,427 @@
+#include "unlog/escape.hpp"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define UNLOG_ESCAPE_X86 1
+#endif
+
+namespace un::log::detail {
+    using namespace std::literals;
+
+    namespace {
+        constexpr char HEX[]{"0123456789abcdef"};
+
+        using scan_fn = size_t (*)(const char* data, size_t size);
+
+        template <bool Json>
+        size_t scan_scalar(const char* data, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                auto c = static_cast<unsigned char>(data[i]);
+                if (c < 0x20 or c >= 0x7f or (Json and (c == '"' or c == '\\')))
+                    return i;
+            }
+            return size;
+        }
+
+#if UNLOG_ESCAPE_X86
+        // Bytes from 0x80 up are negative as signed bytes, so one signed compare against 0x20 catches them together
+        // with the control bytes
+        template <bool Json>
+        size_t scan_sse2(const char* data, size_t size) {
+            const auto space = _mm_set1_epi8(0x20);
+            const auto del = _mm_set1_epi8(0x7f);
+            const auto quote = _mm_set1_epi8('"');
+            const auto backslash = _mm_set1_epi8('\\');
+
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto hit = _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del));
+                if constexpr (Json)
+                    hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+                if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(hit)))
+                    return i + std::countr_zero(mask);
+            }
+            return i + scan_scalar<Json>(data + i, size - i);
+        }
+#endif
+
+        template <bool Json>
+        bool special_ascii(unsigned char c) {
+            return c < 0x20 or c == 0x7f or (Json and (c == '"' or c == '\\'));
+        }
+
+        template <bool Json>
+        size_t utf8_scalar(const char* data, size_t size) {
+            size_t i = 0;
+            while (i < size) {
+                auto c = static_cast<unsigned char>(data[i]);
+                if (c < 0x80) {
+                    if (special_ascii<Json>(c))
+                        break;
+                    ++i;
+                }
+                else if (auto n = utf8_sequence({data + i, size - i}))
+                    i += n;
+                else
+                    break;
+            }
+            return i;
+        }
+
+#if UNLOG_ESCAPE_X86
+        // Backs `i` up to the start of the sequence it falls inside, given valid UTF-8 before it
+        size_t utf8_boundary(const char* data, size_t i) {
+            for (size_t back = 1; back <= std::min<size_t>(i, 3); ++back) {
+                auto c = static_cast<unsigned char>(data[i - back]);
+                if ((c & 0xc0) == 0x80)
+                    continue;
+                size_t n = c < 0x80 ? 1 : c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : 2;
+                return n > back ? i - back : i;
+            }
+            return i;
+        }
+
+        /*  UTF-8 check (Keiser and Lemire, "Validating UTF-8 in less than one instruction per byte")
+
+            Every error within two bytes is told by the high nibble of the first, its low nibble and the high nibble
+            of the second: each of three 16-entry tables maps a nibble to the error classes it takes part in, and a
+            byte pair is in error where the three results share a bit. What is left is the length of three and four
+            byte sequences, checked by matching the bytes two and three after such a lead against the continuation
+            bytes that no two-byte class accounted for (TWO_CONTS).
+        */
+        constexpr uint8_t TOO_SHORT{1 << 0};   // lead not followed by a continuation
+        constexpr uint8_t TOO_LONG{1 << 1};    // ASCII followed by a continuation
+        constexpr uint8_t OVERLONG_3{1 << 2};  // 11100000 100_____
+        constexpr uint8_t TOO_LARGE{1 << 3};   // past U+10FFFF
+        constexpr uint8_t SURROGATE{1 << 4};   // 11101101 101_____
+        constexpr uint8_t OVERLONG_2{1 << 5};  // 1100000_ 10______
+        constexpr uint8_t TOO_LARGE_1000{1 << 6};
+        constexpr uint8_t OVERLONG_4{1 << 6};  // 11110000 1000____
+        constexpr uint8_t TWO_CONTS{1 << 7};   // two continuations in a row
+        constexpr uint8_t CARRY{TOO_SHORT | TOO_LONG | TWO_CONTS};
+
+        alignas(16) constexpr uint8_t BYTE_1_HIGH[16]{
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TOO_LONG,
+                TWO_CONTS,
+                TWO_CONTS,
+                TWO_CONTS,
+                TWO_CONTS,
+                TOO_SHORT | OVERLONG_2,
+                TOO_SHORT,
+                TOO_SHORT | OVERLONG_3 | SURROGATE,
+                TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+
+        alignas(16) constexpr uint8_t BYTE_1_LOW[16]{
+                CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                CARRY | OVERLONG_2,
+                CARRY,
+                CARRY,
+                CARRY | TOO_LARGE,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000};
+
+        alignas(16) constexpr uint8_t BYTE_2_HIGH[16]{
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT,
+                TOO_SHORT};
+
+        __attribute__((target("avx2"))) __m256i lookup(const uint8_t (&table)[16], __m256i index) {
+            auto t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+            return _mm256_shuffle_epi8(t, index);
+        }
+
+        __attribute__((target("avx2"))) __m256i high_nibbles(__m256i v) {
+            return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+        }
+
+        // The 32 bytes ending N bytes before the end of `input`, the first of them from `prev`
+        template <int N>
+        __attribute__((target("avx2"))) __m256i prev_bytes(__m256i input, __m256i prev) {
+            return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+        }
+
+        // Nonzero in the bytes of `input` that break UTF-8, `prev` being the 32 bytes before it
+        __attribute__((target("avx2"))) __m256i utf8_errors(__m256i input, __m256i prev) {
+            auto prev1 = prev_bytes<1>(input, prev);
+            auto pairs = _mm256_and_si256(
+                    _mm256_and_si256(
+                            lookup(BYTE_1_HIGH, high_nibbles(prev1)),
+                            lookup(BYTE_1_LOW, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+                    lookup(BYTE_2_HIGH, high_nibbles(input)));
+
+            // only 111_____ two bytes back and 1111____ three bytes back keep the top bit
+            auto third = _mm256_subs_epu8(prev_bytes<2>(input, prev), _mm256_set1_epi8(0xe0 - 0x80));
+            auto fourth = _mm256_subs_epu8(prev_bytes<3>(input, prev), _mm256_set1_epi8(0xf0 - 0x80));
+            auto top = _mm256_set1_epi8(static_cast<char>(0x80));
+            auto continued = _mm256_and_si256(_mm256_or_si256(third, fourth), top);
+            return _mm256_xor_si256(continued, pairs);
+        }
+
+        // Whether the 32 bytes of `v` are valid UTF-8, following `prev`, without a byte escape<Json> stops at
+        template <bool Json>
+        __attribute__((target("avx2"))) bool clean_utf8(__m256i v, __m256i prev) {
+            auto bad = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v),
+                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+            if constexpr (Json)
+                bad = _mm256_or_si256(
+                        bad,
+                        _mm256_or_si256(
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+            bad = _mm256_or_si256(bad, utf8_errors(v, prev));
+            return _mm256_testz_si256(bad, bad);
+        }
+
+        // Checks whole blocks; the first one that fails is left to the caller, from the sequence it starts inside.
+        // The tail is checked padded with ASCII, which also catches a sequence cut short by the end of the text.
+        template <bool Json>
+        __attribute__((target("avx2"))) size_t utf8_avx2(const char* data, size_t size) {
+            auto prev = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                if (not clean_utf8<Json>(v, prev))
+                    return utf8_boundary(data, i);
+                prev = v;
+            }
+            if (i < size) {
+                char tail[32];
+                std::memset(tail, 'x', sizeof(tail));
+                std::memcpy(tail, data + i, size - i);
+                if (clean_utf8<Json>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail)), prev))
+                    return size;
+            }
+            return utf8_boundary(data, i);
+        }
+
+        template <bool Json>
+        __attribute__((target("avx2"))) size_t scan_avx2(const char* data, size_t size) {
+            const auto space = _mm256_set1_epi8(0x20);
+            const auto del = _mm256_set1_epi8(0x7f);
+            const auto quote = _mm256_set1_epi8('"');
+            const auto backslash = _mm256_set1_epi8('\\');
+
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                auto hit = _mm256_or_si256(_mm256_cmpgt_epi8(space, v), _mm256_cmpeq_epi8(v, del));
+                if constexpr (Json)
+                    hit = _mm256_or_si256(
+                            hit, _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+                if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit)))
+                    return i + std::countr_zero(mask);
+            }
+            return i + scan_sse2<Json>(data + i, size - i);
+        }
+#endif
+
+        struct kernel {
+            std::string_view name;
+            scan_fn text;
+            scan_fn json;
+            scan_fn text_utf8;
+            scan_fn json_utf8;
+        };
+
+        kernel select_kernel() {
+#if UNLOG_ESCAPE_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return {"avx2"sv, &scan_avx2<false>, &scan_avx2<true>, &utf8_avx2<false>, &utf8_avx2<true>};
+            return {"sse2"sv, &scan_sse2<false>, &scan_sse2<true>, &utf8_scalar<false>, &utf8_scalar<true>};
+#else
+            return {"scalar"sv, &scan_scalar<false>, &scan_scalar<true>, &utf8_scalar<false>, &utf8_scalar<true>};
+#endif
+        }
+
+        // function-local, so formatters used during static initialization elsewhere find it ready
+        const kernel& active_kernel() {
+            static const kernel k = select_kernel();
+            return k;
+        }
+
+        void append(std::string_view s, spdlog::memory_buf_t& out) {
+            out.append(s.data(), s.data() + s.size());
+        }
+
+        void append_hex(std::string_view prefix, unsigned char c, spdlog::memory_buf_t& out) {
+            append(prefix, out);
+            const char digits[]{HEX[c >> 4], HEX[c & 0xf]};
+            out.append(digits, digits + sizeof(digits));
+        }
+
+        // Copies `s` to `out` from `from`, a position the scan has already stopped at (or s.size())
+        template <bool Json>
+        void escape(std::string_view s, size_t from, spdlog::memory_buf_t& out) {
+            auto scan = Json ? active_kernel().json : active_kernel().text;
+            auto utf8 = Json ? active_kernel().json_utf8 : active_kernel().text_utf8;
+            out.append(s.data(), s.data() + from);
+
+            for (size_t i = from; i < s.size();) {
+                auto c = static_cast<unsigned char>(s[i]);
+                if (c >= 0x80) {
+                    // a run of valid text is copied whole; failing that, one sequence at a time
+                    auto n = utf8(s.data() + i, s.size() - i);
+                    if (n == 0)
+                        n = utf8_sequence(s.substr(i));
+                    if (n) {
+                        out.append(s.data() + i, s.data() + i + n);
+                        i += n;
+                    }
+                    else {
+                        Json ? append("\\ufffd"sv, out) : append_hex("\\x"sv, c, out);
+                        ++i;
+                    }
+                }
+                else if constexpr (Json) {
+                    switch (c) {
+                        case '"':
+                            append("\\\""sv, out);
+                            break;
+                        case '\\':
+                            append("\\\\"sv, out);
+                            break;
+                        case '\n':
+                            append("\\n"sv, out);
+                            break;
+                        case '\r':
+                            append("\\r"sv, out);
+                            break;
+                        case '\t':
+                            append("\\t"sv, out);
+                            break;
+                        default:
+                            append_hex("\\u00"sv, c, out);
+                    }
+                    ++i;
+                }
+                else {
+                    if (c == '\t')
+                        out.push_back('\t');
+                    else
+                        append_hex("\\x"sv, c, out);
+                    ++i;
+                }
+
+                auto next = i + scan(s.data() + i, s.size() - i);
+                out.append(s.data() + i, s.data() + next);
+                i = next;
+            }
+        }
+    }  // namespace
+
+    size_t scan_special(std::string_view s, bool json) {
+        auto& k = active_kernel();
+        return (json ? k.json : k.text)(s.data(), s.size());
+    }
+
+    size_t scan_special_scalar(std::string_view s, bool json) {
+        return json ? scan_scalar<true>(s.data(), s.size()) : scan_scalar<false>(s.data(), s.size());
+    }
+
+    size_t scan_utf8(std::string_view s, bool json) {
+        auto& k = active_kernel();
+        return (json ? k.json_utf8 : k.text_utf8)(s.data(), s.size());
+    }
+
+    size_t scan_utf8_scalar(std::string_view s, bool json) {
+        return json ? utf8_scalar<true>(s.data(), s.size()) : utf8_scalar<false>(s.data(), s.size());
+    }
+
+    std::string_view escape_kernel() {
+        return active_kernel().name;
+    }
+
+    size_t utf8_sequence(std::string_view s) {
+        auto at = [&s](size_t i) { return static_cast<unsigned char>(s[i]); };
+        if (s.empty())
+            return 0;
+
+        auto c = at(0);
+        if (c < 0x80)
+            return 1;
+
+        // the ranges of the second byte rule out overlong forms, surrogates and code points past U+10FFFF
+        size_t n;
+        unsigned char low = 0x80, high = 0xbf;
+        if (c >= 0xc2 and c <= 0xdf)
+            n = 2;
+        else if (c == 0xe0)
+            n = 3, low = 0xa0;
+        else if (c == 0xed)
+            n = 3, high = 0x9f;
+        else if (c >= 0xe1 and c <= 0xef)
+            n = 3;
+        else if (c == 0xf0)
+            n = 4, low = 0x90;
+        else if (c >= 0xf1 and c <= 0xf3)
+            n = 4;
+        else if (c == 0xf4)
+            n = 4, high = 0x8f;
+        else
+            return 0;
+
+        if (s.size() < n or at(1) < low or at(1) > high)
+            return 0;
+        for (size_t i = 2; i < n; ++i)
+            if ((at(i) & 0xc0) != 0x80)
+                return 0;
+        return n;
+    }
+
+    void escape_json(std::string_view s, spdlog::memory_buf_t& out) {
+        escape<true>(s, scan_special(s, true), out);
+    }
+
+    void escape_text(std::string_view s, spdlog::memory_buf_t& out) {
+        escape<false>(s, scan_special(s, false), out);
+    }
+
+    void sanitizing_formatter::format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) {
+        std::string_view text{msg.payload.data(), msg.payload.size()};
+        auto from = scan_special(text, false);
+        if (from == text.size())
+            return inner->format(msg, dest);
+
+        spdlog::memory_buf_t clean;
+        escape<false>(text, from, clean);
+        auto sanitized = msg;
+        sanitized.payload = spdlog::string_view_t{clean.data(), clean.size()};
+        inner->format(sanitized, dest);
+    }
+
+}  // namespace un::log::detail
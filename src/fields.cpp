@@ -0,0 +1,216 @@
+#include "unlog/fields.hpp"
+
+#include "unlog/escape.hpp"
+
+#include <spdlog/details/os.h>
+
+#include <cmath>
+
+namespace un::log {
+
+    namespace detail {
+        namespace {
+            struct delivery {
+                const char* text{nullptr};
+                fields_view fields;
+            };
+
+            thread_local delivery current;
+
+            bool needs_quotes(std::string_view s) {
+                return s.empty() or s.find_first_of(" =") != s.npos or scan_special(s, true) != s.size();
+            }
+
+            void append(std::string_view s, spdlog::memory_buf_t& out) {
+                out.append(s.data(), s.data() + s.size());
+            }
+
+            void append_value(const field_view& f, spdlog::memory_buf_t& out, bool json) {
+                switch (f.type) {
+                    case 'b':
+                        return append(f.b ? "true"sv : "false"sv, out);
+                    case 'l':
+                        fmt::format_to(fmt::appender(out), "{}", f.l);
+                        return;
+                    case 'L':
+                        fmt::format_to(fmt::appender(out), "{}", f.u);
+                        return;
+                    case 'd':
+                        // JSON has no literal for these
+                        if (json and not std::isfinite(f.d))
+                            return append_json(std::isnan(f.d) ? "nan"sv : f.d > 0 ? "inf"sv : "-inf"sv, out);
+                        fmt::format_to(fmt::appender(out), "{}", f.d);
+                        return;
+                    default:
+                        return json ? append_json(f.s, out) : append_logfmt(f.s, out);
+                }
+            }
+
+            std::string_view level_name(spdlog::level::level_enum level) {
+                auto name = spdlog::level::to_string_view(level);
+                return {name.data(), name.size()};
+            }
+        }  // namespace
+
+        bool read_fields(spdlog::string_view_t payload, fields_view& out) {
+            fields_header header;
+            if (payload.size() < sizeof(header))
+                return false;
+            std::memcpy(&header, payload.data(), sizeof(header));
+            if (payload.size() - sizeof(header) < header.text_size)
+                return false;
+
+            std::string_view record{payload.data(), payload.size()};
+            out.text = record.substr(sizeof(header), header.text_size);
+            out.data = record.substr(sizeof(header) + header.text_size);
+            out.count = header.count;
+            // every field is checked once here, so a record that gets through is safe to walk
+            return out.each([](const field_view&) {});
+        }
+
+        void append_json(std::string_view s, spdlog::memory_buf_t& out) {
+            out.push_back('"');
+            escape_json(s, out);
+            out.push_back('"');
+        }
+
+        void append_logfmt(std::string_view s, spdlog::memory_buf_t& out) {
+            if (needs_quotes(s))
+                append_json(s, out);
+            else
+                append(s, out);
+        }
+
+        void append_logfmt_key(std::string_view s, spdlog::memory_buf_t& out) {
+            if (s.empty())
+                return out.push_back('_');
+            for (size_t i = 0; i < s.size();) {
+                auto c = static_cast<unsigned char>(s[i]);
+                auto n = c < 0x80 ? size_t{1} : utf8_sequence(s.substr(i));
+                if (n == 0 or c <= 0x20 or c == '=' or c == '"' or c == 0x7f) {
+                    out.push_back('_');
+                    ++i;
+                    continue;
+                }
+                out.append(s.data() + i, s.data() + i + n);
+                i += n;
+            }
+        }
+
+        void render_fields(const fields_view& fields, spdlog::memory_buf_t& out) {
+            append(fields.text, out);
+            fields.each([&out](const field_view& f) {
+                out.push_back(' ');
+                append(f.key, out);
+                out.push_back('=');
+                append_value(f, out, false);
+            });
+        }
+
+        fields_scope::~fields_scope() {
+            if (active)
+                current.text = nullptr;
+        }
+
+        void fields_scope::set(record_kind kind, spdlog::string_view_t payload, spdlog::string_view_t text) {
+            if (kind == record_kind::fields and read_fields(payload, current.fields)) {
+                current.text = text.data();
+                active = true;
+            }
+        }
+
+        const fields_view* delivered_fields(const spdlog::details::log_msg& msg) {
+            if (current.text and msg.payload.data() == current.text)
+                return &current.fields;
+            return nullptr;
+        }
+
+        void structured_formatter::append_time(spdlog::log_clock::time_point time, spdlog::memory_buf_t& dest) {
+            auto since_epoch = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+            auto second = since_epoch / 1'000'000;
+            auto micros = since_epoch % 1'000'000;
+            if (micros < 0) {
+                --second;
+                micros += 1'000'000;
+            }
+
+            // re-render the date and time only when the second changes
+            if (second != cached_second) {
+                auto tm = spdlog::details::os::gmtime(static_cast<std::time_t>(second));
+                auto result = fmt::format_to_n(
+                        prefix.data(),
+                        prefix.size(),
+                        "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}",
+                        tm.tm_year + 1900,
+                        tm.tm_mon + 1,
+                        tm.tm_mday,
+                        tm.tm_hour,
+                        tm.tm_min,
+                        tm.tm_sec);
+                prefix_size = std::min(result.size, prefix.size());
+                cached_second = second;
+            }
+
+            dest.append(prefix.data(), prefix.data() + prefix_size);
+            fmt::format_to(fmt::appender(dest), ".{:06}Z", micros);
+        }
+    }  // namespace detail
+
+    void json_formatter::format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) {
+        auto* fields = detail::delivered_fields(msg);
+        std::string_view text = fields ? fields->text : std::string_view{msg.payload.data(), msg.payload.size()};
+
+        detail::append(R"({"time":")"sv, dest);
+        append_time(msg.time, dest);
+        detail::append(R"(","level":")"sv, dest);
+        detail::append(detail::level_name(msg.level), dest);
+        detail::append(R"(","logger":)"sv, dest);
+        detail::append_json({msg.logger_name.data(), msg.logger_name.size()}, dest);
+        if (not msg.source.empty()) {
+            detail::append(R"(,"source":")"sv, dest);
+            detail::escape_json(msg.source.filename, dest);
+            fmt::format_to(fmt::appender(dest), R"(:{}")", msg.source.line);
+        }
+        detail::append(R"(,"msg":)"sv, dest);
+        detail::append_json(text, dest);
+
+        if (fields)
+            fields->each([&dest](const detail::field_view& f) {
+                dest.push_back(',');
+                detail::append_json(f.key, dest);
+                dest.push_back(':');
+                detail::append_value(f, dest, true);
+            });
+        detail::append("}\n"sv, dest);
+    }
+
+    void logfmt_formatter::format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) {
+        auto* fields = detail::delivered_fields(msg);
+        std::string_view text = fields ? fields->text : std::string_view{msg.payload.data(), msg.payload.size()};
+
+        detail::append("time="sv, dest);
+        append_time(msg.time, dest);
+        detail::append(" level="sv, dest);
+        detail::append(detail::level_name(msg.level), dest);
+        detail::append(" logger="sv, dest);
+        detail::append_logfmt({msg.logger_name.data(), msg.logger_name.size()}, dest);
+        if (not msg.source.empty()) {
+            spdlog::memory_buf_t source;
+            fmt::format_to(fmt::appender(source), "{}:{}", msg.source.filename, msg.source.line);
+            detail::append(" source="sv, dest);
+            detail::append_logfmt({source.data(), source.size()}, dest);
+        }
+        detail::append(" msg="sv, dest);
+        detail::append_logfmt(text, dest);
+
+        if (fields)
+            fields->each([&dest](const detail::field_view& f) {
+                dest.push_back(' ');
+                detail::append_logfmt_key(f.key, dest);
+                dest.push_back('=');
+                detail::append_value(f, dest, false);
+            });
+        dest.push_back('\n');
+    }
+
+}  // namespace un::log
@@ -0,0 +1,769 @@
+#include "unlog/file_sinks.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef UNLOG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <ranges>
+
+namespace un::log {
+
+    namespace {
+        size_t page_size() {
+            static const auto size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        std::string error_string(int err) {
+            return std::strerror(err);
+        }
+
+        // Reserves [offset, offset + size) on disk, extending the file if needed
+        void preallocate(int fd, size_t offset, size_t size) {
+#ifdef __linux__
+            if (::fallocate(fd, 0, static_cast<off_t>(offset), static_cast<off_t>(size)) == 0)
+                return;
+            if (errno != EOPNOTSUPP)
+                throw std::runtime_error{"fallocate failed: {}"_format(error_string(errno))};
+#endif
+            if (auto err = ::posix_fallocate(fd, static_cast<off_t>(offset), static_cast<off_t>(size)); err != 0)
+                throw std::runtime_error{"posix_fallocate failed: {}"_format(error_string(err))};
+        }
+
+        // Length of the data in the file, ignoring a NUL tail preallocated by a writer that never closed it
+        size_t data_end(int fd) {
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+                throw std::runtime_error{"fstat failed: {}"_format(error_string(errno))};
+
+            auto end = static_cast<size_t>(st.st_size);
+            std::array<char, 4096> block;
+            while (end > 0) {
+                auto n = std::min(end, block.size());
+                if (::pread(fd, block.data(), n, static_cast<off_t>(end - n)) != static_cast<ssize_t>(n))
+                    throw std::runtime_error{"pread failed: {}"_format(error_string(errno))};
+                for (auto i = n; i > 0; --i)
+                    if (block[i - 1] != '\0')
+                        return end - n + i;
+                end -= n;
+            }
+            return 0;
+        }
+
+        constexpr size_t WRITE_BUFFER{64 << 10};
+
+        int open_append(const fs::path& path) {
+            auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0)
+                throw std::runtime_error{"Failed to open log file {}: {}"_format(path.string(), error_string(errno))};
+            return fd;
+        }
+
+        size_t file_size(int fd) {
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+                throw std::runtime_error{"fstat failed: {}"_format(error_string(errno))};
+            return static_cast<size_t>(st.st_size);
+        }
+
+        void write_all(int fd, const char* data, size_t size) {
+            while (size > 0) {
+                auto n = ::write(fd, data, size);
+                if (n < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::runtime_error{"write failed: {}"_format(error_string(errno))};
+                }
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+        }
+
+        // First multiple of `interval` since the epoch after `t`
+        spdlog::log_clock::time_point next_boundary(spdlog::log_clock::time_point t, std::chrono::seconds interval) {
+            auto since = std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch());
+            return spdlog::log_clock::time_point{(since / interval + 1) * interval};
+        }
+
+        // Sequence number of `name` if it is an archive of `live` (stem.N.ext, optionally .gz), otherwise 0
+        uint64_t archive_number(const fs::path& live, std::string_view name) {
+            auto stem = live.stem().string();
+            auto ext = live.extension().string();
+            if (name.ends_with(".gz"))
+                name.remove_suffix(3);
+            if (name.size() <= stem.size() + 1 + ext.size() or not name.starts_with(stem) or
+                name[stem.size()] != '.' or not name.ends_with(ext))
+                return 0;
+
+            name = name.substr(stem.size() + 1, name.size() - stem.size() - 1 - ext.size());
+            uint64_t n = 0;
+            auto [end, ec] = std::from_chars(name.data(), name.data() + name.size(), n);
+            return ec == std::errc{} and end == name.data() + name.size() ? n : 0;
+        }
+
+#ifdef UNLOG_HAVE_ZLIB
+        // Replaces `path` by path.gz; leaves the original in place if anything fails
+        void compress(const fs::path& path, int level) {
+            auto gz_path = path;
+            gz_path += ".gz";
+
+            auto in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in < 0)
+                return;
+            auto* out = ::gzopen(gz_path.c_str(), "wb{}"_format_view(level).data());
+
+            bool ok = out != nullptr;
+            std::vector<char> block(1 << 16);
+            while (ok) {
+                auto n = ::read(in, block.data(), block.size());
+                if (n < 0 and errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    ok = n == 0;
+                    break;
+                }
+                ok = ::gzwrite(out, block.data(), static_cast<unsigned>(n)) == n;
+            }
+            if (out and ::gzclose(out) != Z_OK)
+                ok = false;
+            ::close(in);
+
+            std::error_code ec;
+            fs::remove(ok ? path : gz_path, ec);
+        }
+#endif
+    }  // namespace
+
+    template <typename Mutex>
+    mmap_file_sink<Mutex>::mmap_file_sink(const fs::path& filename, MmapPolicy p) : policy{p} {
+        auto page = page_size();
+        policy.chunk_size = std::max(page, (policy.chunk_size + page - 1) / page * page);
+
+        if (filename.has_parent_path())
+            fs::create_directories(filename.parent_path());
+
+        fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+            throw std::runtime_error{"Failed to open log file {}: {}"_format(filename.string(), error_string(errno))};
+
+        try {
+            auto end = data_end(fd);
+            map_chunk(end / policy.chunk_size * policy.chunk_size);
+            position = synced = end - chunk_offset;
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    template <typename Mutex>
+    mmap_file_sink<Mutex>::~mmap_file_sink() {
+        if (chunk)
+            unmap_chunk(false);
+        // trim the preallocated tail; a failure only leaves NUL padding, which the next writer skips
+        [[maybe_unused]] auto rc = ::ftruncate(fd, static_cast<off_t>(size()));
+        ::close(fd);
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::map_chunk(size_t offset) {
+        preallocate(fd, offset, policy.chunk_size);
+
+        auto* addr = ::mmap(
+                nullptr, policy.chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+        if (addr == MAP_FAILED)
+            throw std::runtime_error{"mmap failed: {}"_format(error_string(errno))};
+        ::madvise(addr, policy.chunk_size, MADV_SEQUENTIAL);
+
+        chunk = static_cast<char*>(addr);
+        chunk_offset = offset;
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::sync_range(size_t from, size_t to, int flags) {
+        if (from >= to)
+            return;
+        auto start = from / page_size() * page_size();
+        ::msync(chunk + start, to - start, flags);
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::unmap_chunk(bool finished) {
+        if (policy.sync != MmapPolicy::Sync::none)
+            sync_range(synced, position, policy.sync == MmapPolicy::Sync::sync ? MS_SYNC : MS_ASYNC);
+
+        ::munmap(chunk, policy.chunk_size);
+        chunk = nullptr;
+
+        // starts writeback of the chunk and evicts whatever of it is already clean
+        if (finished and policy.drop_behind)
+            ::posix_fadvise(
+                    fd, static_cast<off_t>(chunk_offset), static_cast<off_t>(policy.chunk_size), POSIX_FADV_DONTNEED);
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::write(const char* data, size_t size) {
+        while (size > 0) {
+            if (position == policy.chunk_size) {
+                unmap_chunk(true);
+                map_chunk(chunk_offset + policy.chunk_size);
+                position = synced = 0;
+            }
+
+            auto n = std::min(size, policy.chunk_size - position);
+            std::memcpy(chunk + position, data, n);
+            position += n;
+            data += n;
+            size -= n;
+        }
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::sink_it_(const spdlog::details::log_msg& msg) {
+        formatted.clear();
+        this->formatter_->format(msg, formatted);
+        write(formatted.data(), formatted.size());
+    }
+
+    template <typename Mutex>
+    void mmap_file_sink<Mutex>::flush_() {
+        if (policy.sync == MmapPolicy::Sync::none)
+            return;
+        sync_range(synced, position, policy.sync == MmapPolicy::Sync::sync ? MS_SYNC : MS_ASYNC);
+        synced = position;
+    }
+
+    template class mmap_file_sink<std::mutex>;
+    template class mmap_file_sink<spdlog::details::null_mutex>;
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    /*  Minimal io_uring driver for the batched sink's writer thread
+
+        One submission at a time, set up and entered through the raw syscalls so there is no liburing dependency.
+        The rings are only touched from the writer thread; the kernel side is synchronised through acquire/release
+        on the head and tail indices. Any failure of the ring itself (as opposed to the write it carries) sets
+        broken(), and the sink falls back to pwritev.
+    */
+    class detail::uring {
+        int ring_fd{-1};
+        void* sq_ring{MAP_FAILED};
+        size_t sq_ring_size{0};
+        void* cq_ring{MAP_FAILED};
+        size_t cq_ring_size{0};
+        io_uring_sqe* sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+        size_t sqes_size{0};
+
+        unsigned* sq_head{nullptr};
+        unsigned* sq_tail{nullptr};
+        unsigned* sq_mask{nullptr};
+        unsigned* sq_array{nullptr};
+        unsigned* cq_head{nullptr};
+        unsigned* cq_tail{nullptr};
+        unsigned* cq_mask{nullptr};
+        io_uring_cqe* cqes{nullptr};
+        bool failed{false};
+
+        static constexpr unsigned ENTRIES{4};
+
+        template <typename T>
+        static T* at(void* base, uint32_t off) {
+            return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+        }
+
+        int enter(unsigned to_submit, unsigned min_complete) {
+            return static_cast<int>(
+                    ::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+        }
+
+        bool setup() {
+            io_uring_params params{};
+            ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, ENTRIES, &params));
+            if (ring_fd < 0)
+                return false;
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single)
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+            sq_ring = ::mmap(
+                    nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED)
+                return false;
+            if (single)
+                cq_ring = sq_ring;
+            else if (cq_ring = ::mmap(
+                             nullptr,
+                             cq_ring_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE,
+                             ring_fd,
+                             IORING_OFF_CQ_RING);
+                     cq_ring == MAP_FAILED)
+                return false;
+
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(::mmap(
+                    nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+            if (sqes == MAP_FAILED)
+                return false;
+
+            sq_head = at<unsigned>(sq_ring, params.sq_off.head);
+            sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+            sq_mask = at<unsigned>(sq_ring, params.sq_off.ring_mask);
+            sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+            cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+            cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+            cq_mask = at<unsigned>(cq_ring, params.cq_off.ring_mask);
+            cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+            return true;
+        }
+
+      public:
+        // nullptr when io_uring is unavailable: old kernel, io_uring_disabled, or a seccomp filter
+        static std::unique_ptr<uring> create() {
+            auto ring = std::make_unique<uring>();
+            if (not ring->setup())
+                return nullptr;
+            return ring;
+        }
+
+        ~uring() {
+            if (sqes != MAP_FAILED)
+                ::munmap(sqes, sqes_size);
+            if (cq_ring != MAP_FAILED and cq_ring != sq_ring)
+                ::munmap(cq_ring, cq_ring_size);
+            if (sq_ring != MAP_FAILED)
+                ::munmap(sq_ring, sq_ring_size);
+            if (ring_fd >= 0)
+                ::close(ring_fd);
+        }
+
+        bool broken() const { return failed; }
+
+        // Same result convention as pwritev, except that an error is returned as -errno
+        ssize_t writev(int fd, const iovec* iov, int count, size_t offset) {
+            auto tail = *sq_tail;
+            auto index = tail & *sq_mask;
+            auto& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_WRITEV;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(iov);
+            sqe.len = static_cast<uint32_t>(count);
+            sqe.off = offset;
+            sq_array[index] = index;
+            std::atomic_ref{*sq_tail}.store(tail + 1, std::memory_order_release);
+
+            while (true) {
+                auto head = std::atomic_ref{*cq_head}.load(std::memory_order_relaxed);
+                if (head != std::atomic_ref{*cq_tail}.load(std::memory_order_acquire)) {
+                    auto res = cqes[head & *cq_mask].res;
+                    std::atomic_ref{*cq_head}.store(head + 1, std::memory_order_release);
+                    return res;
+                }
+                // an interrupted enter may or may not have consumed the submission
+                bool pending = std::atomic_ref{*sq_head}.load(std::memory_order_acquire) != tail + 1;
+                if (enter(pending ? 1 : 0, 1) < 0 and errno != EINTR) {
+                    failed = true;
+                    return -errno;
+                }
+            }
+        }
+    };
+#else
+    class detail::uring {
+      public:
+        static std::unique_ptr<uring> create() { return nullptr; }
+        bool broken() const { return true; }
+        ssize_t writev(int, const iovec*, int, size_t) { return -ENOSYS; }
+    };
+#endif
+
+    template <typename Mutex>
+    batched_file_sink<Mutex>::batched_file_sink(const fs::path& filename, BatchPolicy p) : policy{p} {
+        policy.buffer_size = std::max(policy.buffer_size, size_t{4096});
+        policy.max_buffers = std::max(policy.max_buffers, size_t{1});
+        policy.interval = std::max(policy.interval, std::chrono::milliseconds{1});
+
+        if (filename.has_parent_path())
+            fs::create_directories(filename.parent_path());
+
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+            throw std::runtime_error{"Failed to open log file {}: {}"_format(filename.string(), error_string(errno))};
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto err = errno;
+            ::close(fd);
+            throw std::runtime_error{"fstat failed: {}"_format(error_string(err))};
+        }
+        offset = static_cast<size_t>(st.st_size);
+
+        ring = detail::uring::create();
+        totals.uring = ring != nullptr;
+        current = fresh_buffer();
+        writer = std::thread{&batched_file_sink::run, this};
+    }
+
+    template <typename Mutex>
+    batched_file_sink<Mutex>::~batched_file_sink() {
+        {
+            std::unique_lock lock{queue_mutex};
+            hand_off(lock);
+            stopping = true;
+            writer_cv.notify_one();
+        }
+        writer.join();
+        ::close(fd);
+    }
+
+    template <typename Mutex>
+    auto batched_file_sink<Mutex>::fresh_buffer() -> buffer_ptr {
+        if (spare.empty()) {
+            auto b = std::make_unique<buffer>();
+            b->data.reserve(policy.buffer_size);
+            return b;
+        }
+        auto b = std::move(spare.back());
+        spare.pop_back();
+        return b;
+    }
+
+    // Queues the current buffer for the writer, waiting for room if max_buffers are already queued
+    template <typename Mutex>
+    void batched_file_sink<Mutex>::hand_off(std::unique_lock<std::mutex>& lock) {
+        if (current->data.size() == 0)
+            return;
+        producer_cv.wait(lock, [this] { return full.size() < policy.max_buffers; });
+        full.push_back(std::move(current));
+        current = fresh_buffer();
+        writer_cv.notify_one();
+    }
+
+    template <typename Mutex>
+    void batched_file_sink<Mutex>::sink_it_(const spdlog::details::log_msg& msg) {
+        formatted.clear();
+        this->formatter_->format(msg, formatted);
+
+        std::unique_lock lock{queue_mutex};
+        current->data.append(formatted.data(), formatted.data() + formatted.size());
+        ++current->messages;
+        if (current->data.size() >= policy.buffer_size)
+            hand_off(lock);
+    }
+
+    template <typename Mutex>
+    void batched_file_sink<Mutex>::flush_() {
+        std::unique_lock lock{queue_mutex};
+        hand_off(lock);
+        auto ticket = ++flush_requested;
+        writer_cv.notify_one();
+        producer_cv.wait(lock, [&] { return flush_completed >= ticket; });
+    }
+
+    template <typename Mutex>
+    batch_stats batched_file_sink<Mutex>::stats() {
+        std::lock_guard lock{queue_mutex};
+        return totals;
+    }
+
+    template <typename Mutex>
+    void batched_file_sink<Mutex>::run() {
+        std::vector<buffer_ptr> batch;
+        std::unique_lock lock{queue_mutex};
+
+        while (true) {
+            bool woken = writer_cv.wait_for(lock, policy.interval, [this] {
+                return not full.empty() or flush_requested != flush_completed or stopping;
+            });
+            // nothing filled a buffer for a whole interval: write out what there is
+            if (not woken and current->data.size() > 0) {
+                full.push_back(std::move(current));
+                current = fresh_buffer();
+            }
+
+            if (full.empty()) {
+                if (stopping)
+                    break;
+                flush_completed = flush_requested;
+                producer_cv.notify_all();
+                continue;
+            }
+
+            auto ticket = flush_requested;
+            while (not full.empty()) {
+                batch.push_back(std::move(full.front()));
+                full.pop_front();
+            }
+            producer_cv.notify_all();
+
+            lock.unlock();
+            auto written = write_batch(batch);
+            lock.lock();
+
+            uint64_t messages = 0;
+            for (auto& b : batch) {
+                messages += b->messages;
+                b->data.clear();
+                b->messages = 0;
+                spare.push_back(std::move(b));
+            }
+            batch.clear();
+
+            ++totals.batches;
+            totals.messages += messages;
+            totals.bytes += written;
+            totals.largest_batch = std::max<uint64_t>(totals.largest_batch, written);
+            totals.write_errors = write_errors;
+            totals.uring = ring != nullptr;
+
+            flush_completed = ticket;
+            producer_cv.notify_all();
+        }
+    }
+
+    // Writes the buffers back to back at the end of the file; returns the number of bytes written. A failed write
+    // drops the rest of the batch: the error is counted, and there is nobody on this thread to report it to.
+    template <typename Mutex>
+    size_t batched_file_sink<Mutex>::write_batch(const std::vector<buffer_ptr>& batch) {
+        std::vector<iovec> iov;
+        iov.reserve(batch.size());
+        for (auto& b : batch)
+            if (b->data.size() > 0)
+                iov.push_back({b->data.data(), b->data.size()});
+
+        size_t written = 0;
+        size_t first = 0;
+        while (first < iov.size()) {
+            auto count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+            ssize_t n;
+            if (ring) {
+                n = ring->writev(fd, &iov[first], count, offset);
+                if (ring->broken()) {
+                    ring.reset();
+                    continue;
+                }
+            }
+            else if (n = ::pwritev(fd, &iov[first], count, static_cast<off_t>(offset)); n < 0)
+                n = -errno;
+
+            if (n == -EINTR or n == -EAGAIN)
+                continue;
+            if (n <= 0) {
+                ++write_errors;
+                break;
+            }
+
+            written += static_cast<size_t>(n);
+            offset += static_cast<size_t>(n);
+            for (auto left = static_cast<size_t>(n); left > 0;) {
+                if (left >= iov[first].iov_len) {
+                    left -= iov[first].iov_len;
+                    ++first;
+                }
+                else {
+                    iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+                    iov[first].iov_len -= left;
+                    left = 0;
+                }
+            }
+        }
+        return written;
+    }
+
+    template class batched_file_sink<std::mutex>;
+    template class batched_file_sink<spdlog::details::null_mutex>;
+
+    template <typename Mutex>
+    rotating_file_sink<Mutex>::rotating_file_sink(const fs::path& filename, RotationPolicy p) :
+            live{filename}, policy{p} {
+        if (not policy.enabled())
+            throw std::invalid_argument{"Rotation needs a size or an interval"};
+#ifndef UNLOG_HAVE_ZLIB
+        if (policy.compression > 0)
+            throw std::invalid_argument{"unlog was built without zlib: rotated logs cannot be compressed"};
+#endif
+
+        spare_path = live.parent_path() / ".{}.next"_format(live.filename().string());
+        auto dir = live.has_parent_path() ? live.parent_path() : fs::path{"."};
+        fs::create_directories(dir);
+        for (const auto& entry : fs::directory_iterator{dir})
+            sequence = std::max(sequence, archive_number(live, entry.path().filename().string()));
+
+        fd = open_append(live);
+        try {
+            written = file_size(fd);
+            spare_fd = open_append(spare_path);
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+
+        if (policy.interval.count() > 0)
+            next_rotation = next_boundary(spdlog::log_clock::now(), policy.interval);
+        pending.reserve(WRITE_BUFFER);
+        worker = std::thread{&rotating_file_sink::run, this};
+    }
+
+    template <typename Mutex>
+    rotating_file_sink<Mutex>::~rotating_file_sink() {
+        try {
+            write_pending();
+        }
+        catch (...) {
+        }
+        {
+            std::lock_guard lock{rotation_mutex};
+            stopping = true;
+            worker_cv.notify_one();
+        }
+        worker.join();
+        ::close(fd);
+
+        // the pre-opened spare is only left behind if something already went into it
+        if (spare_fd >= 0) {
+            struct stat st;
+            bool empty = ::fstat(spare_fd, &st) == 0 and st.st_size == 0;
+            ::close(spare_fd);
+            if (empty) {
+                std::error_code ec;
+                fs::remove(spare_path, ec);
+            }
+        }
+    }
+
+    template <typename Mutex>
+    fs::path rotating_file_sink<Mutex>::archive_path(uint64_t n) const {
+        return live.parent_path() / "{}.{}{}"_format(live.stem().string(), n, live.extension().string());
+    }
+
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::write_pending() {
+        write_all(fd, pending.data(), pending.size());
+        pending.clear();
+    }
+
+    // Swaps to the spare file if the worker has one ready; returns false (and changes nothing) otherwise
+    template <typename Mutex>
+    bool rotating_file_sink<Mutex>::rotate() {
+        std::lock_guard lock{rotation_mutex};
+        if (spare_fd < 0 or retired_fd >= 0)
+            return false;
+
+        write_pending();
+        retired_fd = fd;
+        fd = spare_fd;
+        spare_fd = -1;
+        written = 0;
+        worker_cv.notify_one();
+        return true;
+    }
+
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::sink_it_(const spdlog::details::log_msg& msg) {
+        formatted.clear();
+        this->formatter_->format(msg, formatted);
+
+        if (msg.time >= next_rotation) {
+            if (rotate())
+                next_rotation = next_boundary(msg.time, policy.interval);
+        }
+        else if (policy.max_size > 0 and written > 0 and written + formatted.size() > policy.max_size)
+            rotate();
+
+        pending.append(formatted.data(), formatted.data() + formatted.size());
+        written += formatted.size();
+        if (pending.size() >= WRITE_BUFFER)
+            write_pending();
+    }
+
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::flush_() {
+        write_pending();
+    }
+
+    // Renames the retired file and its successor into place, opens the next spare, then compresses and prunes. If a
+    // rename or the open fails, no spare is offered again: rotation stops and logging carries on in the current file,
+    // rather than risk a rename replacing a file that still holds data.
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::run() {
+        std::unique_lock lock{rotation_mutex};
+        while (true) {
+            worker_cv.wait(lock, [this] { return retired_fd >= 0 or stopping; });
+            if (retired_fd < 0)
+                break;
+            auto old_fd = retired_fd;
+            lock.unlock();
+
+            auto target = archive_path(++sequence);
+            std::error_code ec;
+            fs::rename(live, target, ec);
+            if (not ec)
+                fs::rename(spare_path, live, ec);
+            ::close(old_fd);
+
+            int next = -1;
+            if (not ec)
+                next = ::open(spare_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+            lock.lock();
+            retired_fd = -1;
+            spare_fd = next;
+            lock.unlock();
+
+            if (not ec)
+                archive(target);
+            lock.lock();
+        }
+    }
+
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::archive([[maybe_unused]] const fs::path& file) {
+#ifdef UNLOG_HAVE_ZLIB
+        if (policy.compression > 0)
+            compress(file, policy.compression);
+#endif
+        if (policy.max_files > 0)
+            prune();
+    }
+
+    // Removes all but the newest max_files archives
+    template <typename Mutex>
+    void rotating_file_sink<Mutex>::prune() {
+        std::vector<std::pair<uint64_t, fs::path>> archives;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator{live.has_parent_path() ? live.parent_path() : fs::path{"."}, ec})
+            if (auto n = archive_number(live, entry.path().filename().string()))
+                archives.emplace_back(n, entry.path());
+        if (archives.size() <= policy.max_files)
+            return;
+
+        std::ranges::sort(archives, std::greater{});
+        for (auto& old : archives | std::views::drop(policy.max_files))
+            fs::remove(old.second, ec);
+    }
+
+    template class rotating_file_sink<std::mutex>;
+    template class rotating_file_sink<spdlog::details::null_mutex>;
+}  // namespace un::log
@@ -0,0 +1,154 @@
+#include "unlog/format.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define UNLOG_BYTES_SSE2 1
+#endif
+
+namespace un::log::detail {
+
+    namespace {
+        constexpr char HEX_LOWER[]{"0123456789abcdef"};
+        constexpr char HEX_UPPER[]{"0123456789ABCDEF"};
+        constexpr char BASE64[]{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+        // The two digits of every byte value, so a byte is one 2-char copy
+        constexpr auto make_hex_pairs(const char (&digits)[17]) {
+            std::array<char, 512> pairs{};
+            for (size_t i = 0; i < 256; ++i) {
+                pairs[2 * i] = digits[i >> 4];
+                pairs[2 * i + 1] = digits[i & 0xf];
+            }
+            return pairs;
+        }
+
+        constexpr auto HEX_PAIRS_LOWER = make_hex_pairs(HEX_LOWER);
+        constexpr auto HEX_PAIRS_UPPER = make_hex_pairs(HEX_UPPER);
+
+        // The two base64 characters of every 12-bit value, so a 3-byte group is two 2-char copies
+        constexpr auto BASE64_PAIRS = [] {
+            std::array<char, 8192> pairs{};
+            for (size_t i = 0; i < 4096; ++i) {
+                pairs[2 * i] = BASE64[i >> 6];
+                pairs[2 * i + 1] = BASE64[i & 0x3f];
+            }
+            return pairs;
+        }();
+
+        char* hex_scalar(const unsigned char* data, size_t size, char* out, const std::array<char, 512>& pairs) {
+            for (size_t i = 0; i < size; ++i, out += 2)
+                std::memcpy(out, &pairs[2 * data[i]], 2);
+            return out;
+        }
+
+#if UNLOG_BYTES_SSE2
+        // Splits 16 bytes into their nibbles, turns each into '0' + n, plus the gap up to 'a' (or 'A') where n > 9,
+        // and interleaves the high and low digits into 32 chars
+        char* hex_sse2(const unsigned char* data, size_t size, char* out, bool upper) {
+            const auto nibble = _mm_set1_epi8(0x0f);
+            const auto zero = _mm_set1_epi8('0');
+            const auto nine = _mm_set1_epi8(9);
+            const auto gap = _mm_set1_epi8(static_cast<char>((upper ? 'A' : 'a') - '9' - 1));
+            auto digits = [&](__m128i n) {
+                return _mm_add_epi8(_mm_add_epi8(n, zero), _mm_and_si128(_mm_cmpgt_epi8(n, nine), gap));
+            };
+
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16, out += 32) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto high = digits(_mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                auto low = digits(_mm_and_si128(v, nibble));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(high, low));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(high, low));
+            }
+            return hex_scalar(data + i, size - i, out, upper ? HEX_PAIRS_UPPER : HEX_PAIRS_LOWER);
+        }
+#endif
+
+        char* hex(const unsigned char* data, size_t size, char* out, bool upper) {
+#if UNLOG_BYTES_SSE2
+            return hex_sse2(data, size, out, upper);
+#else
+            return hex_scalar(data, size, out, upper ? HEX_PAIRS_UPPER : HEX_PAIRS_LOWER);
+#endif
+        }
+
+        char* base64(const unsigned char* data, size_t size, char* out) {
+            size_t i = 0;
+            for (; i + 3 <= size; i += 3, out += 4) {
+                uint32_t group = uint32_t{data[i]} << 16 | uint32_t{data[i + 1]} << 8 | data[i + 2];
+                std::memcpy(out, &BASE64_PAIRS[2 * (group >> 12)], 2);
+                std::memcpy(out + 2, &BASE64_PAIRS[2 * (group & 0xfff)], 2);
+            }
+
+            if (auto rest = size - i) {
+                uint32_t group = uint32_t{data[i]} << 16 | (rest > 1 ? uint32_t{data[i + 1]} << 8 : 0);
+                out[0] = BASE64[group >> 18];
+                out[1] = BASE64[(group >> 12) & 0x3f];
+                out[2] = rest > 1 ? BASE64[(group >> 6) & 0x3f] : '=';
+                out[3] = '=';
+                out += 4;
+            }
+            return out;
+        }
+
+        // One line per 16 bytes: "\n00000010  2e 2f 30 31 32 33 34 35  36 37 38 39 3a 3b 3c 3d  |./0123456789:;<=|"
+        char* dump(const unsigned char* data, size_t size, size_t offset, char* out) {
+            for (size_t line = 0; line < size; line += 16) {
+                auto at = static_cast<uint64_t>(offset + line);
+                auto n = std::min<size_t>(16, size - line);
+
+                *out++ = '\n';
+                for (int shift = (at >> 32) ? 60 : 28; shift >= 0; shift -= 4)
+                    *out++ = HEX_LOWER[(at >> shift) & 0xf];
+                out = std::ranges::fill_n(out, 2, ' ');
+
+                for (size_t i = 0; i < 16; ++i) {
+                    if (i < n)
+                        std::memcpy(out, &HEX_PAIRS_LOWER[2 * data[line + i]], 2);
+                    else
+                        std::memcpy(out, "  ", 2);
+                    out[2] = ' ';
+                    out += 3;
+                    if (i == 7)
+                        *out++ = ' ';
+                }
+
+                *out++ = ' ';
+                *out++ = '|';
+                for (size_t i = 0; i < n; ++i) {
+                    auto c = data[line + i];
+                    *out++ = c >= 0x20 and c < 0x7f ? static_cast<char>(c) : '.';
+                }
+                *out++ = '|';
+            }
+            return out;
+        }
+    }  // namespace
+
+    __attribute__((visibility("default"))) fmt::memory_buffer& scratch_buffer() {
+        thread_local fmt::memory_buffer buf;
+        return buf;
+    }
+
+    size_t encode_bytes(bytes_mode mode, const unsigned char* data, size_t size, size_t offset, char* out) {
+        char* end;
+        switch (mode) {
+            case bytes_mode::upper_hex:
+                end = hex(data, size, out, true);
+                break;
+            case bytes_mode::base64:
+                end = base64(data, size, out);
+                break;
+            case bytes_mode::dump:
+                end = dump(data, size, offset, out);
+                break;
+            default:
+                end = hex(data, size, out, false);
+        }
+        return static_cast<size_t>(end - out);
+    }
+
+}  // namespace un::log::detail
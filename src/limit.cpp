@@ -0,0 +1,6 @@
+#include "unlog/limit.hpp"
+
+namespace un::log::detail {
+    std::array<limit_state, callsite_registry::CAPACITY> limits{};
+    limit_table overflow_limits{};
+}  // namespace un::log::detail
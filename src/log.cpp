@@ -1,43 +1,49 @@
 #include "unlog.hpp"
 
+#include "unlog/escape.hpp"
 #include "unlog/logger.hpp"
+#include "unlog/pattern.hpp"
 
 namespace un::log {
     //
-    const auto started_at = std::chrono::steady_clock::now();
-
-    // Custom log formatting flag that prints the elapsed time since startup
-    class startup_elapsed_flag : public spdlog::custom_flag_formatter {
-      private:
-        static constexpr fmt::format_string<
-                std::chrono::hours::rep,
-                std::chrono::minutes::rep,
-                std::chrono::seconds::rep,
-                std::chrono::milliseconds::rep>
-                format_hours{"+{0:d}h{1:02d}m{2:02d}.{3:03d}s"},  // >= 1h
-                format_minutes{"+{1:d}m{2:02d}.{3:03d}s"},        // >= 1min
-                format_seconds{"+{2:d}.{3:03d}s"};                // < 1min
-
-      public:
-        void format(const spdlog::details::log_msg&, const std::tm&, spdlog::memory_buf_t& dest) override {
-            using namespace std::literals;
-            auto elapsed = std::chrono::steady_clock::now() - started_at;
-
-            dest.append(
-                    fmt::format(
-                            elapsed >= 1h     ? format_hours
-                            : elapsed >= 1min ? format_minutes
-                                              : format_seconds,
-                            std::chrono::duration_cast<std::chrono::hours>(elapsed).count(),
-                            (std::chrono::duration_cast<std::chrono::minutes>(elapsed) % 1h).count(),
-                            (std::chrono::duration_cast<std::chrono::seconds>(elapsed) % 1min).count(),
-                            (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed) % 1s).count()));
-        }
+    spdlog::log_clock::time_point startup_time() {
+        // function-local so formatters built during static initialization in other translation units see it
+        static const auto started_at = spdlog::log_clock::now();
+        return started_at;
+    }
+
+    // pins the origin to load time rather than to the first formatter
+    [[maybe_unused]] const auto started_at = startup_time();
+
+    void startup_elapsed_flag::format(
+            const spdlog::details::log_msg& msg, const std::tm&, spdlog::memory_buf_t& dest) {
+        using namespace std::literals;
+
+        auto elapsed = std::max(msg.time - origin, spdlog::log_clock::duration::zero());
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
 
-        std::unique_ptr<custom_flag_formatter> clone() const override {
-            return std::make_unique<startup_elapsed_flag>();
+        // re-render "+XhYYmZZ." / "+YmZZ." / "+Z." only when the second changes
+        if (auto second = millis / 1000; second != cached_second) {
+            auto h = second / 3600, m = second / 60 % 60, s = second % 60;
+            auto* out = prefix.data();
+            auto n = prefix.size();
+            auto result = elapsed >= 1h     ? fmt::format_to_n(out, n, "+{}h{:02}m{:02}.", h, m, s)
+                          : elapsed >= 1min ? fmt::format_to_n(out, n, "+{}m{:02}.", m, s)
+                                            : fmt::format_to_n(out, n, "+{}.", s);
+            prefix_size = std::min(result.size, n);
+            cached_second = second;
         }
-    };
+
+        auto ms = millis % 1000;
+        const char suffix[]{
+                static_cast<char>('0' + ms / 100),
+                static_cast<char>('0' + ms / 10 % 10),
+                static_cast<char>('0' + ms % 10),
+                's'};
+
+        dest.append(prefix.data(), prefix.data() + prefix_size);
+        dest.append(suffix, suffix + sizeof(suffix));
+    }
 
     template <typename T, typename U>
     bool is_instance(const U* ptr) {
@@ -50,32 +56,84 @@ namespace un::log {
                is_instance<spdlog::sinks::ansicolor_stderr_sink_mt>(s);
     }
 
-    void set_sink_format(const spdlog::sink_ptr& sink, std::optional<std::string> pattern = std::nullopt) {
-        auto formatter = std::make_unique<spdlog::pattern_formatter>();
-        formatter->add_flag<startup_elapsed_flag>('*');
-        if (pattern)
-            formatter->set_pattern(*std::move(pattern));
-        else if (is_color_sink(sink))
-            formatter->set_pattern(DEFAULT_PATTERN_COLOR);
+    std::unique_ptr<spdlog::formatter> make_formatter(const spdlog::sink_ptr& sink, const Config& conf) {
+        if (conf.layout == Layout::json)
+            return std::make_unique<json_formatter>();
+        if (conf.layout == Layout::logfmt)
+            return std::make_unique<logfmt_formatter>();
+
+        // the default patterns are compiled, also when a runtime pattern spells one of them out
+        auto compiled = conf.compiled;
+        if (not compiled and not conf.format)
+            compiled = is_color_sink(sink) ? DEFAULT_COMPILED_PATTERN_COLOR : DEFAULT_COMPILED_PATTERN;
+        else if (not compiled and *conf.format == DEFAULT_PATTERN)
+            compiled = DEFAULT_COMPILED_PATTERN;
+        else if (not compiled and *conf.format == DEFAULT_PATTERN_COLOR)
+            compiled = DEFAULT_COMPILED_PATTERN_COLOR;
+
+        std::unique_ptr<spdlog::formatter> formatter;
+        if (compiled)
+            formatter = compiled.make(conf.utc);
+        else {
+            auto runtime = std::make_unique<spdlog::pattern_formatter>(
+                    conf.utc ? spdlog::pattern_time_type::utc : spdlog::pattern_time_type::local);
+            runtime->add_flag<startup_elapsed_flag>('*');
+            runtime->set_pattern(*conf.format);
+            formatter = std::move(runtime);
+        }
+        if (conf.sanitize)
+            return std::make_unique<detail::sanitizing_formatter>(std::move(formatter));
+        return formatter;
+    }
+
+    void set_sink_format(
+            const spdlog::sink_ptr& sink, const Config& conf, std::shared_ptr<detail::sink_meter> meter = nullptr) {
+        auto formatter = make_formatter(sink, conf);
+        if (meter)
+            sink->set_formatter(std::make_unique<detail::metered_formatter>(std::move(formatter), std::move(meter)));
         else
-            formatter->set_pattern(DEFAULT_PATTERN);
-        sink->set_formatter(std::move(formatter));
+            sink->set_formatter(std::move(formatter));
     }
 
     namespace detail {
-        void add_sink(sink_ptr sink) {
-            set_sink_format(sink);
+        // Puts a sink chosen for `conf` behind the wrappers it asks for. The master sink takes no lock, so sinks for a
+        // non-threadsafe config get one of their own; record sinks take raw records and are never wrapped.
+        sink_ptr wrap(const Config& conf, sink_ptr sink) {
+            if (dynamic_cast<const record_sink*>(sink.get()))
+                return sink;
+            if (not conf.threadsafe())
+                sink = std::make_shared<serialized_sink>(std::move(sink));
+            if (conf.dedup_window.count() > 0)
+                sink = std::make_shared<dedup_sink>(std::move(sink), conf.dedup_window);
+            return sink;
+        }
+
+        void add_sink(sink_ptr sink, bool threadsafe) {
+            auto conf = Config::make_default("sink");
+            if (threadsafe)
+                conf.flags |= Flags::threadsafe;
+            auto meter = meters().create("sink");
+            set_sink_format(sink, conf, meter);
+            sink = wrap(conf, std::move(sink));
+            meters().attach(meter, sink);
             master_sink->add_sink(std::move(sink));
         }
 
+        // Formats and wraps a sink for `conf`, metered under the config's name (see stats.hpp)
+        sink_ptr prepare(const Config& conf, sink_ptr sink) {
+            auto meter = meters().create("{}:{}"_format(conf.name, type_string(conf.type)));
+            set_sink_format(sink, conf, meter);
+            sink = wrap(conf, std::move(sink));
+            meters().attach(meter, sink);
+            return sink;
+        }
+
         void add_sink(const Config& conf, sink_ptr sink) {
-            set_sink_format(sink, conf.format);
-            master_sink->add_sink(std::move(sink));
+            master_sink->add_sink(prepare(conf, std::move(sink)));
         }
 
         void set_sinks(const Config& conf, sink_ptr sink) {
-            set_sink_format(sink, conf.format);
-            master_sink->set_sinks({std::move(sink)});
+            master_sink->set_sinks({prepare(conf, std::move(sink))});
         }
     }  // namespace detail
 
@@ -1,20 +1,26 @@
 #include "unlog.hpp"
 
+#include "unlog/binary.hpp"
+#include "unlog/file_sinks.hpp"
+#include "unlog/shm.hpp"
+
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/stdout_sinks.h>
 
+#include <unistd.h>
+
 namespace un::log {
     using namespace un::log::literals;
 
     inline auto get_master_sink() {
-        static std::shared_ptr<spdlog::sinks::dist_sink_mt> ms;
+        static std::shared_ptr<fanout_sink> ms;
         if (not ms)
-            ms = std::make_shared<spdlog::sinks::dist_sink_mt>();
+            ms = std::make_shared<fanout_sink>();
         return ms;
     }
 
-    std::shared_ptr<spdlog::sinks::dist_sink_mt> master_sink = get_master_sink();
+    std::shared_ptr<fanout_sink> master_sink = get_master_sink();
 
     namespace detail {
         __attribute__((visibility("default"))) std::unordered_map<std::string, logger_ptr>& loggers() {
@@ -26,8 +32,11 @@ namespace un::log {
                 uint8_t thread_count = 1, uint32_t pool_size = 8192) {
             static std::shared_ptr<spdlog::details::thread_pool> tp;
             if (!tp) {
-                spdlog::init_thread_pool(pool_size, thread_count);
+                spdlog::init_thread_pool(pool_size, thread_count, [] { set_backend_meter(&pool_meter); });
                 tp = spdlog::thread_pool();
+                pool_meter.depth.store(
+                        [] { return spdlog::thread_pool() ? spdlog::thread_pool()->queue_size() : size_t{0}; },
+                        std::memory_order_release);
             }
             return tp;
         }
@@ -57,6 +66,18 @@ namespace un::log {
             return default_log_level();
         }
 
+        std::atomic<LogLevel> min_level{LogLevel::info};
+
+        // Recomputes min_level from the default level, every registered logger and the flight recorder; requires
+        // loggers_mutex
+        void update_min_level() {
+            auto level = std::min(default_log_level(), recorder.level());
+            for (auto& [_, logger] : loggers())
+                if (logger)
+                    level = std::min(level, logger->level());
+            min_level.store(level, std::memory_order_relaxed);
+        }
+
         void for_each_logger(std::function<void(logger_ptr&)> hook) {
             if (hook) {
                 std::lock_guard lock{detail::loggers_mutex()};
@@ -66,11 +87,11 @@ namespace un::log {
             }
         }
 
-        void for_each_sink(std::function<void(sink_ptr&)> hook) {
+        void for_each_sink(std::function<void(const sink_ptr&)> hook) {
             if (hook) {
-                auto& sinks = master_sink->sinks();
+                auto sinks = master_sink->sinks();
 
-                for (auto& sink : sinks)
+                for (auto& sink : *sinks)
                     hook(sink);
             }
         }
@@ -78,12 +99,18 @@ namespace un::log {
         void set_default_level(LogLevel level) {
             default_log_level() = level;
             default_logger()->set_level(level);
-            for_each_sink([level](sink_ptr& sink) { sink->set_level(level); });
+            for_each_sink([level](const sink_ptr& sink) { sink->set_level(level); });
         }
 
         void make_logger(const Config& conf, bool make_default) {
             default_logger()->make_logger(conf, make_default);
         }
+
+        void set_flight_recorder(const RecorderPolicy& policy) {
+            recorder.configure(policy);
+            std::lock_guard lock{loggers_mutex()};
+            update_min_level();
+        }
     }  // namespace detail
 
     const logger_ptr& global_logger() {
@@ -105,12 +132,13 @@ namespace un::log {
         auto& maybe_logger = detail::loggers()[logger_name];
 
         if (!maybe_logger) {
-            maybe_logger = std::make_shared<spdlog::logger>(logger_name, get_master_sink());
+            maybe_logger = std::make_shared<detail::sync_logger>(logger_name, get_master_sink());
             set_sinks<spdlog::sinks::stdout_color_sink_mt>(config);
         }
 
         logger = maybe_logger;
         logger->set_level(detail::default_log_level());
+        detail::update_min_level();
         have_logger = true;
     }
 
@@ -167,6 +195,36 @@ namespace un::log {
                 }
             }
         }
+        else if (conf.file_log() && conf.rotation.enabled()) {
+            if (conf.threadsafe()) {
+                make_default ? set_sinks<rotating_file_sink_mt>(conf, conf.file(), conf.rotation)
+                             : add_sink<rotating_file_sink_mt>(conf, conf.file(), conf.rotation);
+            }
+            else {
+                make_default ? set_sinks<rotating_file_sink_st>(conf, conf.file(), conf.rotation)
+                             : add_sink<rotating_file_sink_st>(conf, conf.file(), conf.rotation);
+            }
+        }
+        else if (conf.file_log() && conf.file_backend == FileBackend::mmap) {
+            if (conf.threadsafe()) {
+                make_default ? set_sinks<mmap_file_sink_mt>(conf, conf.file(), conf.mmap)
+                             : add_sink<mmap_file_sink_mt>(conf, conf.file(), conf.mmap);
+            }
+            else {
+                make_default ? set_sinks<mmap_file_sink_st>(conf, conf.file(), conf.mmap)
+                             : add_sink<mmap_file_sink_st>(conf, conf.file(), conf.mmap);
+            }
+        }
+        else if (conf.file_log() && conf.file_backend == FileBackend::uring) {
+            if (conf.threadsafe()) {
+                make_default ? set_sinks<batched_file_sink_mt>(conf, conf.file(), conf.batch)
+                             : add_sink<batched_file_sink_mt>(conf, conf.file(), conf.batch);
+            }
+            else {
+                make_default ? set_sinks<batched_file_sink_st>(conf, conf.file(), conf.batch)
+                             : add_sink<batched_file_sink_st>(conf, conf.file(), conf.batch);
+            }
+        }
         else if (conf.file_log()) {
             if (conf.threadsafe()) {
                 make_default ? set_sinks<spdlog::sinks::basic_file_sink_mt>(conf, conf.file())
@@ -177,34 +235,92 @@ namespace un::log {
                              : add_sink<spdlog::sinks::basic_file_sink_st>(conf, conf.file());
             }
         }
+        else if (conf.binary_log()) {
+            // locks itself regardless of threadsafe, since it sits behind the lock-free master sink
+            make_default ? set_sinks<binary_sink>(conf, conf.file()) : add_sink<binary_sink>(conf, conf.file());
+        }
+        else if (conf.shm_log()) {
+            // locks itself, as the ring has a single producer
+            make_default ? set_sinks<shm_sink>(conf, conf.shm) : add_sink<shm_sink>(conf, conf.shm);
+        }
         else
             throw std::runtime_error{"Invalid config created: {}"_format(conf)};
     }
 
     void Logger::set_level(LogLevel level) {
+        std::lock_guard lock{detail::loggers_mutex()};
         logger->set_level(level);
+        detail::update_min_level();
     }
 
+    namespace {
+        // Maps the overflow policy of an Engine::pool logger onto spdlog's, rejecting what the pool cannot do
+        spdlog::async_overflow_policy pool_overflow(Overflow overflow) {
+            switch (overflow) {
+                case Overflow::block:
+                    return spdlog::async_overflow_policy::block;
+                case Overflow::overwrite_oldest:
+                    return spdlog::async_overflow_policy::overrun_oldest;
+#if SPDLOG_VERSION >= 11300
+                case Overflow::drop_newest:
+                    return spdlog::async_overflow_policy::discard_new;
+#endif
+                default:
+                    throw std::invalid_argument{
+                            "Overflow::{} is not supported by Engine::pool"_format(overflow_string(overflow))};
+            }
+        }
+    }  // namespace
+
     void Logger::make_logger(const Config& conf, bool make_default) {
+        conf.validate();
+
         std::lock_guard lock{detail::loggers_mutex()};
-        auto& maybe_logger = detail::loggers()[conf.name];
 
-        if (maybe_logger != nullptr)
+        if (auto it = detail::loggers().find(conf.name); it != detail::loggers().end() and it->second != nullptr)
             throw std::invalid_argument{"A logger with the name {} already exists"_format(conf.name)};
 
+        // nothing is registered until the logger and its sinks have been made, so a throw leaves the name free
+        logger_ptr made;
+
         if (conf.async()) {
-            maybe_logger = std::make_shared<spdlog::async_logger>(
-                    logger_name, get_master_sink(), detail::thread_pool(conf.threads, conf.pool_threads));
+            auto sink = conf.deferred() ? sink_ptr{detail::get_deferred_sink()} : sink_ptr{get_master_sink()};
+
+            if (conf.engine == Engine::spsc) {
+                auto& engine = detail::spsc_pool(conf.pool_threads);
+                if (conf.overflow == Overflow::spill)
+                    engine.enable_spill(
+                            conf.spill_file.value_or(fs::temp_directory_path() / "unlog-{}.spill"_format(::getpid())),
+                            conf.spill_limit);
+                made = std::make_shared<detail::spsc_logger>(logger_name, std::move(sink), engine, conf.overflow);
+            }
+            else
+                made = std::make_shared<detail::pool_logger>(
+                        logger_name,
+                        std::move(sink),
+                        detail::thread_pool(conf.threads, conf.pool_threads),
+                        pool_overflow(conf.overflow));
         }
         else {
-            maybe_logger = std::make_shared<spdlog::logger>(logger_name, get_master_sink());
+            made = std::make_shared<detail::sync_logger>(logger_name, get_master_sink());
         }
 
+        // before the sinks: the dump file may still fail to open, and replaced sinks could not be put back
+        if (conf.recorder.enabled)
+            detail::recorder.configure(conf.recorder);
+
         initialize(conf, make_default);
 
+        if (conf.clock == Clock::tsc)
+            detail::set_clock(Clock::tsc);
+
+        made->set_level(detail::default_log_level());
+        detail::loggers()[conf.name] = made;
+        detail::update_min_level();
+
         // initialize logger w/ pattern
         if (make_default) {
-            logger = maybe_logger;
+            logger = std::move(made);
             config = conf;
             logger_name = config.name;
         }
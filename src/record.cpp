@@ -0,0 +1,117 @@
+#include "unlog/record.hpp"
+
+#include "unlog/deferred.hpp"
+#include "unlog/sinks.hpp"
+
+#include <spdlog/details/thread_pool.h>
+
+namespace un::log::detail {
+
+    void deliver_record(spdlog::logger& logger, const spdlog::details::log_msg& msg, record_kind kind) {
+        spdlog::memory_buf_t buf;
+        std::optional<spdlog::details::log_msg> rendered;
+        fields_scope fields;
+
+        for (auto& sink : logger.sinks()) {
+            if (not sink->should_log(msg.level))
+                continue;
+            if (auto* records = dynamic_cast<record_sink*>(sink.get())) {
+                records->log_record(msg, kind);
+                continue;
+            }
+            if (not rendered)
+                rendered = rendered_copy(msg, kind, buf, fields);
+            sink->log(*rendered);
+        }
+
+        if (msg.level != spdlog::level::off and msg.level >= logger.flush_level())
+            for (auto& sink : logger.sinks())
+                sink->flush();
+    }
+
+    void log_record(
+            spdlog::logger& logger,
+            spdlog::log_clock::time_point time,
+            spdlog::source_loc loc,
+            spdlog::level::level_enum level,
+            spdlog::string_view_t payload,
+            record_kind kind) {
+        if (not logger.should_log(level))
+            return;
+
+        if (auto* records = dynamic_cast<record_logger*>(&logger)) {
+            spdlog::details::log_msg msg{time, loc, logger.name(), level, payload};
+            return records->log_record(msg, kind);
+        }
+
+        spdlog::memory_buf_t buf;
+        if (render_deferred(kind, payload, buf))
+            payload = spdlog::string_view_t{buf.data(), buf.size()};
+        logger.log(time, loc, level, payload);
+    }
+
+    void sync_logger::log_record(const spdlog::details::log_msg& msg, record_kind kind) {
+        SPDLOG_TRY {
+            deliver_record(*this, msg, kind);
+        }
+        SPDLOG_LOGGER_CATCH(msg.source)
+    }
+
+    std::shared_ptr<spdlog::logger> sync_logger::clone(std::string new_name) {
+        auto cloned = std::make_shared<sync_logger>(*this);
+        cloned->name_ = std::move(new_name);
+        return cloned;
+    }
+
+    // The only sink of a carrier: delivers what the pool hands the carrier to the owner's sinks as records
+    class pool_logger::carrier_sink final : public spdlog::sinks::sink {
+        pool_logger& owner;
+        record_kind kind;
+
+      public:
+        carrier_sink(pool_logger& owner, record_kind kind) : owner{owner}, kind{kind} {}
+
+        void log(const spdlog::details::log_msg& msg) override { deliver_record(owner, msg, kind); }
+        void flush() override {}
+        void set_pattern(const std::string&) override {}
+        void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+    };
+
+    pool_logger::pool_logger(
+            std::string name,
+            spdlog::sink_ptr sink,
+            std::weak_ptr<spdlog::details::thread_pool> tp,
+            spdlog::async_overflow_policy policy) :
+            spdlog::async_logger{name, std::move(sink), tp, policy},
+            pool{tp},
+            overflow{policy},
+            deferred_carrier{name, std::make_shared<carrier_sink>(*this, record_kind::deferred), tp, policy},
+            fields_carrier{name, std::make_shared<carrier_sink>(*this, record_kind::fields), tp, policy} {}
+
+    pool_logger::pool_logger(const pool_logger& other) :
+            spdlog::async_logger{other},
+            record_logger{other},
+            pool{other.pool},
+            overflow{other.overflow},
+            deferred_carrier{
+                    other.name(), std::make_shared<carrier_sink>(*this, record_kind::deferred), pool, overflow},
+            fields_carrier{other.name(), std::make_shared<carrier_sink>(*this, record_kind::fields), pool, overflow} {}
+
+    void pool_logger::log_record(const spdlog::details::log_msg& msg, record_kind kind) {
+        auto& carrier = kind == record_kind::fields ? fields_carrier : deferred_carrier;
+        SPDLOG_TRY {
+            auto tp = pool.lock();
+            if (not tp)
+                throw spdlog::spdlog_ex{"async log: thread pool doesn't exist anymore"};
+            tp->post_log(std::shared_ptr<spdlog::async_logger>{shared_from_this(), &carrier}, msg, overflow);
+        }
+        SPDLOG_LOGGER_CATCH(msg.source)
+    }
+
+    std::shared_ptr<spdlog::logger> pool_logger::clone(std::string new_name) {
+        auto cloned = std::make_shared<pool_logger>(*this);
+        cloned->name_ = std::move(new_name);
+        return cloned;
+    }
+
+}  // namespace un::log::detail
@@ -0,0 +1,408 @@
+#include "unlog/recorder.hpp"
+
+#include "unlog/pattern.hpp"
+
+#include <spdlog/details/os.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace un::log::detail {
+    using namespace un::log::literals;
+
+    flight_recorder recorder{};
+
+    namespace {
+        // the default pattern plus the thread, since a dump interleaves every thread's messages
+        const auto RECORDER_PATTERN = "[%H:%M:%S.%e] [%*] [%t] [%n:%l|%g:%#] >> %v"s;
+
+        constexpr std::array CRASH_SIGNALS{SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+
+        // Rings given back so far; a thread that found none free tries again once this moves
+        constinit std::atomic<uint64_t> released_rings{0};
+
+        // A thread's claim on its ring, given back when the thread exits
+        struct ring_lease {
+            flight_recorder::ring* ring{nullptr};
+            std::optional<uint64_t> failed_at;  // released_rings when the last attempt found no ring
+
+            ~ring_lease() {
+                if (ring) {
+                    ring->owned.store(false, std::memory_order_release);
+                    released_rings.fetch_add(1, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local ring_lease lease;
+
+        // An alternate stack for the crash handlers, so a thread that overflowed its own stack still dumps; set up once
+        // per thread unless the application already gave it one, and taken down when the thread exits
+        struct signal_stack {
+            std::unique_ptr<char[]> memory;
+            bool tried{false};
+
+            void install() {
+                if (std::exchange(tried, true))
+                    return;
+
+                stack_t current{};
+                if (::sigaltstack(nullptr, &current) != 0 or not(current.ss_flags & SS_DISABLE))
+                    return;
+
+                // the dump formats and allocates, so the bare SIGSTKSZ is not enough
+                auto size = std::max<size_t>(SIGSTKSZ, 64 * 1024);
+                memory = std::make_unique<char[]>(size);
+                stack_t stack{};
+                stack.ss_sp = memory.get();
+                stack.ss_size = size;
+                if (::sigaltstack(&stack, nullptr) != 0)
+                    memory.reset();
+            }
+
+            ~signal_stack() {
+                if (not memory)
+                    return;
+                stack_t off{};
+                off.ss_flags = SS_DISABLE;
+                ::sigaltstack(&off, nullptr);
+            }
+        };
+
+        thread_local signal_stack alt_stack;
+
+        // A consistent copy of one slot
+        struct entry {
+            int64_t time;
+            uint64_t thread;
+            spdlog::source_loc loc;
+            LogLevel level;
+            flight_recorder::kind type;
+            std::string name;
+            std::string data;
+        };
+
+        std::vector<entry> collect(const std::array<std::atomic<flight_recorder::ring*>, flight_recorder::MAX_RINGS>& rings) {
+            std::vector<entry> entries;
+            for (auto& r : rings) {
+                auto* ring = r.load(std::memory_order_acquire);
+                if (not ring)
+                    break;
+
+                // oldest position first, so equal timestamps keep their order through the stable sort
+                auto start = ring->written.load(std::memory_order_acquire);
+                for (size_t i = 0; i < ring->capacity; ++i) {
+                    auto& s = ring->slots[(start + i) & (ring->capacity - 1)];
+                    auto before = s.sequence.load(std::memory_order_acquire);
+                    if (before == 0 or before & 1)
+                        continue;
+
+                    entry e{s.time,
+                            s.thread,
+                            s.loc,
+                            static_cast<LogLevel>(s.level),
+                            s.type,
+                            std::string{s.name.data(), std::min<size_t>(s.name_size, s.name.size())},
+                            std::string{s.data.data(), std::min<size_t>(s.size, s.data.size())}};
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (s.sequence.load(std::memory_order_relaxed) != before)
+                        continue;
+                    entries.push_back(std::move(e));
+                }
+            }
+            std::ranges::stable_sort(entries, {}, &entry::time);
+            return entries;
+        }
+
+        // Builds the message handed to a sink or formatter; `text` holds the rendered record and must outlive it
+        spdlog::details::log_msg to_msg(const entry& e, spdlog::memory_buf_t& text) {
+            spdlog::string_view_t payload{e.data.data(), e.data.size()};
+            text.clear();
+            if (e.type == flight_recorder::kind::record and render_deferred(record_kind::deferred, payload, text))
+                payload = {text.data(), text.size()};
+
+            spdlog::details::log_msg msg{
+                    spdlog::log_clock::time_point{std::chrono::duration_cast<spdlog::log_clock::duration>(
+                            std::chrono::nanoseconds{e.time})},
+                    e.loc,
+                    spdlog::string_view_t{e.name.data(), e.name.size()},
+                    e.level,
+                    payload};
+            msg.thread_id = e.thread;
+            return msg;
+        }
+
+        std::unique_ptr<spdlog::formatter> make_formatter() {
+            auto formatter = std::make_unique<spdlog::pattern_formatter>();
+            formatter->add_flag<startup_elapsed_flag>('*');
+            formatter->set_pattern(RECORDER_PATTERN);
+            return formatter;
+        }
+
+        void write_all(int fd, const spdlog::memory_buf_t& buf) {
+            auto* data = buf.data();
+            auto left = buf.size();
+            while (left > 0) {
+                auto n = ::write(fd, data, left);
+                if (n < 0 and errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return;
+                data += n;
+                left -= static_cast<size_t>(n);
+            }
+        }
+
+        std::string_view signal_name(int sig) {
+            switch (sig) {
+                case SIGSEGV:
+                    return "SIGSEGV"sv;
+                case SIGBUS:
+                    return "SIGBUS"sv;
+                case SIGILL:
+                    return "SIGILL"sv;
+                case SIGFPE:
+                    return "SIGFPE"sv;
+                case SIGABRT:
+                    return "SIGABRT"sv;
+                default:
+                    return "signal"sv;
+            }
+        }
+
+        void on_crash_signal(int sig) {
+            recorder.crash_dump(signal_name(sig));
+            // the handler was reset to the default on entry (SA_RESETHAND), so this terminates as the signal would have
+            ::raise(sig);
+        }
+
+        std::terminate_handler previous_terminate{nullptr};
+
+        void on_terminate() {
+            recorder.crash_dump("std::terminate"sv);
+            if (previous_terminate)
+                previous_terminate();
+            std::abort();
+        }
+
+        // Installs the crash handlers where the application has not set its own; safe to call repeatedly
+        void install_crash_handlers() {
+            for (int sig : CRASH_SIGNALS) {
+                struct sigaction current{};
+                if (::sigaction(sig, nullptr, &current) != 0 or current.sa_handler != SIG_DFL)
+                    continue;
+
+                struct sigaction action{};
+                action.sa_handler = on_crash_signal;
+                sigemptyset(&action.sa_mask);
+                action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+                ::sigaction(sig, &action, nullptr);
+            }
+
+            if (std::get_terminate() != on_terminate)
+                previous_terminate = std::set_terminate(on_terminate);
+        }
+    }  // namespace
+
+    flight_recorder::~flight_recorder() {
+        threshold.store(LogLevel::off, std::memory_order_relaxed);
+        if (dump_fd >= 0)
+            ::close(dump_fd);
+    }
+
+    void flight_recorder::configure(const RecorderPolicy& policy) {
+        std::lock_guard lock{dump_mutex};
+
+        if (not policy.enabled) {
+            threshold.store(LogLevel::off, std::memory_order_relaxed);
+            return;
+        }
+        if (policy.records == 0)
+            throw std::invalid_argument{"The flight recorder must keep at least one record per thread"};
+
+        int fd = -1;
+        if (policy.dump_file) {
+            fd = ::open(policy.dump_file->c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0)
+                throw std::runtime_error{"Cannot open flight recorder dump file {}: {}"_format(
+                        policy.dump_file->string(), std::strerror(errno))};
+        }
+        if (dump_fd >= 0)
+            ::close(dump_fd);
+        dump_fd = fd;
+        formatter = make_formatter();
+        capacity.store(std::bit_ceil(policy.records), std::memory_order_relaxed);
+
+        if (policy.dump_on_crash) {
+            install_crash_handlers();
+            alt_stack.install();
+        }
+
+        threshold.store(policy.level, std::memory_order_relaxed);
+    }
+
+    flight_recorder::ring* flight_recorder::acquire_ring() {
+        auto cap = capacity.load(std::memory_order_relaxed);
+        auto claim = [](ring* ring) {
+            bool owned = false;
+            return ring->owned.compare_exchange_strong(owned, true, std::memory_order_acquire);
+        };
+
+        // rings are only ever appended, so the first empty entry ends the list
+        for (auto& r : rings) {
+            auto* ring = r.load(std::memory_order_acquire);
+            if (not ring)
+                break;
+            if (ring->capacity == cap and claim(ring))
+                return ring;
+        }
+
+        // never freed: a crash handler may read it at any time, and it is reused once this thread exits
+        auto* fresh = new ring{cap};
+        for (auto& r : rings) {
+            ring* empty = nullptr;
+            if (r.compare_exchange_strong(empty, fresh, std::memory_order_acq_rel))
+                return fresh;
+        }
+        delete fresh;
+
+        // the table is full: a released ring of an earlier size still records, at that size
+        for (auto& r : rings) {
+            auto* ring = r.load(std::memory_order_acquire);
+            if (claim(ring))
+                return ring;
+        }
+        return nullptr;
+    }
+
+    flight_recorder::ring* flight_recorder::local_ring() {
+        if (lease.ring)
+            return lease.ring;
+
+        // read before trying, so a ring released during the attempt still prompts another
+        auto released = released_rings.load(std::memory_order_acquire);
+        if (lease.failed_at == released)
+            return nullptr;
+        alt_stack.install();
+        lease.ring = acquire_ring();
+        if (not lease.ring) {
+            if (not lease.failed_at)
+                unrecorded_threads.fetch_add(1, std::memory_order_relaxed);
+            lease.failed_at = released;
+        }
+        return lease.ring;
+    }
+
+    void flight_recorder::commit(
+            std::string_view logger,
+            LogLevel level,
+            spdlog::source_loc loc,
+            kind type,
+            const char* data,
+            size_t size) {
+        auto* ring = local_ring();
+        if (not ring)
+            return;
+
+        auto n = ring->written.load(std::memory_order_relaxed);
+        auto& s = ring->slots[n & (ring->capacity - 1)];
+
+        // a record that does not fit is kept as truncated text
+        spdlog::memory_buf_t rendered;
+        bool truncated = size > s.data.size();
+        if (truncated and type == kind::record and render_deferred(record_kind::deferred, {data, size}, rendered)) {
+            type = kind::text;
+            data = rendered.data();
+            size = rendered.size();
+            truncated = size > s.data.size();
+        }
+        if (truncated)
+            type = kind::text;
+        size = std::min(size, s.data.size());
+
+        auto sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        s.size = static_cast<uint16_t>(size);
+        s.level = static_cast<uint8_t>(level);
+        s.type = type;
+        s.time = std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count();
+        s.thread = spdlog::details::os::thread_id();
+        s.loc = loc;
+        s.name_size = static_cast<uint8_t>(std::min(logger.size(), s.name.size()));
+        std::memcpy(s.name.data(), logger.data(), s.name_size);
+        std::memcpy(s.data.data(), data, size);
+        if (truncated and type == kind::text)
+            std::memcpy(s.data.data() + size - 3, "...", 3);
+
+        s.sequence.store(sequence + 2, std::memory_order_release);
+        ring->written.store(n + 1, std::memory_order_release);
+    }
+
+    size_t flight_recorder::size() const {
+        size_t total = 0;
+        for (auto& r : rings) {
+            auto* ring = r.load(std::memory_order_acquire);
+            if (not ring)
+                break;
+            total += std::min<size_t>(ring->written.load(std::memory_order_acquire), ring->capacity);
+        }
+        return total;
+    }
+
+    void flight_recorder::write_dump(std::string_view reason) {
+        auto fd = dump_fd >= 0 ? dump_fd : STDERR_FILENO;
+        if (not formatter)
+            formatter = make_formatter();
+
+        auto entries = collect(rings);
+        spdlog::memory_buf_t buf, text;
+        fmt::format_to(
+                fmt::appender(buf),
+                "==== unlog flight recorder: {}, {} messages ====\n",
+                reason,
+                entries.size());
+        if (auto missed = unrecorded(); missed > 0)
+            fmt::format_to(fmt::appender(buf), "==== {} threads went unrecorded: no ring was free ====\n", missed);
+        write_all(fd, buf);
+
+        for (auto& e : entries) {
+            buf.clear();
+            formatter->format(to_msg(e, text), buf);
+            write_all(fd, buf);
+        }
+
+        buf.clear();
+        fmt::format_to(fmt::appender(buf), "==== end of flight recorder ====\n");
+        write_all(fd, buf);
+    }
+
+    void flight_recorder::dump() {
+        std::lock_guard lock{dump_mutex};
+        write_dump("on request"sv);
+    }
+
+    void flight_recorder::dump(spdlog::sinks::sink& sink) {
+        spdlog::memory_buf_t text;
+        for (auto& e : collect(rings))
+            sink.log(to_msg(e, text));
+        sink.flush();
+    }
+
+    void flight_recorder::crash_dump(std::string_view reason) {
+        if (crashed.exchange(true))
+            return;
+        write_dump(reason);
+    }
+}  // namespace un::log::detail
@@ -0,0 +1,349 @@
+#include "unlog/shm.hpp"
+
+#include "unlog/logger.hpp"
+#include "unlog/pattern.hpp"
+#include "unlog/sinks.hpp"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace un::log {
+    using namespace un::log::literals;
+
+    namespace {
+        constexpr std::string_view SHM_DIR{"/dev/shm"};
+
+        // Room for the fixed header and the padding record's size and kind, which is all that is read of it
+        constexpr size_t PADDING_MIN{8};
+
+        constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t{7}; }
+
+        int64_t nanos(spdlog::log_clock::time_point t) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        }
+
+        spdlog::log_clock::time_point from_nanos(int64_t ns) {
+            return spdlog::log_clock::time_point{
+                    std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds{ns})};
+        }
+
+        std::string_view clamp16(std::string_view s) { return s.substr(0, std::numeric_limits<uint16_t>::max()); }
+
+        std::runtime_error shm_error(std::string_view what, std::string_view name) {
+            return std::runtime_error{"shm: {} {} failed: {}"_format(what, name, std::strerror(errno))};
+        }
+
+        // Inode of a segment, to tell a segment from the one that replaced it under the same name
+        ino_t segment_inode(const std::string& name) {
+            struct stat st {};
+            return ::stat("{}{}"_format(SHM_DIR, name).c_str(), &st) == 0 ? st.st_ino : 0;
+        }
+
+        // Whether the file and function names of a record that fits its size end in the NUL the producer writes
+        bool names_terminated(const shm::record_header& record) {
+            auto* file_end = reinterpret_cast<const char*>(&record + 1) + record.name_size + record.file_size;
+            return file_end[0] == '\0' and file_end[1 + record.function_size] == '\0';
+        }
+
+        bool process_gone(uint32_t pid) { return ::kill(static_cast<pid_t>(pid), 0) == -1 and errno == ESRCH; }
+    }  // namespace
+
+    std::string shm::segment_name(std::string_view channel, uint32_t pid) {
+        return "/unlog.{}.{}"_format(channel, pid);
+    }
+
+    shm_sink::shm_sink(const ShmPolicy& policy) : name{shm::segment_name(policy.channel, ::getpid())} {
+        if (policy.channel.empty() or policy.channel.find('/') != std::string::npos)
+            throw std::invalid_argument{"shm: invalid channel name '{}'"_format(policy.channel)};
+        uint64_t capacity = std::bit_ceil(std::max<uint64_t>(policy.ring_size, 4096));
+
+        // a segment with our name was left by an earlier process with the same pid, which is gone
+        ::shm_unlink(name.c_str());
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw shm_error("shm_open", name);
+
+        mapped = shm::DATA_OFFSET + capacity;
+        void* addr = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(mapped)) == 0)
+            addr = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            auto error = shm_error("mapping", name);
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw error;
+        }
+        ::close(fd);
+
+        ring = new (addr) shm::ring_header{};
+        data = static_cast<char*>(addr) + shm::DATA_OFFSET;
+        std::memcpy(ring->magic, shm::MAGIC.data(), sizeof(ring->magic));
+        ring->version = shm::VERSION;
+        ring->pid = static_cast<uint32_t>(::getpid());
+        ring->capacity = capacity;
+        ring->started_at = nanos(startup_time());
+        ring->ready.store(1, std::memory_order_release);
+    }
+
+    shm_sink::~shm_sink() {
+        if (not ring)
+            return;
+        ring->closed.store(1, std::memory_order_release);
+        // nothing left for a collector: the segment can go now, otherwise the collector removes it once drained
+        if (ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed))
+            ::shm_unlink(name.c_str());
+        ::munmap(ring, mapped);
+    }
+
+    void shm_sink::sink_it_(const spdlog::details::log_msg& msg) {
+        auto logger = clamp16({msg.logger_name.data(), msg.logger_name.size()});
+        auto file = clamp16(msg.source.filename ? msg.source.filename : "");
+        auto function = clamp16(msg.source.funcname ? msg.source.funcname : "");
+        std::string_view text{msg.payload.data(), msg.payload.size()};
+
+        uint64_t capacity = ring->capacity;
+        uint64_t size = align8(
+                sizeof(shm::record_header) + logger.size() + file.size() + 1 + function.size() + 1 + text.size());
+        if (size > capacity / 2) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t offset = tail & (capacity - 1);
+        uint64_t to_end = capacity - offset;
+        uint64_t padding = to_end < size ? to_end : 0;
+        if (tail + padding + size - head > capacity) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (padding) {
+            uint32_t padding_size = static_cast<uint32_t>(padding);
+            std::memcpy(data + offset, &padding_size, sizeof(padding_size));
+            data[offset + offsetof(shm::record_header, type)] = static_cast<char>(shm::kind::padding);
+            offset = 0;
+        }
+
+        shm::record_header header{};
+        header.size = static_cast<uint32_t>(size);
+        header.type = shm::kind::message;
+        header.level = static_cast<uint8_t>(msg.level);
+        header.name_size = static_cast<uint16_t>(logger.size());
+        header.time = nanos(msg.time);
+        header.thread = msg.thread_id;
+        header.line = static_cast<uint32_t>(msg.source.line);
+        header.file_size = static_cast<uint16_t>(file.size());
+        header.function_size = static_cast<uint16_t>(function.size());
+        header.text_size = static_cast<uint32_t>(text.size());
+
+        char* out = data + offset;
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, logger.data(), logger.size());
+        out += logger.size();
+        for (auto s : {file, function}) {
+            std::memcpy(out, s.data(), s.size());
+            out += s.size();
+            *out++ = '\0';
+        }
+        std::memcpy(out, text.data(), text.size());
+
+        ring->tail.store(tail + padding + size, std::memory_order_release);
+    }
+
+    struct shm_collector::attached {
+        std::string name;
+        ino_t inode;
+        shm::ring_header* ring;
+        const char* data;
+        size_t mapped;
+        uint64_t tail{0};  // published end of the current poll
+        uint64_t reported_dropped{0};
+        bool replaced{false};  // a new producer with the same pid took the name
+
+        ~attached() { ::munmap(ring, mapped); }
+    };
+
+    shm_collector::shm_collector(std::string_view channel, std::chrono::milliseconds interval)
+            : channel{channel}, interval{interval} {}
+
+    shm_collector::~shm_collector() {
+        stop();
+    }
+
+    void shm_collector::discover() {
+        auto prefix = "unlog.{}."_format(channel);
+        std::error_code ec;
+        for (auto& entry : fs::directory_iterator{SHM_DIR, ec}) {
+            auto file = entry.path().filename().string();
+            if (not file.starts_with(prefix))
+                continue;
+            auto pid = std::string_view{file}.substr(prefix.size());
+            if (pid.empty() or pid.find_first_not_of("0123456789") != std::string_view::npos)
+                continue;
+
+            auto name = "/" + file;
+            auto inode = segment_inode(name);
+            auto known = std::ranges::find_if(rings, [&](auto& r) { return r->name == name; });
+            if (known != rings.end()) {
+                (*known)->replaced = (*known)->replaced or (inode and inode != (*known)->inode);
+                continue;
+            }
+
+            int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+            if (fd < 0)
+                continue;
+            struct stat st {};
+            void* addr = MAP_FAILED;
+            // a producer that has not sized its segment yet is picked up by a later poll
+            if (::fstat(fd, &st) == 0 and static_cast<size_t>(st.st_size) > shm::DATA_OFFSET)
+                addr = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED)
+                continue;
+
+            auto ring = std::make_unique<attached>(
+                    name, st.st_ino, static_cast<shm::ring_header*>(addr), static_cast<const char*>(addr) + shm::DATA_OFFSET,
+                    static_cast<size_t>(st.st_size));
+            auto* header = ring->ring;
+            if (not header->ready.load(std::memory_order_acquire))
+                continue;
+            if (std::string_view{header->magic, sizeof(header->magic)} != shm::MAGIC or
+                header->version != shm::VERSION or not std::has_single_bit(header->capacity) or
+                header->capacity + shm::DATA_OFFSET > ring->mapped)
+                continue;
+            rings.push_back(std::move(ring));
+        }
+    }
+
+    void shm_collector::deliver(const shm::record_header& record, const char* body) {
+        std::string_view logger{body, record.name_size};
+        const char* file = body + record.name_size;
+        const char* function = file + record.file_size + 1;
+        std::string_view text{function + record.function_size + 1, record.text_size};
+
+        // copied out of the ring, so a producer rewriting the record cannot take away the terminators
+        spdlog::source_loc loc{};
+        if (record.file_size) {
+            source.assign(file, record.file_size + 1 + record.function_size + 1);
+            source[record.file_size] = '\0';
+            source.back() = '\0';
+            loc = {source.data(), static_cast<int>(record.line), source.data() + record.file_size + 1};
+        }
+        spdlog::details::log_msg msg{
+                from_nanos(record.time), loc, {logger.data(), logger.size()},
+                static_cast<LogLevel>(record.level), {text.data(), text.size()}};
+        msg.thread_id = record.thread;
+        master_sink->log(msg);
+    }
+
+    void shm_collector::retire() {
+        std::erase_if(rings, [](auto& r) {
+            auto* header = r->ring;
+            if (header->head.load(std::memory_order_relaxed) != header->tail.load(std::memory_order_acquire))
+                return false;
+            if (not(r->replaced or header->closed.load(std::memory_order_acquire) or process_gone(header->pid)))
+                return false;
+            // the name may already belong to a new producer with the same pid
+            if (not r->replaced and segment_inode(r->name) == r->inode)
+                ::shm_unlink(r->name.c_str());
+            return true;
+        });
+    }
+
+    size_t shm_collector::poll() {
+        discover();
+        for (auto& r : rings)
+            r->tail = r->ring->tail.load(std::memory_order_acquire);
+
+        // The next message of a ring, skipping padding; a record that does not fit the ring or the published range, or
+        // whose names are not terminated (a producer writing a different layout, or a corrupt segment), makes the
+        // collector skip to the tail
+        auto next = [](attached& r) -> const shm::record_header* {
+            auto* header = r.ring;
+            uint64_t capacity = header->capacity;
+            uint64_t head = header->head.load(std::memory_order_relaxed);
+            while (head < r.tail) {
+                uint64_t offset = head & (capacity - 1);
+                uint32_t size;
+                std::memcpy(&size, r.data + offset, sizeof(size));
+                auto type = static_cast<shm::kind>(r.data[offset + offsetof(shm::record_header, type)]);
+                bool valid = size >= PADDING_MIN and size % 8 == 0 and offset + size <= capacity and head + size <= r.tail;
+                if (valid and type == shm::kind::padding) {
+                    head += size;
+                    header->head.store(head, std::memory_order_release);
+                    continue;
+                }
+                auto* record = reinterpret_cast<const shm::record_header*>(r.data + offset);
+                if (valid and type == shm::kind::message and size >= sizeof(shm::record_header) and
+                    record->level < spdlog::level::n_levels and
+                    sizeof(shm::record_header) + record->name_size + record->file_size + 1 + record->function_size +
+                                    1 + uint64_t{record->text_size} <=
+                            size and
+                    names_terminated(*record))
+                    return record;
+                header->head.store(r.tail, std::memory_order_release);
+                return nullptr;
+            }
+            return nullptr;
+        };
+
+        size_t delivered{0};
+        for (;;) {
+            attached* earliest{nullptr};
+            const shm::record_header* record{nullptr};
+            for (auto& r : rings) {
+                auto* candidate = next(*r);
+                if (candidate and (not record or candidate->time < record->time)) {
+                    earliest = r.get();
+                    record = candidate;
+                }
+            }
+            if (not record)
+                break;
+            deliver(*record, reinterpret_cast<const char*>(record + 1));
+            earliest->ring->head.fetch_add(record->size, std::memory_order_release);
+            ++delivered;
+        }
+
+        for (auto& r : rings) {
+            auto dropped = r->ring->dropped.load(std::memory_order_relaxed);
+            if (dropped == r->reported_dropped)
+                continue;
+            auto text = "shm: {} messages from process {} were dropped, its ring on channel '{}' was full"_format(
+                    dropped - r->reported_dropped, r->ring->pid, channel);
+            r->reported_dropped = dropped;
+            master_sink->log(spdlog::details::log_msg{"unlog", LogLevel::warn, text});
+        }
+
+        retire();
+        return delivered;
+    }
+
+    void shm_collector::start() {
+        if (running.exchange(true))
+            return;
+        worker = std::thread{[this] {
+            while (running.load(std::memory_order_relaxed))
+                if (poll() == 0)
+                    std::this_thread::sleep_for(interval);
+        }};
+    }
+
+    void shm_collector::stop() {
+        if (not running.exchange(false))
+            return;
+        worker.join();
+        // what was published before stop() is still delivered
+        poll();
+    }
+}  // namespace un::log
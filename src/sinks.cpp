@@ -0,0 +1,229 @@
+#include "unlog/sinks.hpp"
+
+#include "unlog/deferred.hpp"
+
+namespace un::log {
+
+    namespace {
+        // Times what a backend thread spends in the master sink; a no-op on any other thread
+        struct backend_timer {
+            detail::backend_meter* meter{detail::current_backend_meter()};
+            std::chrono::steady_clock::time_point start{
+                    meter ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}};
+            bool delivery;
+
+            explicit backend_timer(bool delivery) : delivery{delivery} {}
+
+            ~backend_timer() {
+                if (meter and delivery)
+                    meter->delivered_since(start);
+                else if (meter)
+                    meter->busy_since(start);
+            }
+        };
+    }  // namespace
+
+    fanout_sink::state::state(sink_list list) : sinks{std::move(list)} {
+        record_sinks.reserve(sinks.size());
+        meters.reserve(sinks.size());
+        for (auto& sink : sinks) {
+            record_sinks.push_back(dynamic_cast<record_sink*>(sink.get()));
+            meters.push_back(detail::meters().find(sink.get()));
+        }
+    }
+
+    fanout_sink::fanout_sink() : current{std::make_shared<const state>()} {}
+
+    void fanout_sink::log(const spdlog::details::log_msg& msg) {
+        backend_timer timer{true};
+        auto s = load();
+        for (auto& sink : s->sinks)
+            if (sink->should_log(msg.level))
+                sink->log(msg);
+    }
+
+    void fanout_sink::log_record(const spdlog::details::log_msg& msg, detail::record_kind kind) {
+        backend_timer timer{true};
+        auto s = load();
+
+        spdlog::memory_buf_t buf;
+        std::optional<spdlog::details::log_msg> rendered;
+        detail::fields_scope fields;
+
+        for (size_t i = 0; i < s->sinks.size(); ++i) {
+            auto& sink = s->sinks[i];
+            if (not sink->should_log(msg.level))
+                continue;
+            if (auto* records = s->record_sinks[i]) {
+                records->log_record(msg, kind);
+                continue;
+            }
+            if (not rendered)
+                rendered = detail::rendered_copy(msg, kind, buf, fields);
+            sink->log(*rendered);
+        }
+    }
+
+    void fanout_sink::flush() {
+        backend_timer timer{false};
+        auto s = load();
+        for (size_t i = 0; i < s->sinks.size(); ++i) {
+            auto& meter = s->meters[i];
+            auto start = meter ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            s->sinks[i]->flush();
+            if (meter)
+                meter->flushed(std::chrono::steady_clock::now() - start);
+        }
+    }
+
+    void fanout_sink::set_pattern(const std::string& pattern) {
+        set_formatter(std::make_unique<spdlog::pattern_formatter>(pattern));
+    }
+
+    void fanout_sink::set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+        auto s = load();
+        for (size_t i = 0; i < s->sinks.size(); ++i) {
+            if (auto& meter = s->meters[i])
+                s->sinks[i]->set_formatter(std::make_unique<detail::metered_formatter>(formatter->clone(), meter));
+            else
+                s->sinks[i]->set_formatter(formatter->clone());
+        }
+    }
+
+    void fanout_sink::add_sink(spdlog::sink_ptr sink) {
+        std::lock_guard lock{writer_mutex};
+        auto next = load()->sinks;
+        next.push_back(std::move(sink));
+        store(std::make_shared<const state>(std::move(next)));
+    }
+
+    namespace {
+        // Whether `s` is `sink`, or the wrappers unlog put it behind
+        bool holds(const spdlog::sink_ptr& s, const spdlog::sink_ptr& sink) {
+            if (s == sink)
+                return true;
+            if (auto* dedup = dynamic_cast<const dedup_sink*>(s.get()))
+                return holds(dedup->wrapped(), sink);
+            if (auto* serialized = dynamic_cast<const serialized_sink*>(s.get()))
+                return holds(serialized->wrapped(), sink);
+            return false;
+        }
+    }  // namespace
+
+    void fanout_sink::remove_sink(const spdlog::sink_ptr& sink) {
+        std::lock_guard lock{writer_mutex};
+        auto next = load()->sinks;
+        std::erase_if(next, [&sink](const auto& s) { return holds(s, sink); });
+        store(std::make_shared<const state>(std::move(next)));
+    }
+
+    void fanout_sink::set_sinks(sink_list sinks) {
+        std::lock_guard lock{writer_mutex};
+        store(std::make_shared<const state>(std::move(sinks)));
+    }
+
+    void serialized_sink::log(const spdlog::details::log_msg& msg) {
+        std::lock_guard lock{mutex};
+        inner->log(msg);
+    }
+
+    void serialized_sink::flush() {
+        std::lock_guard lock{mutex};
+        inner->flush();
+    }
+
+    void serialized_sink::set_pattern(const std::string& pattern) {
+        std::lock_guard lock{mutex};
+        inner->set_pattern(pattern);
+    }
+
+    void serialized_sink::set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+        std::lock_guard lock{mutex};
+        inner->set_formatter(std::move(formatter));
+    }
+
+    namespace {
+        int64_t nanos(spdlog::log_clock::time_point t) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        }
+
+        // Top 48 bits identify the message; the low 16 are left for the repeat count
+        uint64_t message_hash(const spdlog::details::log_msg& msg) {
+            auto h = std::hash<std::string_view>{}({msg.payload.data(), msg.payload.size()});
+            h ^= (static_cast<uint64_t>(msg.source.line) << 8 | static_cast<uint64_t>(msg.level)) * 0x9e37'79b9'7f4a'7c15;
+            // by content: async backends and spill replay hand over copies of the name and the source file
+            if (msg.source.filename)
+                h ^= std::hash<std::string_view>{}(msg.source.filename) * 0xc2b2'ae3d'27d4'eb4f;
+            h ^= std::hash<std::string_view>{}({msg.logger_name.data(), msg.logger_name.size()});
+            // murmur3 finalizer, so every input bit reaches the top
+            h ^= h >> 33;
+            h *= 0xff51'afd7'ed55'8ccd;
+            h ^= h >> 33;
+            return h | 0x1'0000;
+        }
+    }  // namespace
+
+    dedup_sink::dedup_sink(spdlog::sink_ptr sink, std::chrono::milliseconds w) : inner{std::move(sink)}, window{w} {}
+
+    dedup_sink::~dedup_sink() {
+        if (auto repeats = last.load(std::memory_order_relaxed) & COUNT_MASK)
+            write_summary(repeats);
+    }
+
+    void dedup_sink::write_summary(uint64_t repeats) {
+        spdlog::memory_buf_t text;
+        fmt::format_to(fmt::appender(text), "last message repeated {} times", repeats);
+        spdlog::source_loc source{};
+        if (source_line > 0)
+            source = {source_file.c_str(), source_line, source_function.c_str()};
+        spdlog::details::log_msg summary{
+                spdlog::log_clock::now(), source, logger_name, level, spdlog::string_view_t{text.data(), text.size()}};
+        summary.thread_id = thread_id;
+        inner->log(summary);
+    }
+
+    void dedup_sink::log(const spdlog::details::log_msg& msg) {
+        auto hash = message_hash(msg) & ~COUNT_MASK;
+        auto time = nanos(msg.time);
+        auto is_repeat = [&](uint64_t state) {
+            return (state & ~COUNT_MASK) == hash and (state & COUNT_MASK) < COUNT_MASK and
+                   time - written_at.load(std::memory_order_relaxed) < window.count();
+        };
+
+        for (auto state = last.load(std::memory_order_relaxed); is_repeat(state);)
+            if (last.compare_exchange_weak(state, state + 1, std::memory_order_relaxed))
+                return;
+
+        std::lock_guard lock{mutex};
+        // repeats counted up to here belong to the previous message, including any that raced with this one
+        if (auto repeats = last.exchange(hash, std::memory_order_relaxed) & COUNT_MASK)
+            write_summary(repeats);
+        written_at.store(time, std::memory_order_relaxed);
+
+        inner->log(msg);
+        logger_name.assign(msg.logger_name.data(), msg.logger_name.size());
+        level = msg.level;
+        source_file.assign(msg.source.filename ? msg.source.filename : "");
+        source_function.assign(msg.source.funcname ? msg.source.funcname : "");
+        source_line = msg.source.filename ? msg.source.line : 0;
+        thread_id = msg.thread_id;
+    }
+
+    void dedup_sink::flush() {
+        {
+            std::lock_guard lock{mutex};
+            if (auto repeats = last.fetch_and(~COUNT_MASK, std::memory_order_relaxed) & COUNT_MASK)
+                write_summary(repeats);
+        }
+        inner->flush();
+    }
+
+    void dedup_sink::set_pattern(const std::string& pattern) {
+        inner->set_pattern(pattern);
+    }
+
+    void dedup_sink::set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+        inner->set_formatter(std::move(formatter));
+    }
+
+}  // namespace un::log
@@ -0,0 +1,486 @@
+#include "unlog/spsc.hpp"
+
+#include "unlog/stats.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+namespace un::log::detail {
+    using namespace un::log::literals;
+
+    namespace {
+        thread_local bool is_backend_thread{false};
+
+        // Spins briefly, then yields, then sleeps; keeps an idle backend off the CPU without adding much latency
+        // to the first message after a quiet period
+        struct backoff {
+            uint32_t rounds{0};
+
+            void operator()() {
+                if (rounds >= 128)
+                    std::this_thread::sleep_for(std::chrono::microseconds{rounds < 1024 ? 50 : 500});
+                else if (rounds >= 64)
+                    std::this_thread::yield();
+                ++rounds;
+            }
+
+            void reset() { rounds = 0; }
+        };
+    }  // namespace
+
+    spsc_ring::spsc_ring(size_t capacity) :
+            slots(std::bit_ceil(std::max<size_t>(capacity, 2))), mask{slots.size() - 1} {}
+
+    bool spsc_ring::try_push(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind) {
+        auto t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+            return false;
+
+        auto& slot = slots[t & mask];
+        slot.logger = &logger;
+        slot.kind = kind;
+        slot.msg = spdlog::details::log_msg_buffer{msg};
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    const spsc_slot* spsc_ring::front() const {
+        auto h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots[h & mask];
+    }
+
+    void spsc_ring::pop() {
+        auto h = head.load(std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    namespace {
+        // Followed by the source file and function names (each NUL-terminated, or absent when the size is 0) and then
+        // the payload, so nothing in the file points into memory that may be gone by the time it is replayed
+        struct spill_record {
+            uint32_t size;  // payload bytes
+            uint32_t logger;  // index into the spill file's logger table
+            spdlog::level::level_enum level;
+            record_kind kind;  // text, or the kind of record the payload holds (see record.hpp)
+            spdlog::log_clock::time_point time;
+            size_t thread;
+            int line;
+            uint32_t filename_size;
+            uint32_t funcname_size;
+        };
+
+        uint32_t c_string_size(const char* str) {
+            return str ? static_cast<uint32_t>(std::strlen(str) + 1) : 0;
+        }
+
+        const char* c_string_at(const char* data, uint32_t size) {
+            return size > 0 and data[size - 1] == '\0' ? data : nullptr;
+        }
+
+        bool read_at(int fd, uint64_t offset, void* data, size_t size) {
+            auto* out = static_cast<char*>(data);
+            while (size > 0) {
+                auto n = ::pread(fd, out, size, static_cast<off_t>(offset));
+                if (n < 0 and errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                out += n;
+                offset += static_cast<uint64_t>(n);
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool write_at(int fd, uint64_t offset, const char* data, size_t size) {
+            while (size > 0) {
+                auto n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+                if (n < 0 and errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                data += n;
+                offset += static_cast<uint64_t>(n);
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+    }  // namespace
+
+    spill_file::~spill_file() {
+        if (fd >= 0) {
+            ::close(fd);
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    void spill_file::open(const fs::path& file, uint64_t max_size) {
+        std::lock_guard lock{mutex};
+        if (fd >= 0)
+            return;
+        fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0)
+            throw std::runtime_error{"Cannot open spill file {}: {}"_format(file.string(), std::strerror(errno))};
+        path = file;
+        limit = max_size;
+    }
+
+    spill_file::result spill_file::write(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind) {
+        spill_record header{
+                static_cast<uint32_t>(msg.payload.size()),
+                0,
+                msg.level,
+                kind,
+                msg.time,
+                msg.thread_id,
+                msg.source.line,
+                c_string_size(msg.source.filename),
+                c_string_size(msg.source.funcname)};
+        spdlog::memory_buf_t buf;
+        buf.append(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+        buf.append(msg.source.filename, msg.source.filename + header.filename_size);
+        buf.append(msg.source.funcname, msg.source.funcname + header.funcname_size);
+        buf.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+
+        std::lock_guard lock{mutex};
+        if (fd < 0)
+            return result::failed;
+        // a record larger than the whole limit still goes into an empty file, or it could never be written
+        if (written > 0 and written + buf.size() > limit)
+            return result::full;
+
+        auto it = std::ranges::find(loggers, &logger);
+        header.logger = static_cast<uint32_t>(it - loggers.begin());
+        if (it == loggers.end())
+            loggers.push_back(&logger);
+        std::memcpy(buf.data() + offsetof(spill_record, logger), &header.logger, sizeof(header.logger));
+
+        if (not write_at(fd, written, buf.data(), buf.size()))
+            return result::failed;
+        written += buf.size();
+        pending.store(true, std::memory_order_release);
+        return result::written;
+    }
+
+    size_t spill_file::replay(size_t max, spdlog::log_clock::time_point until) {
+        uint64_t end;
+        {
+            std::lock_guard lock{mutex};
+            end = written;
+            if (replayed == end) {
+                // caught up: start the file over, release its loggers, and let spilling loggers use their rings again
+                if (end > 0 and ::ftruncate(fd, 0) == 0)
+                    written = 0;
+                replayed = written;
+                loggers.clear();
+                replaying.clear();
+                pending.store(false, std::memory_order_release);
+                return 0;
+            }
+            // every record before `end` refers to a logger already in the table
+            if (replaying.size() != loggers.size())
+                replaying = loggers;
+        }
+
+        size_t delivered = 0;
+        while (delivered < max and replayed < end) {
+            spill_record header;
+            if (not read_at(fd, replayed, &header, sizeof(header)) or header.logger >= replaying.size()) {
+                replayed = end;  // unreadable; give up on the rest rather than retry forever
+                break;
+            }
+            if (header.time > until)
+                break;
+            auto body = size_t{header.filename_size} + header.funcname_size + header.size;
+            chunk.resize(body);
+            if (not read_at(fd, replayed + sizeof(header), chunk.data(), body)) {
+                replayed = end;
+                break;
+            }
+
+            const auto* filename = chunk.data();
+            const auto* funcname = filename + header.filename_size;
+            const auto* payload = funcname + header.funcname_size;
+            auto* logger = replaying[header.logger];
+
+            spdlog::details::log_msg msg{
+                    header.time,
+                    spdlog::source_loc{
+                            c_string_at(filename, header.filename_size),
+                            header.line,
+                            c_string_at(funcname, header.funcname_size)},
+                    logger->name(),
+                    header.level,
+                    spdlog::string_view_t{payload, header.size}};
+            msg.thread_id = header.thread;
+            logger->backend_sink_it_(msg, header.kind);
+
+            replayed += sizeof(header) + body;
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    spsc_engine::spsc_engine(size_t capacity) : ring_capacity{capacity}, backend{[this] { run(); }} {
+        spsc_meter.depth.store([] { return spsc_pool().depth(); }, std::memory_order_release);
+    }
+
+    spsc_engine::~spsc_engine() {
+        spsc_meter.depth.store(nullptr, std::memory_order_release);
+        running.store(false, std::memory_order_release);
+        if (backend.joinable())
+            backend.join();
+    }
+
+    spsc_ring& spsc_engine::local_ring() {
+        struct holder {
+            std::shared_ptr<spsc_ring> ring;
+
+            ~holder() {
+                if (ring)
+                    ring->orphaned.store(true, std::memory_order_release);
+            }
+        };
+        thread_local holder local;
+
+        if (not local.ring) {
+            local.ring = std::make_shared<spsc_ring>(ring_capacity);
+            std::lock_guard lock{rings_mutex};
+            rings.push_back(local.ring);
+            generation.fetch_add(1, std::memory_order_release);
+        }
+        return *local.ring;
+    }
+
+    void spsc_engine::pin(spsc_logger& logger) {
+        std::lock_guard lock{loggers_mutex};
+        if (not logger.pinned.load(std::memory_order_relaxed)) {
+            loggers.push_back(logger.shared_from_this());
+            logger.pinned.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void spsc_engine::release_dropped(const std::vector<std::shared_ptr<spsc_ring>>& local, uint64_t seen) {
+        std::vector<std::shared_ptr<spsc_logger>> dropped;
+        {
+            std::lock_guard lock{loggers_mutex};
+            for (auto& l : loggers)
+                if (l.use_count() == 1)
+                    dropped.push_back(l);
+        }
+        if (dropped.empty())
+            return;
+
+        // A producer lets go of its logger only after pushing, so once its release of the count is seen, so is
+        // anything it queued; keep the loggers if a ring or the spill file turns out to hold something after all
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (generation.load(std::memory_order_acquire) != seen or spill.has_pending() or
+            not std::ranges::all_of(local, [](const auto& r) { return r->empty(); }))
+            return;
+
+        std::lock_guard lock{loggers_mutex};
+        std::erase_if(loggers, [&](const auto& l) { return std::ranges::find(dropped, l) != dropped.end(); });
+    }
+
+    bool spsc_engine::spill_message(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind) {
+        backoff wait;
+        while (true) {
+            switch (spill.write(logger, msg, kind)) {
+                case spill_file::result::written:
+                    spsc_meter.spilled.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                case spill_file::result::failed:
+                    return false;
+                case spill_file::result::full:
+                    break;
+            }
+            // once the backend has caught up and started the file over, the rings take messages again
+            if (not spill.has_pending())
+                return false;
+            wait();
+        }
+    }
+
+    void spsc_engine::push(spsc_logger& logger, const spdlog::details::log_msg& msg, record_kind kind) {
+        auto& ring = local_ring();
+        auto policy = logger.overflow;
+        if (not logger.pinned.load(std::memory_order_relaxed))
+            pin(logger);
+
+        // while the spill file is being worked off, spilling loggers keep appending to it so nothing jumps ahead
+        if (policy == Overflow::spill and spill.has_pending() and spill_message(logger, msg, kind))
+            return;
+        if (ring.try_push(logger, msg, kind))
+            return;
+        if (policy == Overflow::drop_newest) {
+            spsc_meter.discarded.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (policy == Overflow::spill and spill_message(logger, msg, kind))
+            return;
+
+        backoff wait;
+        while (not ring.try_push(logger, msg, kind))
+            wait();
+    }
+
+    void spsc_engine::drain() {
+        std::vector<std::pair<std::shared_ptr<spsc_ring>, size_t>> pending;
+        {
+            std::lock_guard lock{rings_mutex};
+            pending.reserve(rings.size());
+            for (auto& r : rings)
+                pending.emplace_back(r, r->produced());
+        }
+
+        backoff wait;
+        for (auto& [ring, until] : pending)
+            while (ring->consumed() < until and backend.joinable())
+                wait();
+        while (spill.has_pending() and backend.joinable())
+            wait();
+    }
+
+    size_t spsc_engine::depth() {
+        std::lock_guard lock{rings_mutex};
+        size_t queued = 0;
+        for (auto& r : rings)
+            queued += r->produced() - r->consumed();
+        return queued;
+    }
+
+    bool spsc_engine::on_backend_thread() {
+        return is_backend_thread;
+    }
+
+    void spsc_engine::run() {
+        is_backend_thread = true;
+        set_backend_meter(&spsc_meter);
+
+        std::vector<std::shared_ptr<spsc_ring>> local;
+        uint64_t seen_generation{~uint64_t{0}};
+        size_t since_replay{0};  // ring messages delivered since the spill file last had a turn
+        backoff wait;
+
+        while (true) {
+            if (auto gen = generation.load(std::memory_order_acquire); gen != seen_generation) {
+                std::lock_guard lock{rings_mutex};
+                // retire rings whose thread has exited once they have been fully drained
+                std::erase_if(rings, [](const auto& r) { return r->orphaned.load() and r->empty(); });
+                local = rings;
+                seen_generation = generation.load(std::memory_order_relaxed);
+            }
+
+            // k-way merge: deliver the oldest message at the front of any ring
+            spsc_ring* oldest{nullptr};
+            const spsc_slot* oldest_slot{nullptr};
+            bool retire{false};
+            for (auto& r : local) {
+                if (auto* slot = r->front()) {
+                    if (not oldest_slot or slot->msg.time < oldest_slot->msg.time) {
+                        oldest = r.get();
+                        oldest_slot = slot;
+                    }
+                }
+                else if (r->orphaned.load(std::memory_order_relaxed))
+                    retire = true;
+            }
+
+            if (retire)
+                generation.fetch_add(1, std::memory_order_release);
+
+            if (not oldest) {
+                // the rings are empty: work off spilled messages a chunk at a time, as fast as they go
+                since_replay = 0;
+                if (spill.has_pending()) {
+                    if (auto n = spill.replay(SPILL_CHUNK)) {
+                        spsc_meter.replayed.fetch_add(n, std::memory_order_relaxed);
+                        wait.reset();
+                        continue;
+                    }
+                }
+                // once per quiet spell, let go of loggers dropped by everyone else
+                if (wait.rounds == 0)
+                    release_dropped(local, seen_generation);
+                if (not running.load(std::memory_order_acquire))
+                    break;
+                wait();
+                continue;
+            }
+
+            wait.reset();
+            auto delivered_at = oldest_slot->msg.time;
+            oldest_slot->logger->backend_sink_it_(oldest_slot->msg, oldest_slot->kind);
+            oldest->pop();
+
+            // under sustained load the rings never empty, so after every chunk delivered from them, the spilled
+            // messages that are older than what was just delivered get a chunk of their own
+            if (++since_replay >= SPILL_CHUNK) {
+                since_replay = 0;
+                if (spill.has_pending())
+                    if (auto n = spill.replay(SPILL_CHUNK, delivered_at))
+                        spsc_meter.replayed.fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+
+        std::lock_guard lock{loggers_mutex};
+        loggers.clear();
+    }
+
+    __attribute__((visibility("default"))) spsc_engine& spsc_pool(uint32_t ring_size) {
+        static spsc_engine engine{ring_size};
+        return engine;
+    }
+
+    spsc_logger::spsc_logger(std::string name, spdlog::sink_ptr sink, spsc_engine& engine, Overflow overflow) :
+            spdlog::logger{std::move(name), std::move(sink)}, engine{engine}, overflow{overflow} {
+        if (overflow == Overflow::overwrite_oldest)
+            throw std::invalid_argument{"Overflow::overwrite_oldest is not supported by Engine::spsc"};
+    }
+
+    spsc_logger::spsc_logger(const spsc_logger& other) :
+            std::enable_shared_from_this<spsc_logger>{},
+            spdlog::logger{other},
+            record_logger{},
+            engine{other.engine},
+            overflow{other.overflow} {}
+
+    void spsc_logger::sink_it_(const spdlog::details::log_msg& msg) {
+        engine.push(*this, msg);
+    }
+
+    void spsc_logger::log_record(const spdlog::details::log_msg& msg, record_kind kind) {
+        engine.push(*this, msg, kind);
+    }
+
+    void spsc_logger::backend_sink_it_(const spdlog::details::log_msg& msg, record_kind kind) {
+        if (kind == record_kind::text)
+            return spdlog::logger::sink_it_(msg);
+        SPDLOG_TRY {
+            deliver_record(*this, msg, kind);
+        }
+        SPDLOG_LOGGER_CATCH(msg.source)
+    }
+
+    void spsc_logger::flush_() {
+        // the backend flushes inline (flush_on level); everyone else waits for their queued messages first
+        if (not spsc_engine::on_backend_thread())
+            engine.drain();
+        spdlog::logger::flush_();
+    }
+
+    std::shared_ptr<spdlog::logger> spsc_logger::clone(std::string new_name) {
+        auto cloned = std::make_shared<spsc_logger>(*this);
+        cloned->name_ = std::move(new_name);
+        return cloned;
+    }
+
+}  // namespace un::log::detail
@@ -0,0 +1,145 @@
+#include "unlog/stats.hpp"
+
+namespace un::log {
+
+    namespace detail {
+        std::array<stat_shard, STAT_SHARDS> stat_shards{};
+        std::atomic<size_t> next_stat_shard{0};
+
+        backend_meter pool_meter{};
+        backend_meter spsc_meter{};
+
+        namespace {
+            thread_local backend_meter* local_backend{nullptr};
+
+            void raise_to(std::atomic<uint64_t>& value, uint64_t candidate) {
+                auto current = value.load(std::memory_order_relaxed);
+                while (candidate > current and
+                       not value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+                    ;
+            }
+
+            uint64_t since(std::chrono::steady_clock::time_point start) {
+                return static_cast<uint64_t>(
+                        std::chrono::nanoseconds{std::chrono::steady_clock::now() - start}.count());
+            }
+
+            // spdlog gained the discard_new overflow policy (and its counter) after the versions some builds use
+            template <typename Pool>
+            uint64_t discarded(Pool& pool) {
+                if constexpr (requires { pool.discard_counter(); })
+                    return pool.discard_counter();
+                else
+                    return 0;
+            }
+
+            queue_stats read(backend_meter& meter) {
+                queue_stats q;
+                auto depth = meter.depth.load(std::memory_order_acquire);
+                q.running = depth != nullptr;
+                if (q.running)
+                    q.depth = meter.sample();
+                q.high_water = meter.high_water.load(std::memory_order_relaxed);
+                q.discarded = meter.discarded.load(std::memory_order_relaxed);
+                q.spilled = meter.spilled.load(std::memory_order_relaxed);
+                q.replayed = meter.replayed.load(std::memory_order_relaxed);
+                q.delivered = meter.delivered.load(std::memory_order_relaxed);
+                q.busy = std::chrono::nanoseconds{meter.busy_ns.load(std::memory_order_relaxed)};
+                return q;
+            }
+        }  // namespace
+
+        void set_backend_meter(backend_meter* meter) {
+            local_backend = meter;
+        }
+
+        backend_meter* current_backend_meter() {
+            return local_backend;
+        }
+
+        void backend_meter::busy_since(std::chrono::steady_clock::time_point start) {
+            busy_ns.fetch_add(since(start), std::memory_order_relaxed);
+        }
+
+        void backend_meter::delivered_since(std::chrono::steady_clock::time_point start) {
+            busy_since(start);
+            if (delivered.fetch_add(1, std::memory_order_relaxed) % SAMPLE_INTERVAL == 0)
+                sample();
+        }
+
+        uint64_t backend_meter::sample() {
+            auto fn = depth.load(std::memory_order_acquire);
+            if (not fn)
+                return 0;
+            auto current = fn();
+            raise_to(high_water, current);
+            return current;
+        }
+
+        void sink_meter::flushed(std::chrono::nanoseconds took) {
+            auto ns = static_cast<uint64_t>(took.count());
+            flushes.fetch_add(1, std::memory_order_relaxed);
+            flush_ns.fetch_add(ns, std::memory_order_relaxed);
+            raise_to(max_flush_ns, ns);
+        }
+
+        std::shared_ptr<sink_meter> sink_meters::create(std::string name) {
+            auto meter = std::make_shared<sink_meter>();
+            meter->name = std::move(name);
+            return meter;
+        }
+
+        void sink_meters::attach(const std::shared_ptr<sink_meter>& meter, const spdlog::sink_ptr& sink) {
+            meter->sink = sink.get();
+            meter->alive = sink;
+            std::lock_guard lock{mutex};
+            std::erase_if(meters, [](const auto& m) { return m->alive.expired(); });
+            meters.push_back(meter);
+        }
+
+        std::shared_ptr<sink_meter> sink_meters::find(const spdlog::sinks::sink* sink) {
+            std::lock_guard lock{mutex};
+            for (auto& m : meters)
+                if (m->sink == sink and not m->alive.expired())
+                    return m;
+            return nullptr;
+        }
+
+        std::vector<std::shared_ptr<sink_meter>> sink_meters::live() {
+            std::lock_guard lock{mutex};
+            std::erase_if(meters, [](const auto& m) { return m->alive.expired(); });
+            return meters;
+        }
+
+        __attribute__((visibility("default"))) sink_meters& meters() {
+            static sink_meters registry;
+            return registry;
+        }
+    }  // namespace detail
+
+    stats_snapshot stats() {
+        stats_snapshot snap;
+
+        for (auto& shard : detail::stat_shards)
+            for (size_t level = 0; level < snap.logged.size(); ++level)
+                snap.logged[level] += shard.logged[level].load(std::memory_order_relaxed);
+
+        snap.pool = detail::read(detail::pool_meter);
+        if (auto pool = spdlog::thread_pool()) {
+            snap.pool.overrun = pool->overrun_counter();
+            snap.pool.discarded = detail::discarded(*pool);
+        }
+        snap.spsc = detail::read(detail::spsc_meter);
+
+        for (auto& m : detail::meters().live())
+            snap.sinks.push_back(sink_stats{
+                    m->name,
+                    m->messages.load(std::memory_order_relaxed),
+                    m->bytes.load(std::memory_order_relaxed),
+                    m->flushes.load(std::memory_order_relaxed),
+                    std::chrono::nanoseconds{m->flush_ns.load(std::memory_order_relaxed)},
+                    std::chrono::nanoseconds{m->max_flush_ns.load(std::memory_order_relaxed)}});
+        return snap;
+    }
+
+}  // namespace un::log
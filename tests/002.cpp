@@ -54,7 +54,7 @@ namespace un::log::test {
         unlog::info("hello");
         util::REQUIRE_CONTAINS("[+0.000s] hello");
 
-        auto output = util::stream.str();
+        auto output = util::contents();
         INFO("Contents: " << output);
         CHECK(std::regex_search(output, std::regex(R"(\[\+([0-9]+(?:\.[0-9]+)?)s\]\s+hello)")));
     }
@@ -0,0 +1,54 @@
+#include "utils.hpp"
+
+// Built with UNLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_INFO (see tests/CMakeLists.txt)
+
+namespace un::log::test {
+
+    struct format_counter {
+        static inline int formatted{0};
+    };
+
+}  // namespace un::log::test
+
+template <>
+struct fmt::formatter<un::log::test::format_counter> : fmt::formatter<std::string_view> {
+    template <typename FormatContext>
+    auto format(const un::log::test::format_counter&, FormatContext& ctx) const {
+        ++un::log::test::format_counter::formatted;
+        return fmt::formatter<std::string_view>::format("counted", ctx);
+    }
+};
+
+namespace un::log::test {
+
+    static_assert(detail::active_level == LogLevel::info);
+    static_assert(not detail::level_active(LogLevel::trace));
+    static_assert(not detail::level_active(LogLevel::debug));
+    static_assert(detail::level_active(LogLevel::info));
+    static_assert(detail::level_active(LogLevel::critical));
+
+    TEST_CASE("003 - levels below UNLOG_ACTIVE_LEVEL are compiled out", "[003][elision]") {
+        util::capture_test_logs(LogLevel::trace);
+        format_counter::formatted = 0;
+
+        format_counter counter;
+        unlog::trace("trace {}", counter);
+        unlog::debug("debug {}", counter);
+        unlog::trace(global_logger(), "trace {}", counter);
+        unlog::debug(global_logger(), "debug {}", counter);
+        unlog::log("log {}", LogLevel::debug, counter);
+        unlog::flush();
+
+        CHECK(format_counter::formatted == 0);
+        util::CHECK_EMPTY();
+
+        unlog::info("info {}", counter);
+        unlog::flush();
+
+        CHECK(format_counter::formatted == 1);
+        util::REQUIRE_CONTAINS("info counted");
+
+        set_default_level();
+    }
+
+}  // namespace un::log::test
@@ -0,0 +1,156 @@
+#include "utils.hpp"
+
+#include <fmt/chrono.h>
+
+namespace un::log::test {
+
+    struct formatted_on {
+        int value;
+        static inline std::thread::id thread;
+    };
+
+}  // namespace un::log::test
+
+template <>
+struct fmt::formatter<un::log::test::formatted_on> : fmt::formatter<int> {
+    template <typename FormatContext>
+    auto format(const un::log::test::formatted_on& val, FormatContext& ctx) const {
+        un::log::test::formatted_on::thread = std::this_thread::get_id();
+        return fmt::formatter<int>::format(val.value, ctx);
+    }
+};
+
+namespace un::log::test {
+
+    static_assert(detail::deferrable<int>);
+    static_assert(detail::deferrable<const std::string&>);
+    static_assert(detail::deferrable<const char (&)[6]>);
+    static_assert(detail::deferrable<cspan>);
+    static_assert(detail::deferrable<formatted_on&>);
+    static_assert(not detail::deferrable<int*>);
+    static_assert(not detail::deferrable<std::vector<int>>);
+
+    TEST_CASE("004 - deferred config validation", "[004][deferred][config]") {
+        auto cfg = Config::make_deferred("deferred-cfg", 1, 1024);
+
+        CHECK(cfg.async());
+        CHECK(cfg.deferred());
+        CHECK(cfg.threadsafe());
+
+        REQUIRE_THROWS_AS((Config{"bad", Type::cout, Flags::deferred, 0, 0}), std::invalid_argument);
+    }
+
+    TEST_CASE("004 - deferred records render on the backend thread", "[004][deferred]") {
+        Logger deferred{"deferred-test"};
+        deferred.make_logger(Config::make_deferred("deferred-test-async"), true);
+        logger_ptr& logger = deferred;
+
+        REQUIRE(detail::is_deferred(logger.get()));
+        REQUIRE_FALSE(detail::is_deferred(global_logger().get()));
+
+        util::capture_test_logs();
+
+        std::string owned{"owned"};
+        cspan bytes = "bytes"_sp;
+        formatted_on::thread = {};
+
+        unlog::info(logger, "deferred {} {} {} {} {:.2f} {}", formatted_on{42}, owned, "literal", bytes, 1.5, true);
+        owned = "mutated";
+
+        INFO("Contents: " << util::contents());
+        REQUIRE(util::WAIT_CONTAINS("deferred 42 owned literal bytes 1.50 true"));
+        CHECK(formatted_on::thread != std::this_thread::get_id());
+
+        // arguments that cannot be captured are formatted eagerly and pass through the same sink
+        std::vector<int> values{1, 2, 3};
+        unlog::info(logger, "eager {}", values);
+        REQUIRE(util::WAIT_CONTAINS("eager [1, 2, 3]"));
+    }
+
+    TEST_CASE("004 - a null C string is rejected as fmt rejects it", "[004][deferred]") {
+        Logger deferred{"deferred-null"};
+        deferred.make_logger(Config::make_deferred("deferred-null-async"), true);
+        logger_ptr& logger = deferred;
+        REQUIRE(detail::is_deferred(logger.get()));
+
+        std::vector<std::string> errors;
+        logger->set_error_handler([&errors](const std::string& error) { errors.push_back(error); });
+        util::capture_test_logs();
+
+        const char* missing = nullptr;
+        unlog::info(logger, "null {}", missing);
+        REQUIRE(errors.size() == 1);
+        CHECK(errors.front().contains("string pointer is null"));
+
+        // the recorder keeps it as an empty string
+        spdlog::memory_buf_t record;
+        detail::capture<const char*>::write(record, missing);
+        detail::capture<const char*>::write(record, "after");
+        auto* data = reinterpret_cast<const std::byte*>(record.data());
+        CHECK(detail::capture<const char*>::read(data).empty());
+        CHECK(detail::capture<const char*>::read(data) == "after");
+
+        unlog::info(logger, "not null {}", "after");
+        CHECK(util::WAIT_CONTAINS("not null after"));
+    }
+
+    TEST_CASE("004 - any number of loggers can be deferred", "[004][deferred]") {
+        Logger deferred{"deferred-many"};
+        for (int i = 0; i < 40; ++i) {
+            deferred.make_logger(Config::make_deferred("deferred-many-{}"_format(i)), true);
+            logger_ptr& logger = deferred;
+            REQUIRE(detail::is_deferred(logger.get()));
+        }
+    }
+
+    namespace {
+        template <typename Duration>
+        void log_duration(logger_ptr& logger, Duration d) {
+            unlog::info(logger, "elapsed {}", d);
+        }
+    }  // namespace
+
+    TEST_CASE("004 - deferred records are told apart from text by their path, not the payload", "[004][deferred]") {
+        Logger deferred{"deferred-marks"};
+        deferred.make_logger(Config::make_deferred("deferred-marks-async"), true);
+        logger_ptr& logger = deferred;
+        util::capture_test_logs();
+
+        // what a record looked like when records were recognized by their bytes: a magic, a function, a call site
+        std::string forged{"unlogrec"};
+        forged.append(8, '\x41');
+        forged.append(4, '\0');
+        unlog::info("{}-sync", forged);
+        unlog::info(logger, "{}-deferred", forged);
+        CHECK(util::WAIT_CONTAINS("-sync\n"));
+        CHECK(util::WAIT_CONTAINS("-deferred\n"));
+
+        // one statement, two argument types: each instantiation is its own call site with its own render function
+        log_duration(logger, std::chrono::seconds{3});
+        log_duration(logger, std::chrono::milliseconds{4});
+        REQUIRE(util::WAIT_CONTAINS("elapsed 4ms"));
+        util::CHECK_CONTAINS("elapsed 3s");
+    }
+
+    TEST_CASE("004 - clones of deferred loggers still defer", "[004][deferred]") {
+        util::capture_test_logs();
+        for (auto engine : {Engine::pool, Engine::spsc}) {
+            INFO("Engine: " << engine_string(engine));
+            Logger deferred{"deferred-clone-{}"_format(engine_string(engine))};
+            deferred.make_logger(
+                    Config::make_deferred("deferred-clone-{}-async"_format(engine_string(engine)), 1, 1024, engine),
+                    true);
+            logger_ptr& logger = deferred;
+
+            logger_ptr clone = logger->clone("deferred-clone-{}-copy"_format(engine_string(engine)));
+            REQUIRE(detail::is_deferred(clone.get()));
+            REQUIRE(dynamic_cast<detail::record_logger*>(clone.get()));
+
+            formatted_on::thread = {};
+            unlog::info(clone, "cloned {} {}", formatted_on{engine == Engine::pool ? 1 : 2}, engine_string(engine));
+            REQUIRE(util::WAIT_CONTAINS("cloned {} {}"_format(engine == Engine::pool ? 1 : 2, engine_string(engine))));
+            CHECK(formatted_on::thread != std::this_thread::get_id());
+        }
+    }
+
+}  // namespace un::log::test
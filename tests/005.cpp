@@ -0,0 +1,84 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    TEST_CASE("005 - spsc ring bounds", "[005][spsc]") {
+        auto logger = std::make_shared<detail::spsc_logger>("ring", master_sink, detail::spsc_pool());
+        spdlog::details::log_msg msg{"ring", LogLevel::info, "payload"};
+        detail::spsc_ring ring{3};
+
+        REQUIRE(ring.capacity() == 4);
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(ring.try_push(*logger, msg));
+        REQUIRE_FALSE(ring.try_push(*logger, msg));
+
+        REQUIRE(ring.front() != nullptr);
+        CHECK(ring.front()->logger == logger.get());
+        CHECK(ring.front()->msg.payload == "payload");
+        ring.pop();
+        CHECK(ring.try_push(*logger, msg));
+    }
+
+    TEST_CASE("005 - spsc messages outlive their logger", "[005][spsc]") {
+        util::capture_test_logs();
+
+        auto logger = std::make_shared<detail::spsc_logger>("dropped", master_sink, detail::spsc_pool());
+        logger->info("sent by a dropped logger");
+        logger.reset();
+
+        detail::spsc_pool().drain();
+        CHECK(util::WAIT_CONTAINS("sent by a dropped logger"));
+    }
+
+    TEST_CASE("005 - spsc engine releases dropped loggers once drained", "[005][spsc]") {
+        auto logger = std::make_shared<detail::spsc_logger>("released", master_sink, detail::spsc_pool());
+        std::weak_ptr<detail::spsc_logger> watch = logger;
+        logger->info("sent before the logger is dropped");
+        // the engine holds the logger, not each queued message
+        CHECK(logger.use_count() == 2);
+        logger.reset();
+
+        detail::spsc_pool().drain();
+        auto deadline = std::chrono::steady_clock::now() + 1s;
+        while (not watch.expired() and std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        CHECK(watch.expired());
+    }
+
+    TEST_CASE("005 - spsc engine delivers every thread in order", "[005][spsc]") {
+        auto cfg = Config::make_async("spsc-test-async", 1, 64, Engine::spsc);
+        REQUIRE(cfg.engine == Engine::spsc);
+
+        Logger spsc{"spsc-test"};
+        spsc.make_logger(cfg, true);
+        logger_ptr& logger = spsc;
+
+        util::capture_test_logs();
+
+        constexpr int threads = 4, messages = 100;
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t)
+            producers.emplace_back([&, t] {
+                for (int m = 0; m < messages; ++m)
+                    unlog::info(logger, "spsc t{} m{:03}", t, m);
+            });
+        for (auto& p : producers)
+            p.join();
+
+        // flushing an spsc logger waits for the backend to drain the rings
+        logger->flush();
+        auto output = util::contents();
+
+        for (int t = 0; t < threads; ++t) {
+            size_t last{0};
+            for (int m = 0; m < messages; ++m) {
+                auto pos = output.find("spsc t{} m{:03}"_format(t, m));
+                INFO("thread " << t << " message " << m);
+                REQUIRE(pos != std::string::npos);
+                CHECK(pos >= last);
+                last = pos;
+            }
+        }
+    }
+
+}  // namespace un::log::test
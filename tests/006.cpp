@@ -0,0 +1,138 @@
+#include "utils.hpp"
+
+#include <spdlog/details/null_mutex.h>
+
+namespace un::log::test {
+
+    namespace {
+        // Single-threaded sink that notes whether two threads were ever inside it at once
+        class overlap_sink_st final : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+          public:
+            static inline std::atomic<int> inside{0};
+            static inline std::atomic<bool> overlapped{false};
+            static inline std::atomic<int> written{0};
+
+          protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                if (inside.fetch_add(1) != 0)
+                    overlapped = true;
+                std::this_thread::yield();
+                if (std::string_view{msg.payload.data(), msg.payload.size()}.starts_with("st sink "))
+                    ++written;
+                inside.fetch_sub(1);
+            }
+
+            void flush_() override {}
+        };
+    }  // namespace
+
+    TEST_CASE("006 - fanout sink copy-on-write list", "[006][sinks]") {
+        auto fanout = std::make_shared<fanout_sink>();
+        std::ostringstream a, b;
+        auto sink_a = std::make_shared<spdlog::sinks::ostream_sink_mt>(a);
+        auto sink_b = std::make_shared<spdlog::sinks::ostream_sink_mt>(b);
+        fanout->set_pattern("%v");
+
+        fanout->add_sink(sink_a);
+        auto before = fanout->sinks();
+        fanout->add_sink(sink_b);
+
+        // snapshots are immutable; changes publish a new list
+        CHECK(before->size() == 1);
+        CHECK(fanout->sinks()->size() == 2);
+
+        sink_a->set_pattern("%v");
+        sink_b->set_pattern("%v");
+        sink_b->set_level(LogLevel::warn);
+
+        fanout->log(spdlog::details::log_msg{"fanout", LogLevel::info, "first"});
+        fanout->log(spdlog::details::log_msg{"fanout", LogLevel::warn, "second"});
+
+        CHECK(a.str() == "first\nsecond\n");
+        CHECK(b.str() == "second\n");
+
+        fanout->remove_sink(sink_a);
+        fanout->log(spdlog::details::log_msg{"fanout", LogLevel::err, "third"});
+        CHECK(a.str() == "first\nsecond\n");
+        CHECK(b.str() == "second\nthird\n");
+
+        fanout->set_sinks({sink_a});
+        REQUIRE(fanout->sinks()->size() == 1);
+        CHECK(fanout->sinks()->front() == sink_a);
+    }
+
+    TEST_CASE("006 - fanout sink logs while the list changes", "[006][sinks]") {
+        auto fanout = std::make_shared<fanout_sink>();
+        std::ostringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        sink->set_pattern("%v");
+        fanout->add_sink(sink);
+
+        std::atomic<bool> done{false};
+        std::thread writer{[&] {
+            while (not done) {
+                fanout->add_sink(std::make_shared<spdlog::sinks::null_sink_mt>());
+                fanout->set_sinks({sink, std::make_shared<spdlog::sinks::null_sink_mt>()});
+            }
+        }};
+
+        std::vector<std::thread> loggers;
+        for (int t = 0; t < 4; ++t)
+            loggers.emplace_back([&] {
+                for (int i = 0; i < 500; ++i)
+                    fanout->log(spdlog::details::log_msg{"fanout", LogLevel::info, "x"});
+            });
+        for (auto& l : loggers)
+            l.join();
+        done = true;
+        writer.join();
+
+        CHECK(std::ranges::count(out.str(), 'x') == 2000);
+    }
+
+    TEST_CASE("006 - non-threadsafe configs get a serialized sink", "[006][sinks]") {
+        util::capture_test_logs(Config::make_default("serialized"));
+
+        auto sinks = master_sink->sinks();
+        REQUIRE_FALSE(sinks->empty());
+        auto* wrapper = dynamic_cast<serialized_sink*>(sinks->back().get());
+        REQUIRE(wrapper != nullptr);
+        CHECK(dynamic_cast<capture_sink*>(wrapper->wrapped().get()) != nullptr);
+    }
+
+    TEST_CASE("006 - single-threaded sinks added directly are serialized", "[006][sinks]") {
+        set_default_level(LogLevel::info);
+        unlog::add_sink<overlap_sink_st>();
+        auto added = master_sink->sinks()->back();
+        auto* wrapper = dynamic_cast<serialized_sink*>(added.get());
+        REQUIRE(wrapper != nullptr);
+        CHECK(dynamic_cast<overlap_sink_st*>(wrapper->wrapped().get()) != nullptr);
+
+        constexpr int THREADS{4}, MESSAGES{500};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t)
+            threads.emplace_back([t] {
+                for (int i = 0; i < MESSAGES; ++i)
+                    unlog::info("st sink {} {}", t, i);
+            });
+        for (auto& th : threads)
+            th.join();
+        unlog::flush();
+        // an async default logger may still be delivering
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (overlap_sink_st::written < THREADS * MESSAGES and std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        master_sink->remove_sink(wrapper->wrapped());
+
+        CHECK(overlap_sink_st::written == THREADS * MESSAGES);
+        CHECK_FALSE(overlap_sink_st::overlapped);
+
+        // a sink that locks itself goes in as it is
+        std::ostringstream out;
+        unlog::add_sink<spdlog::sinks::ostream_sink_mt>(std::ref(out));
+        auto mt = master_sink->sinks()->back();
+        CHECK(dynamic_cast<spdlog::sinks::ostream_sink_mt*>(mt.get()) != nullptr);
+        master_sink->remove_sink(mt);
+    }
+
+}  // namespace un::log::test
@@ -0,0 +1,68 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    TEST_CASE("007 - tsc clock tracks the system clock", "[007][clock]") {
+        detail::set_clock(Clock::tsc);
+        REQUIRE(detail::tsc_enabled);
+
+        INFO("invariant tsc: " << detail::tsc_clock::invariant_tsc());
+        CHECK(detail::tsc_source.using_tsc() == detail::tsc_clock::invariant_tsc());
+
+        auto drift = [] {
+            auto tsc = detail::now();
+            auto sys = spdlog::log_clock::now();
+            return std::chrono::abs(sys - tsc);
+        };
+
+        CHECK(drift() < 5ms);
+
+        // consecutive reads never go backwards, including across a recalibration
+        auto prev = detail::now();
+        for (int i = 0; i < 100'000; ++i) {
+            if (i == 50'000)
+                detail::tsc_source.recalibrate();
+            auto next = detail::now();
+            if (next < prev - 1us)
+                FAIL("clock went backwards by " << (prev - next).count());
+            prev = next;
+        }
+
+        std::this_thread::sleep_for(20ms);
+        detail::tsc_source.recalibrate();
+        CHECK(drift() < 5ms);
+
+        detail::set_clock(Clock::system);
+        REQUIRE_FALSE(detail::tsc_enabled);
+    }
+
+    TEST_CASE("007 - messages are stamped from the tsc clock", "[007][clock]") {
+        struct time_sink final : spdlog::sinks::sink {
+            std::atomic<int64_t> last{0};
+
+            void log(const spdlog::details::log_msg& msg) override { last = msg.time.time_since_epoch().count(); }
+            void flush() override {}
+            void set_pattern(const std::string&) override {}
+            void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+        };
+
+        util::capture_test_logs();
+        auto times = std::make_shared<time_sink>();
+        detail::add_sink(times);
+        detail::set_clock(Clock::tsc);
+
+        auto before = spdlog::log_clock::now();
+        unlog::info("stamped {}", 7);
+        unlog::flush();
+        auto after = spdlog::log_clock::now();
+
+        util::REQUIRE_CONTAINS("stamped 7");
+        auto stamped = spdlog::log_clock::time_point{spdlog::log_clock::duration{times->last.load()}};
+        CHECK(stamped > before - 5ms);
+        CHECK(stamped < after + 5ms);
+
+        detail::set_clock(Clock::system);
+        master_sink->remove_sink(times);
+    }
+
+}  // namespace un::log::test
@@ -0,0 +1,64 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    TEST_CASE("008 - call sites are described at compile time", "[008][callsite]") {
+        constexpr detail::site_string<int> site{"value {}"};
+        constexpr auto line = __LINE__ - 1;
+
+        STATIC_REQUIRE(site.site.file == "008.cpp");
+        STATIC_REQUIRE(site.site.line == line);
+        STATIC_REQUIRE(site.site.fmt == "value {}");
+        STATIC_REQUIRE(site.site.key != 0);
+
+        constexpr detail::site_string<int> other{"value {}"};
+        STATIC_REQUIRE(other.site.key != site.site.key);
+
+        detail::site_string<> runtime{fmt::runtime(std::string{"runtime"})};
+        CHECK(runtime.site.key == 0);
+        CHECK(detail::callsites.intern(runtime.site, LogLevel::info) == detail::NO_CALLSITE);
+    }
+
+    TEST_CASE("008 - call sites are interned once", "[008][callsite]") {
+        constexpr detail::site_string<int> site{"interned {}"};
+
+        auto before = detail::callsites.size();
+        auto id = detail::callsites.intern(site.site, LogLevel::warn);
+        REQUIRE(id != detail::NO_CALLSITE);
+        CHECK(detail::callsites.size() == before + 1);
+
+        CHECK(detail::callsites.intern(site.site, LogLevel::warn) == id);
+        CHECK(detail::callsites.size() == before + 1);
+
+        auto* entry = detail::callsites.find(id);
+        REQUIRE(entry);
+        CHECK(entry->site.fmt == "interned {}");
+        CHECK(entry->site.file == "008.cpp");
+        CHECK(entry->level == LogLevel::warn);
+    }
+
+    TEST_CASE("008 - messages carry the call site", "[008][callsite]") {
+        util::capture_test_logs();
+
+        auto before = detail::callsites.size();
+        for (int i = 0; i < 3; ++i)
+            unlog::info("site {}", i);
+        auto line = __LINE__ - 1;
+        unlog::flush();
+
+        // one registration no matter how often the statement runs
+        CHECK(detail::callsites.size() == before + 1);
+        util::REQUIRE_CONTAINS("site 2");
+        util::CHECK_CONTAINS("|008.cpp:{}]"_format(line));
+    }
+
+    TEST_CASE("008 - deferred records refer to the call site", "[008][callsite][deferred]") {
+        Logger deferred{"callsite-deferred"};
+        deferred.make_logger(Config::make_deferred("callsite-deferred-async"), true);
+        util::capture_test_logs();
+
+        unlog::info(deferred, "deferred site {}", 7);
+        REQUIRE(util::WAIT_CONTAINS("deferred site 7"));
+    }
+
+}  // namespace un::log::test
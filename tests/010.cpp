@@ -0,0 +1,97 @@
+#include "utils.hpp"
+
+#include "unlog/file_sinks.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+
+namespace un::log::test {
+
+    namespace {
+        std::string read_file(const fs::path& path) {
+            std::ifstream in{path, std::ios::binary};
+            return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        }
+
+        spdlog::details::log_msg make_msg(std::string_view text) {
+            return spdlog::details::log_msg{"mmap", LogLevel::info, spdlog::string_view_t{text.data(), text.size()}};
+        }
+    }  // namespace
+
+    TEST_CASE("010 - mmap file config", "[010][mmap][config]") {
+        auto cfg = Config::make_file("app.log", "mmap-cfg", FileBackend::mmap);
+
+        CHECK(cfg.file_log());
+        CHECK(cfg.file_backend == FileBackend::mmap);
+        CHECK(Config::make_file("app.log").file_backend == FileBackend::stdio);
+    }
+
+    TEST_CASE("010 - mmap sink spans chunks and trims on close", "[010][mmap]") {
+        auto path = fs::temp_directory_path() / "unlog-010.log";
+        fs::remove(path);
+
+        std::string expected;
+        {
+            mmap_file_sink_mt sink{path, MmapPolicy{.chunk_size = 4096, .sync = MmapPolicy::Sync::async}};
+            sink.set_pattern("%v");
+
+            // lines long enough to straddle several chunk boundaries
+            for (int i = 0; i < 100; ++i) {
+                auto line = "line {} {}"_format(i, std::string(97, 'a' + i % 26));
+                sink.log(make_msg(line));
+                expected += line + "\n";
+            }
+            sink.flush();
+            CHECK(sink.size() == expected.size());
+            CHECK(fs::file_size(path) % 4096 == 0);
+        }
+
+        CHECK(fs::file_size(path) == expected.size());
+        CHECK(read_file(path) == expected);
+
+        // reopening appends
+        {
+            mmap_file_sink_st sink{path, MmapPolicy{.chunk_size = 4096}};
+            sink.set_pattern("%v");
+            sink.log(make_msg("appended"));
+        }
+        CHECK(read_file(path) == expected + "appended\n");
+
+        fs::remove(path);
+    }
+
+    TEST_CASE("010 - mmap sink data survives kill -9", "[010][mmap]") {
+        auto path = fs::temp_directory_path() / "unlog-010-crash.log";
+        fs::remove(path);
+
+        auto pid = ::fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            auto* sink = new mmap_file_sink_st{path, MmapPolicy{.chunk_size = 1 << 16}};
+            sink->set_pattern("%v");
+            sink->log(make_msg("before the crash"));
+            ::kill(::getpid(), SIGKILL);
+        }
+
+        int status;
+        ::waitpid(pid, &status, 0);
+        REQUIRE(WIFSIGNALED(status));
+
+        // the preallocated chunk is still there, padded with NULs after the data
+        auto contents = read_file(path);
+        CHECK(contents.size() == 1 << 16);
+        CHECK(contents.starts_with("before the crash\n"));
+
+        {
+            mmap_file_sink_st sink{path, MmapPolicy{.chunk_size = 1 << 16}};
+            sink.set_pattern("%v");
+            sink.log(make_msg("after restart"));
+        }
+        CHECK(read_file(path) == "before the crash\nafter restart\n");
+
+        fs::remove(path);
+    }
+
+}  // namespace un::log::test
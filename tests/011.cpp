@@ -0,0 +1,93 @@
+#include "utils.hpp"
+
+#include "unlog/file_sinks.hpp"
+
+#include <fstream>
+#include <thread>
+
+namespace un::log::test {
+
+    namespace {
+        std::string read_file(const fs::path& path) {
+            std::ifstream in{path, std::ios::binary};
+            return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        }
+
+        spdlog::details::log_msg make_msg(std::string_view text) {
+            return spdlog::details::log_msg{"batch", LogLevel::info, spdlog::string_view_t{text.data(), text.size()}};
+        }
+    }  // namespace
+
+    TEST_CASE("011 - batched file config", "[011][batch][config]") {
+        auto cfg = Config::make_file("app.log", "batch-cfg", FileBackend::uring);
+
+        CHECK(cfg.file_log());
+        CHECK(cfg.file_backend == FileBackend::uring);
+        CHECK(file_backend_string(cfg.file_backend) == "uring");
+    }
+
+    TEST_CASE("011 - batched sink writes every message in order", "[011][batch]") {
+        auto path = fs::temp_directory_path() / "unlog-011.log";
+        fs::remove(path);
+
+        std::string expected;
+        {
+            batched_file_sink_mt sink{path, BatchPolicy{.buffer_size = 4096, .max_buffers = 4}};
+            sink.set_pattern("%v");
+
+            for (int i = 0; i < 2000; ++i) {
+                auto line = "line {} {}"_format(i, std::string(40, 'a' + i % 26));
+                sink.log(make_msg(line));
+                expected += line + "\n";
+            }
+            sink.flush();
+            CHECK(read_file(path) == expected);
+
+            auto stats = sink.stats();
+            INFO("io_uring: " << stats.uring << ", batches: " << stats.batches);
+            CHECK(stats.messages == 2000);
+            CHECK(stats.bytes == expected.size());
+            CHECK(stats.batches < stats.messages);
+            CHECK(stats.write_errors == 0);
+            CHECK(stats.largest_batch >= 4096);
+            CHECK(stats.average_batch() > 0.0);
+        }
+
+        // reopening appends, and the destructor writes out what was never flushed
+        {
+            batched_file_sink_st sink{path};
+            sink.set_pattern("%v");
+            sink.log(make_msg("appended"));
+        }
+        CHECK(read_file(path) == expected + "appended\n");
+        fs::remove(path);
+    }
+
+    TEST_CASE("011 - batched sink writes a partial buffer after the interval", "[011][batch]") {
+        auto path = fs::temp_directory_path() / "unlog-011-interval.log";
+        fs::remove(path);
+
+        batched_file_sink_mt sink{path, BatchPolicy{.interval = std::chrono::milliseconds{5}}};
+        sink.set_pattern("%v");
+        sink.log(make_msg("idle"));
+
+        for (int i = 0; i < 200 and read_file(path).empty(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        CHECK(read_file(path) == "idle\n");
+        fs::remove(path);
+    }
+
+    TEST_CASE("011 - batched file logger", "[011][batch]") {
+        auto path = fs::temp_directory_path() / "unlog-011-logger.log";
+        fs::remove(path);
+
+        Logger batched{"batch-test"};
+        batched.make_logger(Config::make_file(path, "batch-test-file", FileBackend::uring), true);
+        logger_ptr& logger = batched;
+
+        unlog::info(logger, "hello {}", 11);
+        logger->flush();
+        CHECK(read_file(path).find("hello 11") != std::string::npos);
+    }
+
+}  // namespace un::log::test
@@ -0,0 +1,173 @@
+#include "utils.hpp"
+
+#include "unlog/file_sinks.hpp"
+
+#ifdef UNLOG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <fstream>
+#include <thread>
+
+namespace un::log::test {
+
+    namespace {
+        std::string read_file(const fs::path& path) {
+#ifdef UNLOG_HAVE_ZLIB
+            if (path.extension() == ".gz") {
+                std::string out;
+                auto* in = ::gzopen(path.c_str(), "rb");
+                REQUIRE(in);
+                std::array<char, 4096> block;
+                for (int n; (n = ::gzread(in, block.data(), block.size())) > 0;)
+                    out.append(block.data(), static_cast<size_t>(n));
+                ::gzclose(in);
+                return out;
+            }
+#endif
+            std::ifstream in{path, std::ios::binary};
+            return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        }
+
+        // Archives in rotation order, whether compressed or not
+        std::vector<fs::path> archives(const fs::path& dir) {
+            std::vector<fs::path> found;
+            for (uint64_t n = 1; n < 10'000; ++n) {
+                auto plain = dir / "app.{}.log"_format(n);
+                if (fs::exists(plain))
+                    found.push_back(plain);
+                else if (fs::exists(plain.string() + ".gz"))
+                    found.push_back(plain.string() + ".gz");
+            }
+            return found;
+        }
+
+        std::string read_all(const fs::path& dir) {
+            std::string out;
+            for (auto& path : archives(dir))
+                out += read_file(path);
+            return out + read_file(dir / "app.log");
+        }
+
+        spdlog::details::log_msg make_msg(std::string_view text) {
+            return spdlog::details::log_msg{"rotate", LogLevel::info, spdlog::string_view_t{text.data(), text.size()}};
+        }
+
+        fs::path fresh_dir(std::string_view name) {
+            auto dir = fs::temp_directory_path() / name;
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            return dir;
+        }
+
+        // Logs `count` lines, pausing now and then so the worker gets to prepare the next file
+        std::string log_lines(spdlog::sinks::sink& sink, int count) {
+            std::string expected;
+            for (int i = 0; i < count; ++i) {
+                auto line = "line {} {}"_format(i, std::string(40, 'a' + i % 26));
+                sink.log(make_msg(line));
+                expected += line + "\n";
+                if (i % 10 == 9)
+                    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+            }
+            return expected;
+        }
+    }  // namespace
+
+    TEST_CASE("012 - rotating file config", "[012][rotate][config]") {
+        auto cfg = Config::make_rotating("app.log", RotationPolicy{.max_size = 1 << 20, .max_files = 5});
+
+        CHECK(cfg.file_log());
+        CHECK(cfg.rotation.enabled());
+        CHECK_FALSE(Config::make_file("app.log").rotation.enabled());
+
+        REQUIRE_THROWS_AS(Config::make_rotating("app.log", RotationPolicy{}), std::invalid_argument);
+        REQUIRE_THROWS_AS(
+                Config::make_rotating("app.log", RotationPolicy{.max_size = 1, .compression = 10}),
+                std::invalid_argument);
+
+        cfg.file_backend = FileBackend::mmap;
+        REQUIRE_THROWS_AS(cfg.validate(), std::invalid_argument);
+        CHECK_THROWS_AS(Logger{"rotate-mmap"}.make_logger(cfg, true), std::invalid_argument);
+    }
+
+    TEST_CASE("012 - rotating sink rotates by size without losing lines", "[012][rotate]") {
+        auto dir = fresh_dir("unlog-012-size");
+
+        std::string expected;
+        {
+            rotating_file_sink_mt sink{dir / "app.log", RotationPolicy{.max_size = 1000}};
+            sink.set_pattern("%v");
+            expected = log_lines(sink, 200);
+        }
+
+        CHECK(archives(dir).size() >= 2);
+        CHECK(read_all(dir) == expected);
+        CHECK_FALSE(fs::exists(dir / ".app.log.next"));
+
+        // a new sink continues the numbering
+        auto count = archives(dir).size();
+        {
+            rotating_file_sink_st sink{dir / "app.log", RotationPolicy{.max_size = 1}};
+            sink.set_pattern("%v");
+            sink.log(make_msg("after restart"));
+        }
+        CHECK(archives(dir).size() == count + 1);
+        CHECK(read_all(dir) == expected + "after restart\n");
+        fs::remove_all(dir);
+    }
+
+    TEST_CASE("012 - rotating sink keeps max_files archives", "[012][rotate]") {
+        auto dir = fresh_dir("unlog-012-retention");
+
+        std::string expected;
+        {
+            rotating_file_sink_mt sink{dir / "app.log", RotationPolicy{.max_size = 500, .max_files = 2}};
+            sink.set_pattern("%v");
+            expected = log_lines(sink, 200);
+        }
+
+        auto kept = archives(dir);
+        REQUIRE(kept.size() == 2);
+        CHECK(expected.ends_with(read_all(dir)));
+        fs::remove_all(dir);
+    }
+
+#ifdef UNLOG_HAVE_ZLIB
+    TEST_CASE("012 - rotating sink compresses archives", "[012][rotate]") {
+        auto dir = fresh_dir("unlog-012-gzip");
+
+        std::string expected;
+        {
+            rotating_file_sink_mt sink{dir / "app.log", RotationPolicy{.max_size = 1000, .compression = 6}};
+            sink.set_pattern("%v");
+            expected = log_lines(sink, 200);
+        }
+
+        auto kept = archives(dir);
+        REQUIRE(kept.size() >= 2);
+        for (auto& path : kept)
+            CHECK(path.extension() == ".gz");
+        CHECK(read_all(dir) == expected);
+        fs::remove_all(dir);
+    }
+#endif
+
+    TEST_CASE("012 - rotating sink rotates on the interval", "[012][rotate]") {
+        auto dir = fresh_dir("unlog-012-interval");
+        {
+            rotating_file_sink_mt sink{dir / "app.log", RotationPolicy{.interval = std::chrono::seconds{1}}};
+            sink.set_pattern("%v");
+            sink.log(make_msg("before"));
+            std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+            sink.log(make_msg("after"));
+        }
+
+        auto kept = archives(dir);
+        REQUIRE(kept.size() == 1);
+        CHECK(read_file(kept[0]) == "before\n");
+        CHECK(read_file(dir / "app.log") == "after\n");
+        fs::remove_all(dir);
+    }
+
+}  // namespace un::log::test
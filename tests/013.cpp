@@ -0,0 +1,57 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    struct counted {
+        static inline int formatted{0};
+    };
+
+}  // namespace un::log::test
+
+template <>
+struct fmt::formatter<un::log::test::counted> : fmt::formatter<int> {
+    template <typename FormatContext>
+    auto format(const un::log::test::counted&, FormatContext& ctx) const {
+        return fmt::formatter<int>::format(++un::log::test::counted::formatted, ctx);
+    }
+};
+
+namespace un::log::test {
+
+    TEST_CASE("013 - level gate follows the default level", "[013][level]") {
+        set_default_level(LogLevel::trace);
+        CHECK(detail::min_level == LogLevel::trace);
+        CHECK(enabled(LogLevel::trace));
+
+        set_default_level(LogLevel::info);
+        CHECK_FALSE(enabled(LogLevel::trace));
+        CHECK_FALSE(enabled(LogLevel::debug));
+        CHECK(enabled(LogLevel::info));
+        CHECK(enabled(LogLevel::critical));
+    }
+
+    TEST_CASE("013 - level gate follows the lowest logger", "[013][level]") {
+        Logger gated{"gate-test"};
+        logger_ptr& logger = gated;
+        set_default_level(LogLevel::info);
+        counted::formatted = 0;
+
+        unlog::debug(logger, "gated {}", counted{});
+        CHECK(counted::formatted == 0);
+
+        gated.set_level(LogLevel::trace);
+        CHECK(enabled(LogLevel::trace));
+        unlog::trace(logger, "through {}", counted{});
+        CHECK(counted::formatted == 1);
+
+        // the gate is open, but the global logger itself still rejects it
+        unlog::trace("global {}", counted{});
+        CHECK(counted::formatted == 1);
+
+        gated.set_level(LogLevel::info);
+        CHECK_FALSE(enabled(LogLevel::trace));
+        unlog::trace(logger, "gated again {}", counted{});
+        CHECK(counted::formatted == 1);
+    }
+
+}  // namespace un::log::test
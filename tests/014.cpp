@@ -0,0 +1,192 @@
+#include "utils.hpp"
+
+#include <set>
+
+namespace un::log::test {
+
+    namespace {
+        // Distinct lines containing `needle`: every capture_test_logs adds another sink writing to the same stream
+        size_t count_lines(const std::string& text, std::string_view needle) {
+            std::set<std::string> lines;
+            std::istringstream in{text};
+            for (std::string line; std::getline(in, line);)
+                if (line.contains(needle))
+                    lines.insert(line);
+            return lines.size();
+        }
+    }  // namespace
+
+    TEST_CASE("014 - every n admits the first of each n", "[014][limit]") {
+        util::capture_test_logs();
+
+        for (int i = 0; i < 10; ++i)
+            unlog::warn_every(3, "every {}", i);
+        unlog::flush();
+
+        auto out = util::contents();
+        INFO("Contents: " << out);
+        CHECK(count_lines(out, "every ") == 4);
+        CHECK(out.contains("every 0\n"));
+        CHECK(out.contains("every 3 [2 suppressed]"));
+        CHECK(out.contains("every 9 [2 suppressed]"));
+        CHECK_FALSE(out.contains("every 1"));
+    }
+
+    TEST_CASE("014 - call sites are limited independently", "[014][limit]") {
+        util::capture_test_logs();
+
+        for (int i = 0; i < 4; ++i) {
+            unlog::info_every(4, "first {}", i);
+            unlog::info_every(2, "second {}", i);
+        }
+        unlog::flush();
+
+        auto out = util::contents();
+        INFO("Contents: " << out);
+        CHECK(count_lines(out, "first ") == 1);
+        CHECK(count_lines(out, "second ") == 2);
+    }
+
+    TEST_CASE("014 - call sites without an ID are limited independently", "[014][limit]") {
+        util::capture_test_logs();
+
+        for (int i = 0; i < 4; ++i) {
+            unlog::info_every(4, fmt::runtime("runtime first {}"), i);
+            unlog::info_every(2, fmt::runtime("runtime second {}"), i);
+        }
+        unlog::flush();
+
+        auto out = util::contents();
+        INFO("Contents: " << out);
+        CHECK(count_lines(out, "runtime first ") == 1);
+        CHECK(count_lines(out, "runtime second ") == 2);
+    }
+
+    TEST_CASE("014 - the suppressed count keeps the message's fields", "[014][limit]") {
+        util::capture_test_logs();
+
+        for (int i = 0; i < 4; ++i)
+            unlog::warn_every(2, "fields {}", i, kv("n", i));
+        unlog::flush();
+
+        util::CHECK_CONTAINS("fields 0 n=0\n");
+        util::CHECK_CONTAINS("fields 2 [1 suppressed] n=2\n");
+    }
+
+    TEST_CASE("014 - per second admits a burst then reports the rest", "[014][limit]") {
+        constexpr uint64_t start{1'000'000'000'000};
+        detail::per_second policy{5};
+        detail::limit_state state;
+        uint64_t suppressed = 0;
+
+        auto burst = [&](uint64_t now) {
+            int admitted = 0;
+            for (int i = 0; i < 100; ++i)
+                admitted += policy.admit(state, suppressed, now);
+            return admitted;
+        };
+        CHECK(burst(start) == 5);
+
+        // one message's worth of budget comes back every 200ms
+        suppressed = 0;
+        CHECK(burst(start + 250'000'000) == 1);
+        CHECK(suppressed == 95);
+        CHECK(burst(start + 250'000'000) == 0);
+
+        // the full burst is back after a second without messages
+        CHECK(burst(start + 2'000'000'000) == 5);
+    }
+
+    TEST_CASE("014 - per second clamps tiny rates", "[014][limit]") {
+        detail::limit_state state;
+        uint64_t suppressed = 0;
+        detail::per_second policy{1e-300};
+
+        CHECK(policy.admit(state, suppressed, 1'000));
+        CHECK_FALSE(policy.admit(state, suppressed, 2'000));
+    }
+
+    TEST_CASE("014 - per second limits the logger's messages", "[014][limit]") {
+        util::capture_test_logs();
+
+        for (int i = 0; i < 100; ++i)
+            unlog::error_per_sec(5, "burst {}", i);
+        unlog::flush();
+        CHECK(count_lines(util::contents(), "burst ") == 5);
+    }
+
+    TEST_CASE("014 - per second runs on the steady clock", "[014][limit]") {
+        detail::limit_state state;
+        uint64_t suppressed = 0;
+        for (int i = 0; i < 3; ++i)
+            CHECK(detail::per_second{3}.admit(state, suppressed));
+        CHECK_FALSE(detail::per_second{3}.admit(state, suppressed));
+
+        // the arrival time is within the burst of the steady clock, whatever the wall clock says
+        auto steady = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch());
+        auto tat = std::chrono::nanoseconds{state.count.load()};
+        CHECK(tat > steady);
+        CHECK(tat <= steady + 1s);
+    }
+
+    TEST_CASE("014 - sampling admits the requested fraction", "[014][limit]") {
+        detail::limit_state state;
+        uint64_t suppressed = 0;
+
+        int admitted = 0;
+        for (int i = 0; i < 10'000; ++i)
+            admitted += detail::sampled{0.25}.admit(state, suppressed);
+        CHECK(admitted > 2'000);
+        CHECK(admitted < 3'000);
+
+        for (int i = 0; i < 100; ++i)
+            CHECK_FALSE(detail::sampled{0.0}.admit(state, suppressed));
+        CHECK(detail::sampled{1.0}.admit(state, suppressed));
+        CHECK(suppressed >= 100);
+
+        util::capture_test_logs();
+        for (int i = 0; i < 10; ++i)
+            unlog::info_sampled(1.0, "always {}", i);
+        unlog::flush();
+        CHECK(count_lines(util::contents(), "always ") == 10);
+    }
+
+    TEST_CASE("014 - disabled levels are not counted as suppressed", "[014][limit]") {
+        util::capture_test_logs(LogLevel::info);
+
+        for (int i = 0; i < 6; ++i) {
+            if (i == 5)
+                set_default_level(LogLevel::debug);
+            unlog::debug_every(2, "limited {}", i);
+        }
+        set_default_level(LogLevel::info);
+        unlog::flush();
+
+        util::CHECK_CONTAINS("limited 5\n");
+    }
+
+    TEST_CASE("014 - limited call sites below the logger level still reach the flight recorder", "[014][limit]") {
+        util::capture_test_logs(LogLevel::info);
+        set_flight_recorder(RecorderPolicy{.enabled = true, .level = LogLevel::debug, .dump_on_crash = false});
+
+        for (int i = 0; i < 3; ++i)
+            unlog::debug_every(2, "quiet {}", i);
+
+        std::stringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        sink->set_pattern("%v");
+        dump_flight_recorder(*sink);
+        set_flight_recorder(RecorderPolicy{});
+        unlog::flush();
+
+        auto dumped = out.str();
+        INFO("Dump: " << dumped);
+        CHECK(dumped.contains("quiet 0\n"));
+        CHECK(dumped.contains("quiet 1\n"));
+        CHECK(dumped.contains("quiet 2\n"));
+        CHECK_FALSE(dumped.contains("suppressed"));
+        CHECK_FALSE(util::contents().contains("quiet"));
+    }
+
+}  // namespace un::log::test
@@ -0,0 +1,173 @@
+#include "utils.hpp"
+
+#include <set>
+
+namespace un::log::test {
+
+    namespace {
+        using namespace std::chrono_literals;
+
+        struct capture {
+            std::stringstream out;
+            std::shared_ptr<spdlog::sinks::ostream_sink_mt> sink{std::make_shared<spdlog::sinks::ostream_sink_mt>(out)};
+
+            capture() { sink->set_pattern("%v"); }
+        };
+
+        // Readable while a backend thread is still writing to it
+        struct locked_capture final : spdlog::sinks::base_sink<std::mutex> {
+            std::string out;
+
+            std::string str() {
+                std::lock_guard lock{mutex_};
+                return out;
+            }
+
+          protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                spdlog::memory_buf_t formatted;
+                formatter_->format(msg, formatted);
+                out.append(formatted.data(), formatted.size());
+            }
+            void flush_() override {}
+        };
+
+        spdlog::details::log_msg make_msg(
+                std::string_view text, spdlog::log_clock::time_point time = spdlog::log_clock::now(), int line = 1) {
+            return spdlog::details::log_msg{
+                    time,
+                    spdlog::source_loc{"015.cpp", line, "test"},
+                    "dedup",
+                    LogLevel::info,
+                    spdlog::string_view_t{text.data(), text.size()}};
+        }
+    }  // namespace
+
+    TEST_CASE("015 - dedup collapses consecutive repeats", "[015][dedup]") {
+        capture cap;
+        dedup_sink sink{cap.sink, 1min};
+
+        for (int i = 0; i < 5; ++i)
+            sink.log(make_msg("retrying"));
+        sink.log(make_msg("connected"));
+        sink.log(make_msg("retrying"));
+
+        CHECK(cap.out.str() == "retrying\nlast message repeated 4 times\nconnected\nretrying\n");
+    }
+
+    TEST_CASE("015 - dedup tells call sites apart", "[015][dedup]") {
+        capture cap;
+        dedup_sink sink{cap.sink, 1min};
+
+        sink.log(make_msg("same", spdlog::log_clock::now(), 1));
+        sink.log(make_msg("same", spdlog::log_clock::now(), 2));
+        sink.log(make_msg("same", spdlog::log_clock::now(), 2));
+
+        CHECK(cap.out.str() == "same\nsame\n");
+        sink.flush();
+        CHECK(cap.out.str() == "same\nsame\nlast message repeated 1 times\n");
+    }
+
+    TEST_CASE("015 - dedup summaries keep their own copy of the source", "[015][dedup]") {
+        capture cap;
+        cap.sink->set_pattern("%s:%#:%! %v");
+        dedup_sink sink{cap.sink, 1min};
+
+        // the way spill replay and the shm collector hand over names: in a buffer reused for the next message
+        std::string file{"replayed.cpp"}, function{"replay"};
+        for (int i = 0; i < 3; ++i) {
+            file = "replayed.cpp";
+            function = "replay";
+            sink.log(spdlog::details::log_msg{
+                    {file.c_str(), 7, function.c_str()}, "dedup", LogLevel::info, "again"});
+            file.assign(file.size(), 'x');
+            function.assign(function.size(), 'x');
+        }
+        sink.flush();
+
+        CHECK(cap.out.str() == "replayed.cpp:7:replay again\nreplayed.cpp:7:replay last message repeated 2 times\n");
+    }
+
+    TEST_CASE("015 - dedup writes a repeat again after the window", "[015][dedup]") {
+        capture cap;
+        dedup_sink sink{cap.sink, 100ms};
+
+        auto start = spdlog::log_clock::now();
+        sink.log(make_msg("tick", start));
+        sink.log(make_msg("tick", start + 50ms));
+        sink.log(make_msg("tick", start + 150ms));
+
+        CHECK(cap.out.str() == "tick\nlast message repeated 1 times\ntick\n");
+    }
+
+    TEST_CASE("015 - dedup counts every repeat across threads", "[015][dedup]") {
+        capture cap;
+        {
+            dedup_sink sink{cap.sink, 1h};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&sink] {
+                    for (int i = 0; i < 10'000; ++i)
+                        sink.log(make_msg(i % 1000 == 999 ? "marker" : "spam"));
+                });
+            for (auto& t : threads)
+                t.join();
+        }
+
+        // every message is either written or counted in a summary
+        size_t total = 0;
+        std::istringstream in{cap.out.str()};
+        for (std::string line; std::getline(in, line);) {
+            if (line.starts_with("last message repeated "))
+                total += std::stoul(line.substr(22));
+            else
+                ++total;
+        }
+        CHECK(total == 40'000);
+    }
+
+    TEST_CASE("015 - dedup is enabled through the config", "[015][dedup][config]") {
+        auto conf = Config::make_async("dedup-config");
+        conf.dedup_window = 1s;
+
+        auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+        detail::add_sink(conf, sink);
+
+        auto sinks = master_sink->sinks();
+        auto dedup = std::dynamic_pointer_cast<dedup_sink>(sinks->back());
+        REQUIRE(dedup);
+        CHECK(dedup->wrapped() == sink);
+        master_sink->remove_sink(sinks->back());
+    }
+
+    TEST_CASE("015 - dedup collapses repeats from async loggers", "[015][dedup][config]") {
+        for (auto engine : {Engine::pool, Engine::spsc}) {
+            INFO("Engine: " << engine_string(engine));
+            Logger async{"dedup-{}"_format(engine_string(engine))};
+            async.make_logger(Config::make_async("dedup-{}-async"_format(engine_string(engine)), 1, 64, engine), true);
+            logger_ptr& logger = async;
+
+            Config conf{"dedup-async", Type::cout, Flags::threadsafe, 0, 0, "%v"};
+            conf.dedup_window = 1min;
+            auto sink = std::make_shared<locked_capture>();
+            detail::add_sink(conf, sink);
+            auto dedup = master_sink->sinks()->back();
+
+            set_default_level(LogLevel::info);
+            for (int i = 0; i < 5; ++i)
+                unlog::info(logger, "retrying");
+            unlog::info(logger, "connected");
+
+            // the pool backend's flush only queues behind the messages; poll until the last one arrives
+            auto deadline = std::chrono::steady_clock::now() + 1s;
+            while (not sink->str().contains("connected") and std::chrono::steady_clock::now() < deadline) {
+                logger->flush();
+                std::this_thread::sleep_for(1ms);
+            }
+            master_sink->remove_sink(dedup);
+
+            CHECK(sink->str() == "retrying\nlast message repeated 4 times\nconnected\n");
+        }
+    }
+
+}  // namespace un::log::test
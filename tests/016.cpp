@@ -0,0 +1,252 @@
+#include "utils.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <fstream>
+#include <latch>
+#include <thread>
+
+namespace un::log::test {
+
+    namespace {
+        struct capture {
+            std::stringstream out;
+            std::shared_ptr<spdlog::sinks::ostream_sink_mt> sink{std::make_shared<spdlog::sinks::ostream_sink_mt>(out)};
+
+            capture() { sink->set_pattern("%l %v"); }
+
+            std::string dump() {
+                dump_flight_recorder(*sink);
+                return out.str();
+            }
+        };
+
+        RecorderPolicy recording(LogLevel level, size_t records = 256) {
+            return RecorderPolicy{.enabled = true, .level = level, .records = records, .dump_on_crash = false};
+        }
+
+        void stop_recording() {
+            set_flight_recorder(RecorderPolicy{});
+        }
+
+        volatile bool bottomless{true};
+
+        // Recurses until the stack runs out; the volatile frame keeps the compiler from folding it away
+        [[gnu::noinline]] int overflow(int depth) {
+            volatile char frame[1024];
+            frame[0] = static_cast<char>(depth);
+            return bottomless ? overflow(depth + 1) + frame[0] : frame[0];
+        }
+    }  // namespace
+
+    TEST_CASE("016 - flight recorder keeps messages below the logger level", "[016][recorder]") {
+        util::capture_test_logs(LogLevel::info);
+        set_flight_recorder(recording(LogLevel::debug));
+
+        unlog::debug("recorded {} {}", 42, "quietly");
+        unlog::trace("below the recorder too");
+        unlog::info("logged and recorded {}", 7);
+        unlog::flush();
+        stop_recording();
+
+        CHECK_FALSE(util::contents().contains("recorded 42 quietly"));
+        CHECK(util::contents().contains("logged and recorded 7"));
+
+        capture cap;
+        auto dumped = cap.dump();
+        INFO("Dump: " << dumped);
+        CHECK(dumped.contains("debug recorded 42 quietly"));
+        CHECK(dumped.contains("info logged and recorded 7"));
+        CHECK_FALSE(dumped.contains("below the recorder too"));
+        CHECK(dumped.find("recorded 42 quietly") < dumped.find("logged and recorded 7"));
+    }
+
+    TEST_CASE("016 - flight recorder level counts towards the level gate", "[016][recorder]") {
+        set_default_level(LogLevel::info);
+        auto before = unlog::enabled(LogLevel::trace);
+
+        set_flight_recorder(recording(LogLevel::trace));
+        CHECK(unlog::enabled(LogLevel::trace));
+
+        stop_recording();
+        CHECK(unlog::enabled(LogLevel::trace) == before);
+    }
+
+    TEST_CASE("016 - flight recorder keeps the last messages of each thread", "[016][recorder]") {
+        set_default_level(LogLevel::info);
+        set_flight_recorder(recording(LogLevel::debug, 4));
+
+        // rings take the new size when they are created, so log from threads that do not have one yet; they stay alive
+        // until all have logged, as an exited thread's ring goes to the next thread
+        std::latch logged{3};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t)
+            threads.emplace_back([t, &logged] {
+                for (int i = 0; i < 10; ++i)
+                    unlog::debug("wrap t{} n{}", t, i);
+                logged.arrive_and_wait();
+            });
+        for (auto& th : threads)
+            th.join();
+        stop_recording();
+
+        capture cap;
+        auto dumped = cap.dump();
+        INFO("Dump: " << dumped);
+        for (int t = 0; t < 3; ++t) {
+            for (int i = 0; i < 6; ++i)
+                CHECK_FALSE(dumped.contains("wrap t{} n{}\n"_format(t, i)));
+            for (int i = 6; i < 10; ++i)
+                CHECK(dumped.contains("wrap t{} n{}\n"_format(t, i)));
+        }
+    }
+
+    TEST_CASE("016 - flight recorder reuses rings of an earlier size once it cannot create more", "[016][recorder]") {
+        set_default_level(LogLevel::info);
+        set_flight_recorder(recording(LogLevel::debug, 8));
+
+        // more live threads than rings: whatever earlier tests left, the table fills and a thread goes unrecorded
+        auto missed = detail::recorder.unrecorded();
+        constexpr auto THREADS = detail::flight_recorder::MAX_RINGS + 1;
+        std::latch logged{THREADS};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t)
+            threads.emplace_back([&logged] {
+                unlog::debug("crowded");
+                logged.arrive_and_wait();
+            });
+        for (auto& th : threads)
+            th.join();
+        CHECK(detail::recorder.unrecorded() > missed);
+
+        // no ring of the new size can be created, so the next thread takes one of the released ones
+        missed = detail::recorder.unrecorded();
+        set_flight_recorder(recording(LogLevel::debug, 16));
+        std::thread{[] { unlog::debug("recorded after {}", "resize"); }}.join();
+        stop_recording();
+        CHECK(detail::recorder.unrecorded() == missed);
+
+        capture cap;
+        auto dumped = cap.dump();
+        CHECK(dumped.contains("debug recorded after resize"));
+    }
+
+    TEST_CASE("016 - a thread left without a ring records once one is given back", "[016][recorder]") {
+        set_default_level(LogLevel::info);
+        set_flight_recorder(recording(LogLevel::debug, 8));
+
+        // as many holders as rings, so with this thread's own ring the table is taken and the late thread finds none
+        constexpr auto HOLDERS = detail::flight_recorder::MAX_RINGS;
+        std::latch held{HOLDERS}, release{1}, tried{1}, retry{1};
+        std::vector<std::thread> holders;
+        for (size_t t = 0; t < HOLDERS; ++t)
+            holders.emplace_back([&] {
+                unlog::debug("holding");
+                held.count_down();
+                release.wait();
+            });
+        held.wait();
+
+        auto missed = detail::recorder.unrecorded();
+        std::thread late{[&] {
+            unlog::debug("late before");
+            tried.count_down();
+            retry.wait();
+            unlog::debug("late after");
+        }};
+        tried.wait();
+        CHECK(detail::recorder.unrecorded() == missed + 1);
+
+        release.count_down();
+        for (auto& th : holders)
+            th.join();
+        retry.count_down();
+        late.join();
+        stop_recording();
+
+        capture cap;
+        auto dumped = cap.dump();
+        CHECK_FALSE(dumped.contains("late before"));
+        CHECK(dumped.contains("debug late after"));
+    }
+
+    TEST_CASE("016 - flight recorder formats what it cannot capture and truncates what does not fit", "[016][recorder]") {
+        set_default_level(LogLevel::info);
+        set_flight_recorder(recording(LogLevel::debug));
+
+        std::vector<int> values{1, 2, 3};
+        std::string long_text(1000, 'z');
+        unlog::debug("values {}", values);
+        unlog::debug("long {}", long_text);
+        stop_recording();
+
+        capture cap;
+        auto dumped = cap.dump();
+        INFO("Dump: " << dumped);
+        CHECK(dumped.contains("debug values [1, 2, 3]"));
+        CHECK(dumped.contains("debug long zzz"));
+        CHECK(dumped.contains("zzz...\n"));
+        CHECK_FALSE(dumped.contains(long_text));
+    }
+
+    TEST_CASE("016 - flight recorder is dumped when the process aborts", "[016][recorder]") {
+        auto path = fs::temp_directory_path() / "unlog_016_crash.log";
+        fs::remove(path);
+
+        auto pid = ::fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            // the test framework installs its own handler, which the recorder leaves in place
+            std::signal(SIGABRT, SIG_DFL);
+            set_flight_recorder(RecorderPolicy{.enabled = true, .level = LogLevel::trace, .dump_file = path});
+            unlog::trace("last words {}", 99);
+            std::abort();
+        }
+
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        CHECK(WIFSIGNALED(status));
+        CHECK(WTERMSIG(status) == SIGABRT);
+
+        std::ifstream in{path};
+        std::string dumped{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        INFO("Dump: " << dumped);
+        CHECK(dumped.contains("unlog flight recorder: SIGABRT"));
+        CHECK(dumped.contains("last words 99"));
+        CHECK(dumped.contains("end of flight recorder"));
+        fs::remove(path);
+    }
+
+    TEST_CASE("016 - flight recorder is dumped when a thread overflows its stack", "[016][recorder]") {
+        auto path = fs::temp_directory_path() / "unlog_016_overflow.log";
+        fs::remove(path);
+
+        auto pid = ::fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            std::signal(SIGSEGV, SIG_DFL);
+            set_flight_recorder(RecorderPolicy{.enabled = true, .level = LogLevel::trace, .dump_file = path});
+            // a fresh thread, so only the recorder can have given it an alternate stack
+            std::thread{[] {
+                unlog::trace("going down {}", 12);
+                overflow(0);
+            }}.join();
+            std::_Exit(0);
+        }
+
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        CHECK(WIFSIGNALED(status));
+        CHECK(WTERMSIG(status) == SIGSEGV);
+
+        std::ifstream in{path};
+        std::string dumped{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        INFO("Dump: " << dumped);
+        CHECK(dumped.contains("unlog flight recorder: SIGSEGV"));
+        CHECK(dumped.contains("going down 12"));
+        CHECK(dumped.contains("end of flight recorder"));
+        fs::remove(path);
+    }
+}  // namespace un::log::test
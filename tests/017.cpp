@@ -0,0 +1,90 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    namespace {
+        const sink_stats* find_sink(const stats_snapshot& snap, std::string_view name) {
+            for (auto& s : snap.sinks)
+                if (s.name == name)
+                    return &s;
+            return nullptr;
+        }
+    }  // namespace
+
+    TEST_CASE("017 - stats count messages per level", "[017][stats]") {
+        util::capture_test_logs(LogLevel::info);
+        auto before = stats();
+
+        for (int i = 0; i < 3; ++i)
+            unlog::warn("stats warn {}", i);
+        unlog::info("stats info {}", 1);
+        unlog::info("stats info {}", 2);
+        unlog::debug("stats debug is below the level");
+
+        auto after = stats();
+        CHECK(after.logged[LogLevel::warn] - before.logged[LogLevel::warn] == 3);
+        CHECK(after.logged[LogLevel::info] - before.logged[LogLevel::info] == 2);
+        CHECK(after.logged[LogLevel::debug] == before.logged[LogLevel::debug]);
+        CHECK(after.logged_total() - before.logged_total() == 5);
+    }
+
+    TEST_CASE("017 - stats meter bytes and flushes per sink", "[017][stats]") {
+        set_default_level(LogLevel::info);
+        std::ostringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        // threadsafe and without dedup, so the master sink holds this sink itself and it can be removed again
+        Config conf{"stats-sink", Type::cout, Flags::threadsafe, 0, 0, "%l %v"};
+        detail::add_sink(conf, sink);
+
+        for (int i = 0; i < 10; ++i)
+            unlog::info("metered {}", i);
+        unlog::flush();
+
+        auto snap = stats();
+        master_sink->remove_sink(sink);
+
+        auto* s = find_sink(snap, "stats-sink:cout");
+        REQUIRE(s != nullptr);
+        CHECK(s->messages == 10);
+        CHECK(s->bytes == out.str().size());
+        CHECK(s->flushes >= 1);
+        CHECK(s->max_flush <= s->flush_time);
+    }
+
+    TEST_CASE("017 - stats report the async backends", "[017][stats]") {
+        auto before = stats();
+
+        Logger pool{"stats-pool"};
+        pool.make_logger(Config::make_async("stats-pool-async"), true);
+        logger_ptr& pool_logger = pool;
+
+        Logger spsc{"stats-spsc"};
+        spsc.make_logger(Config::make_async("stats-spsc-async", 1, 64, Engine::spsc), true);
+        logger_ptr& spsc_logger = spsc;
+
+        util::capture_test_logs();
+        for (int i = 0; i < 200; ++i) {
+            unlog::info(pool_logger, "stats pool {}", i);
+            unlog::info(spsc_logger, "stats spsc {}", i);
+        }
+        spsc_logger->flush();
+        REQUIRE(util::WAIT_CONTAINS("stats pool 199"));
+        REQUIRE(util::WAIT_CONTAINS("stats spsc 199"));
+
+        // the backends count a message once its sinks return, which may be just after it shows up in the stream
+        auto after = stats();
+        for (int i = 0; i < 1000 and (after.pool.delivered - before.pool.delivered < 200); ++i) {
+            std::this_thread::sleep_for(1ms);
+            after = stats();
+        }
+        CHECK(after.pool.running);
+        CHECK(after.spsc.running);
+        CHECK(after.pool.delivered - before.pool.delivered >= 200);
+        CHECK(after.spsc.delivered - before.spsc.delivered >= 200);
+        CHECK(after.pool.busy > before.pool.busy);
+        CHECK(after.spsc.busy > before.spsc.busy);
+        CHECK(after.spsc.depth == 0);
+        CHECK(after.spsc.high_water >= 1);
+        CHECK(after.pool.overrun == 0);
+    }
+}  // namespace un::log::test
@@ -0,0 +1,185 @@
+#include "utils.hpp"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <unistd.h>
+
+namespace un::log::test {
+
+    namespace {
+        // Records payloads; holds up the backend that delivers "stall" until released, so the queue behind it fills
+        class stalling_sink final : public spdlog::sinks::base_sink<std::mutex> {
+          public:
+            std::atomic<bool> stalled{false};
+            std::atomic<bool> released{false};
+            std::vector<std::string> payloads;
+
+            std::mutex& payloads_mutex() { return mutex_; }
+
+          protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                std::string_view payload{msg.payload.data(), msg.payload.size()};
+                if (payload == "stall"sv) {
+                    stalled.store(true);
+                    while (not released.load())
+                        std::this_thread::sleep_for(1ms);
+                    return;
+                }
+                if (payload.starts_with("overflow "sv))
+                    payloads.emplace_back(payload);
+            }
+
+            void flush_() override {}
+        };
+
+        // Enough to overflow any ring the earlier test cases may have sized the engine with
+        constexpr int MESSAGES{20000};
+
+        struct stalled_backend {
+            std::shared_ptr<stalling_sink> sink{std::make_shared<stalling_sink>()};
+
+            explicit stalled_backend(logger_ptr& logger) {
+                set_default_level(LogLevel::info);
+                detail::add_sink(Config{"overflow-sink", Type::cout, Flags::threadsafe, 0, 0, "%v"}, sink);
+                unlog::info(logger, "stall");
+                while (not sink->stalled.load())
+                    std::this_thread::sleep_for(1ms);
+            }
+
+            // nothing may log synchronously while the backend holds the sink's lock
+            std::vector<std::string> release(logger_ptr& logger) {
+                sink->released.store(true);
+                logger->flush();
+                master_sink->remove_sink(sink);
+                std::lock_guard lock{sink->payloads_mutex()};
+                return sink->payloads;
+            }
+        };
+    }  // namespace
+
+    TEST_CASE("018 - spsc drop_newest discards what does not fit the ring", "[018][overflow]") {
+        auto conf = Config::make_async("overflow-drop-async", 1, 64, Engine::spsc);
+        conf.overflow = Overflow::drop_newest;
+        Logger drop{"overflow-drop"};
+        drop.make_logger(conf, true);
+        logger_ptr& logger = drop;
+
+        auto before = stats();
+        stalled_backend backend{logger};
+        for (int i = 0; i < MESSAGES; ++i)
+            unlog::info(logger, "overflow {}", i);
+        auto delivered = backend.release(logger);
+        auto after = stats();
+
+        auto discarded = after.spsc.discarded - before.spsc.discarded;
+        CHECK(discarded > 0);
+        CHECK(delivered.size() + discarded == MESSAGES);
+        REQUIRE_FALSE(delivered.empty());
+        // the oldest messages were queued, so what arrives is an unbroken run from the first
+        CHECK(delivered.front() == "overflow 0");
+        CHECK(delivered.back() == "overflow {}"_format(delivered.size() - 1));
+    }
+
+    TEST_CASE("018 - spsc spill writes overflow to disk and replays it in order", "[018][overflow]") {
+        // records refer to this process's loggers, so concurrent test runs must not share the file
+        auto path = fs::temp_directory_path() / "unlog_018_{}.spill"_format(::getpid());
+        auto conf = Config::make_async("overflow-spill-async", 1, 64, Engine::spsc);
+        conf.overflow = Overflow::spill;
+        conf.spill_file = path;
+        Logger spill{"overflow-spill"};
+        spill.make_logger(conf, true);
+        logger_ptr& logger = spill;
+
+        auto before = stats();
+        stalled_backend backend{logger};
+        for (int i = 0; i < MESSAGES; ++i)
+            unlog::info(logger, "overflow {}", i);
+        CHECK(fs::file_size(path) > 0);
+        auto delivered = backend.release(logger);
+        auto after = stats();
+
+        REQUIRE(delivered.size() == MESSAGES);
+        for (int i = 0; i < MESSAGES; ++i)
+            if (delivered[i] != "overflow {}"_format(i))
+                FAIL("message " << i << " is " << delivered[i]);
+        auto spilled = after.spsc.spilled - before.spsc.spilled;
+        CHECK(spilled > 0);
+        CHECK(after.spsc.replayed - before.spsc.replayed == spilled);
+        CHECK(after.spsc.discarded == before.spsc.discarded);
+        // the file is emptied once it has been replayed
+        CHECK(fs::file_size(path) == 0);
+    }
+
+    TEST_CASE("018 - a full spill file turns writers away until it has been replayed", "[018][overflow]") {
+        auto path = fs::temp_directory_path() / "unlog_018_limit_{}.spill"_format(::getpid());
+        auto sink = std::make_shared<stalling_sink>();
+        auto logger = std::make_shared<detail::spsc_logger>("spill-limit", sink, detail::spsc_pool(), Overflow::spill);
+        detail::spill_file file;
+        file.open(path, 4096);
+
+        auto spill = [&](int i) {
+            auto text = "overflow {}"_format(i);
+            spdlog::details::log_msg msg{"spill-limit", LogLevel::info, text};
+            return file.write(*logger, msg, detail::record_kind::text);
+        };
+
+        int written = 0;
+        for (auto result = spill(written); result != detail::spill_file::result::full; result = spill(written)) {
+            REQUIRE(result == detail::spill_file::result::written);
+            ++written;
+        }
+        CHECK(written > 0);
+        CHECK(fs::file_size(path) <= 4096);
+        CHECK(file.has_pending());
+
+        CHECK(file.replay(written) == static_cast<size_t>(written));
+        // caught up: the file starts over and takes messages again
+        CHECK(file.replay(1) == 0);
+        CHECK_FALSE(file.has_pending());
+        CHECK(fs::file_size(path) == 0);
+        CHECK(spill(written) == detail::spill_file::result::written);
+
+        std::lock_guard lock{sink->payloads_mutex()};
+        REQUIRE(sink->payloads.size() == static_cast<size_t>(written));
+        CHECK(sink->payloads.front() == "overflow 0");
+        CHECK(sink->payloads.back() == "overflow {}"_format(written - 1));
+    }
+
+    TEST_CASE("018 - pool accepts overwrite_oldest", "[018][overflow]") {
+        auto conf = Config::make_async("overflow-pool-async");
+        conf.overflow = Overflow::overwrite_oldest;
+        Logger pool{"overflow-pool"};
+        pool.make_logger(conf, true);
+        logger_ptr& logger = pool;
+
+        util::capture_test_logs(LogLevel::info);
+        unlog::info(logger, "overwrite oldest {}", 1);
+        CHECK(util::WAIT_CONTAINS("overwrite oldest 1"));
+    }
+
+    TEST_CASE("018 - unsupported overflow policies are rejected", "[018][overflow]") {
+        auto sync = Config::make_default("overflow-sync-logger");
+        sync.overflow = Overflow::drop_newest;
+        CHECK_THROWS_AS(Logger{"overflow-sync"}.make_logger(sync, true), std::invalid_argument);
+
+        auto spsc = Config::make_async("overflow-spsc-overwrite-async", 1, 64, Engine::spsc);
+        spsc.overflow = Overflow::overwrite_oldest;
+        CHECK_THROWS_AS(Logger{"overflow-spsc-overwrite"}.make_logger(spsc, true), std::invalid_argument);
+
+        auto pool = Config::make_async("overflow-pool-spill-async");
+        pool.overflow = Overflow::spill;
+        CHECK_THROWS_AS(Logger{"overflow-pool-spill"}.make_logger(pool, true), std::invalid_argument);
+    }
+
+    TEST_CASE("018 - a rejected config leaves its name free", "[018][overflow]") {
+        auto conf = Config::make_async("overflow-retry-async", 1, 64, Engine::spsc);
+        conf.overflow = Overflow::overwrite_oldest;
+        Logger retry{"overflow-retry"};
+        CHECK_THROWS_AS(retry.make_logger(conf, true), std::invalid_argument);
+
+        conf.overflow = Overflow::drop_newest;
+        REQUIRE_NOTHROW(retry.make_logger(conf, true));
+        // and now it is taken
+        CHECK_THROWS_AS(retry.make_logger(conf, true), std::invalid_argument);
+    }
+}  // namespace un::log::test
@@ -0,0 +1,240 @@
+#include "utils.hpp"
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Counts the allocations made on a thread while it is counting
+    thread_local bool counting{false};
+    thread_local size_t allocations{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (counting)
+        ++allocations;
+    if (auto* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc{};
+}
+
+// kept out of line, or the compiler pairs the inlined free() with operator new at each call site and warns
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace un::log::test {
+
+    namespace {
+        struct layout_capture {
+            std::ostringstream out;
+            std::shared_ptr<spdlog::sinks::ostream_sink_mt> sink{std::make_shared<spdlog::sinks::ostream_sink_mt>(out)};
+
+            explicit layout_capture(Layout layout) {
+                // threadsafe and without dedup, so the master sink holds this sink itself and it can be removed again
+                Config conf{"kv-{}"_format(layout_string(layout)), Type::cout, Flags::threadsafe, 0, 0, "%l %v"};
+                conf.layout = layout;
+                detail::add_sink(conf, sink);
+            }
+
+            ~layout_capture() { master_sink->remove_sink(sink); }
+
+            std::string str() {
+                unlog::flush();
+                return out.str();
+            }
+
+            // The pool backend's flush only queues behind the message; poll until it arrives
+            std::string wait_for(std::string_view text, std::chrono::milliseconds timeout = 1s) {
+                auto deadline = std::chrono::steady_clock::now() + timeout;
+                auto seen = str();
+                while (not seen.contains(text) and std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(1ms);
+                    seen = str();
+                }
+                return seen;
+            }
+        };
+
+        // Formats into a fixed buffer, so delivering a message allocates nothing
+        class fixed_sink final : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+          public:
+            std::array<char, 1024> last{};
+            size_t size{0};
+
+            std::string_view text() const { return {last.data(), size}; }
+
+          protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                spdlog::memory_buf_t buf;
+                formatter_->format(msg, buf);
+                size = std::min(buf.size(), last.size());
+                std::memcpy(last.data(), buf.data(), size);
+            }
+
+            void flush_() override {}
+        };
+    }  // namespace
+
+    TEST_CASE("019 - fields follow the text in pattern sinks", "[019][fields]") {
+        util::capture_test_logs(LogLevel::info);
+        unlog::info("req {} done", 7, kv("status", 200), kv("path", "/a b"), kv("ok", true), kv("ratio", 0.5));
+        util::CHECK_CONTAINS(R"(req 7 done status=200 path="/a b" ok=true ratio=0.5)");
+    }
+
+    TEST_CASE("019 - json layout writes typed fields", "[019][fields]") {
+        set_default_level(LogLevel::info);
+        layout_capture cap{Layout::json};
+        std::string quoted{"say \"hi\"\n"};
+        unlog::warn("req done", kv("status", 200), kv("dur_us", uint64_t{15}), kv("msg2", quoted), kv("ok", false));
+        unlog::info("plain {}", "text");
+
+        auto out = cap.str();
+        INFO("Output: " << out);
+        CHECK(out.starts_with(R"({"time":")"));
+        CHECK(out.contains(R"(Z","level":"warning","logger":"unlog","source":"019.cpp:)"));
+        CHECK(out.contains(R"(,"msg":"req done","status":200,"dur_us":15,"msg2":"say \"hi\"\n","ok":false}
+)"));
+        CHECK(out.contains(R"(,"msg":"plain text"}
+)"));
+    }
+
+    TEST_CASE("019 - logfmt layout writes typed fields", "[019][fields]") {
+        set_default_level(LogLevel::info);
+        layout_capture cap{Layout::logfmt};
+        unlog::info("req done", kv("status", -1), kv("user", "ann"), kv("note", ""), kv("values", std::vector{1, 2}));
+
+        auto out = cap.str();
+        INFO("Output: " << out);
+        CHECK(out.starts_with("time="));
+        CHECK(out.contains(" level=info logger=unlog source=019.cpp:"));
+        CHECK(out.contains(R"( msg="req done" status=-1 user=ann note="" values="[1, 2]")"
+                           "\n"));
+    }
+
+    TEST_CASE("019 - structured layouts escape file names and keys", "[019][fields]") {
+        spdlog::details::log_msg msg{{"dir/say \"hi\" now.cpp", 12, "fn"}, "unlog", LogLevel::info, "text"};
+        spdlog::memory_buf_t json;
+        json_formatter{}.format(msg, json);
+        CHECK(fmt::to_string(json).contains(R"(,"source":"dir/say \"hi\" now.cpp:12",)"));
+
+        spdlog::memory_buf_t logfmt;
+        logfmt_formatter{}.format(msg, logfmt);
+        CHECK(fmt::to_string(logfmt).contains(R"( source="dir/say \"hi\" now.cpp:12" )"));
+
+        set_default_level(LogLevel::info);
+        layout_capture cap{Layout::logfmt};
+        unlog::info("keys", kv("a key=\"x\"", 1), kv("", 2), kv("caf\xc3\xa9\n", 3));
+        auto out = cap.str();
+        INFO("Output: " << out);
+        CHECK(out.contains(" msg=keys a_key=_x_=1 _=2 caf\xc3\xa9_=3\n"));
+    }
+
+    TEST_CASE("019 - fields cross the async backends", "[019][fields]") {
+        Logger spsc{"kv-spsc"};
+        spsc.make_logger(Config::make_async("kv-spsc-async", 1, 64, Engine::spsc), true);
+        logger_ptr& spsc_logger = spsc;
+
+        Logger deferred{"kv-deferred"};
+        deferred.make_logger(Config::make_deferred("kv-deferred-async"), true);
+        logger_ptr& deferred_logger = deferred;
+
+        set_default_level(LogLevel::info);
+        layout_capture cap{Layout::json};
+        {
+            std::string temporary{"gone after the call"};
+            unlog::info(spsc_logger, "spsc", kv("name", temporary), kv("n", 1));
+            unlog::info(deferred_logger, "deferred", kv("name", temporary), kv("n", 2));
+        }
+        spsc_logger->flush();
+        deferred_logger->flush();
+
+        cap.wait_for(R"("msg":"spsc")");
+        auto out = cap.wait_for(R"("msg":"deferred")");
+        INFO("Output: " << out);
+        CHECK(out.contains(R"("msg":"spsc","name":"gone after the call","n":1})"));
+        CHECK(out.contains(R"("msg":"deferred","name":"gone after the call","n":2})"));
+    }
+
+    TEST_CASE("019 - logging fields allocates nothing", "[019][fields]") {
+        set_default_level(LogLevel::info);
+        auto saved = *master_sink->sinks();
+
+        for (auto layout : {Layout::pattern, Layout::json, Layout::logfmt}) {
+            auto sink = std::make_shared<fixed_sink>();
+            Config conf{"kv-alloc", Type::cout, Flags::threadsafe, 0, 0, "%l %v"};
+            conf.layout = layout;
+            detail::set_sinks(conf, sink);
+
+            std::string_view path{"/api/items"};
+            size_t counted = 0;
+            for (int i = 0; i < 100; ++i) {
+                // the first call registers the call site
+                counting = i > 0;
+                allocations = 0;
+                unlog::info("req done", kv("status", 200), kv("dur_us", i), kv("path", path), kv("hit", true));
+                counting = false;
+                counted += allocations;
+            }
+
+            INFO("Layout: " << layout_string(layout) << ", last: " << sink->text());
+            CHECK(counted == 0);
+            CHECK(sink->text().contains("200"));
+            CHECK(sink->text().contains("/api/items"));
+        }
+
+        master_sink->set_sinks(saved);
+    }
+
+    TEST_CASE("019 - text that looks like a fields record stays text", "[019][fields]") {
+        // what a record looked like when records were recognized by their bytes: a magic, then sizes far past the end
+        std::string forged{"unlogkvs"};
+        uint32_t sizes[]{0, 0x00ff'ffff};
+        forged.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+        forged += "\xff-forged";
+
+        layout_capture cap{Layout::json};
+        util::capture_test_logs(LogLevel::info);
+        unlog::info("{}", forged);
+        util::CHECK_CONTAINS(forged);
+        CHECK(cap.str().contains(R"(-forged")"));
+    }
+
+    TEST_CASE("019 - fields records are checked against their bounds", "[019][fields]") {
+        spdlog::memory_buf_t buf;
+        detail::fields_header header{4, 2};
+        buf.append(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+        buf.append("text"sv);
+        uint32_t one{1};
+        for (auto field : {"\x01k" "l"sv, "\x01s" "s"sv}) {
+            buf.append(field);
+            buf.append(reinterpret_cast<const char*>(&one), reinterpret_cast<const char*>(&one) + sizeof(one));
+        }
+        std::string_view record{buf.data(), buf.size()};
+
+        detail::fields_view fields;
+        // the first field's int64 swallows most of the second, whose remains do not parse
+        CHECK_FALSE(detail::read_fields({record.data(), record.size()}, fields));
+        // a key, a string size or a value past the end
+        for (size_t size = sizeof(header) + 4; size < record.size(); ++size)
+            CHECK_FALSE(detail::read_fields({record.data(), size}, fields));
+
+        // a well-formed record with an unknown type code
+        detail::fields_header one_field{0, 1};
+        std::string unknown{reinterpret_cast<const char*>(&one_field), sizeof(one_field)};
+        unknown += "\x01kz";
+        CHECK_FALSE(detail::read_fields({unknown.data(), unknown.size()}, fields));
+        unknown.back() = 'b';
+        unknown += '\x01';
+        REQUIRE(detail::read_fields({unknown.data(), unknown.size()}, fields));
+        size_t seen = 0;
+        CHECK(fields.each([&seen](const detail::field_view& f) { seen += f.key == "k" and f.b; }));
+        CHECK(seen == 1);
+    }
+}  // namespace un::log::test
@@ -0,0 +1,143 @@
+#include "utils.hpp"
+
+#include "unlog/escape.hpp"
+
+#include <random>
+
+namespace un::log::test {
+
+    namespace {
+        std::string json(std::string_view s) {
+            spdlog::memory_buf_t out;
+            detail::escape_json(s, out);
+            return fmt::to_string(out);
+        }
+
+        std::string text(std::string_view s) {
+            spdlog::memory_buf_t out;
+            detail::escape_text(s, out);
+            return fmt::to_string(out);
+        }
+    }  // namespace
+
+    TEST_CASE("020 - json escaping", "[020][escape]") {
+        INFO("Kernel: " << detail::escape_kernel());
+        CHECK(json("") == "");
+        CHECK(json("plain text") == "plain text");
+        CHECK(json(R"(say "hi" \ bye)") == R"(say \"hi\" \\ bye)");
+        CHECK(json("a\nb\tc\rd") == R"(a\nb\tc\rd)");
+        CHECK(json("\x1b[31mred\x1b[0m") == R"(\u001b[31mred\u001b[0m)");
+        CHECK(json(std::string_view{"nul\0byte", 8}) == R"(nul\u0000byte)");
+        CHECK(json("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80") == "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80");
+        // truncated, overlong, surrogate and stray continuation bytes
+        CHECK(json("bad \xc3") == R"(bad \ufffd)");
+        CHECK(json("\xc0\xaf") == R"(\ufffd\ufffd)");
+        CHECK(json("\xed\xa0\x80") == R"(\ufffd\ufffd\ufffd)");
+        CHECK(json("\x80x") == R"(\ufffdx)");
+    }
+
+    TEST_CASE("020 - text sanitizing", "[020][escape]") {
+        CHECK(text("plain\ttext") == "plain\ttext");
+        CHECK(text("\x1b[2J\x1b[31mowned") == R"(\x1b[2J\x1b[31mowned)");
+        CHECK(text("forged\n[12:00:00] line") == R"(forged\x0a[12:00:00] line)");
+        CHECK(text("quotes \" and \\ stay") == "quotes \" and \\ stay");
+        CHECK(text("caf\xc3\xa9 \xff") == "caf\xc3\xa9 \\xff");
+        CHECK(text("del\x7f") == R"(del\x7f)");
+    }
+
+    TEST_CASE("020 - vector scan matches the scalar scan", "[020][escape]") {
+        std::mt19937 rng{20};
+        std::uniform_int_distribution<int> length{0, 200};
+        std::uniform_int_distribution<int> plain{'a', 'z'};
+        std::uniform_int_distribution<int> any{0, 255};
+        std::uniform_int_distribution<int> odds{0, 63};
+
+        for (int round = 0; round < 2000; ++round) {
+            // mostly clean text, so the special byte lands at every offset within and across vector blocks
+            std::string s(static_cast<size_t>(length(rng)), 'x');
+            for (auto& c : s)
+                c = static_cast<char>(odds(rng) == 0 ? any(rng) : plain(rng));
+
+            for (bool mode : {false, true}) {
+                INFO("Round " << round << ", json " << mode << ", size " << s.size());
+                REQUIRE(detail::scan_special(s, mode) == detail::scan_special_scalar(s, mode));
+                for (size_t offset = 1; offset < std::min<size_t>(s.size(), 33); offset += 7) {
+                    std::string_view tail{s.data() + offset, s.size() - offset};
+                    REQUIRE(detail::scan_special(tail, mode) == detail::scan_special_scalar(tail, mode));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("020 - vector utf-8 check agrees with the scalar check", "[020][escape]") {
+        INFO("Kernel: " << detail::escape_kernel());
+        std::mt19937 rng{2020};
+        std::uniform_int_distribution<int> length{0, 120};
+        std::uniform_int_distribution<int> odds{0, 99};
+        std::uniform_int_distribution<size_t> pick{0, 7};
+        std::uniform_int_distribution<int> any{0, 255};
+        constexpr std::string_view valid[]{
+                "a", "z", "\xc3\xa9", "\xdf\xbf", "\xe2\x82\xac", "\xef\xbf\xbf", "\xf0\x9f\x98\x80",
+                "\xf4\x8f\xbf\xbf"};
+        constexpr std::string_view broken[]{
+                "\"", "\n", "\x7f", "\xc3", "\x80", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80"};
+
+        for (int round = 0; round < 4000; ++round) {
+            // mostly multibyte text, sometimes with a byte to escape or broken UTF-8 at any offset
+            std::string s;
+            auto clean = round % 2 == 0;
+            for (int n = length(rng); n > 0; --n) {
+                auto r = odds(rng);
+                if (clean or r < 97)
+                    s += valid[pick(rng)];
+                else if (r < 99)
+                    s += broken[pick(rng)];
+                else
+                    s += static_cast<char>(any(rng));
+            }
+
+            for (bool mode : {false, true}) {
+                INFO("Round " << round << ", json " << mode << ", size " << s.size());
+                auto scalar = detail::scan_utf8_scalar(s, mode);
+                auto vector = detail::scan_utf8(s, mode);
+                if (clean)
+                    REQUIRE(vector == s.size());
+                REQUIRE(vector <= scalar);
+                REQUIRE(detail::scan_utf8_scalar(s.substr(0, vector), mode) == vector);
+            }
+        }
+    }
+
+    TEST_CASE("020 - long non-ascii text is escaped like short text", "[020][escape]") {
+        std::string word{"na\xc3\xafve \xe2\x82\xac\xf0\x9f\x98\x80 "};
+        std::string run;
+        for (int i = 0; i < 20; ++i)
+            run += word;
+
+        CHECK(json(run) == run);
+        CHECK(text(run) == run);
+        CHECK(json(run + "\"" + run) == run + "\\\"" + run);
+        CHECK(text(run + "\n" + run) == run + "\\x0a" + run);
+        // cut inside the last sequence, and a surrogate well past the first vector block
+        CHECK(json(run + "\xf0\x9f\x98") == run + "\\ufffd\\ufffd\\ufffd");
+        CHECK(json(run + "\xed\xa0\x80" + run) == run + "\\ufffd\\ufffd\\ufffd" + run);
+    }
+
+    TEST_CASE("020 - sanitize neutralizes escape sequences in a pattern sink", "[020][escape]") {
+        set_default_level(LogLevel::info);
+        std::ostringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        Config conf{"escape-sink", Type::cout, Flags::threadsafe, 0, 0, "%l %v"};
+        conf.sanitize = true;
+        detail::add_sink(conf, sink);
+
+        std::string user{"\x1b]0;pwned\x07name\nfake line"};
+        unlog::info("user {} logged in", user);
+        unlog::info("clean message");
+        unlog::flush();
+        master_sink->remove_sink(sink);
+
+        INFO("Output: " << out.str());
+        CHECK(out.str() == "info user \\x1b]0;pwned\\x07name\\x0afake line logged in\ninfo clean message\n");
+    }
+}  // namespace un::log::test
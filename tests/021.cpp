@@ -0,0 +1,107 @@
+#include "utils.hpp"
+
+#include <random>
+
+namespace un::log::test {
+
+    namespace {
+        std::string reference_hex(uspan bytes, const char* digits) {
+            std::string out;
+            for (auto b : bytes) {
+                out.push_back(digits[b >> 4]);
+                out.push_back(digits[b & 0xf]);
+            }
+            return out;
+        }
+
+        std::string reference_base64(uspan bytes) {
+            constexpr std::string_view alphabet{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+            std::string out;
+            for (size_t i = 0; i < bytes.size(); i += 3) {
+                uint32_t group = bytes[i] << 16;
+                if (i + 1 < bytes.size())
+                    group |= bytes[i + 1] << 8;
+                if (i + 2 < bytes.size())
+                    group |= bytes[i + 2];
+                for (size_t j = 0; j < 4; ++j)
+                    out.push_back(i + j <= bytes.size() ? alphabet[(group >> (18 - 6 * j)) & 0x3f] : '=');
+            }
+            return out;
+        }
+    }  // namespace
+
+    TEST_CASE("021 - byte spans render as hex", "[021][bytes]") {
+        const unsigned char bytes[]{0x00, 0x0a, 0x1b, 0x7f, 0x80, 0xff};
+        uspan u{bytes};
+        bspan b{reinterpret_cast<const std::byte*>(bytes), sizeof(bytes)};
+
+        CHECK(fmt::format("{}", u) == "000a1b7f80ff");
+        CHECK(fmt::format("{:x}", b) == "000a1b7f80ff");
+        CHECK(fmt::format("{:X}", u) == "000A1B7F80FF");
+        CHECK(fmt::format("{:x.2}", u) == "000a...(+4 bytes)");
+        CHECK(fmt::format("{:x.6}", u) == "000a1b7f80ff");
+        CHECK(fmt::format("{:X}", uspan{}) == "");
+        CHECK(fmt::format("{}", bspan{"AB"_bsp}) == "4142");
+    }
+
+    TEST_CASE("021 - byte spans render as base64", "[021][bytes]") {
+        auto b64 = [](std::string_view s) {
+            return fmt::format("{:b64}", uspan{reinterpret_cast<const unsigned char*>(s.data()), s.size()});
+        };
+        CHECK(b64("") == "");
+        CHECK(b64("f") == "Zg==");
+        CHECK(b64("fo") == "Zm8=");
+        CHECK(b64("foo") == "Zm9v");
+        CHECK(b64("foob") == "Zm9vYg==");
+        CHECK(b64("fooba") == "Zm9vYmE=");
+        CHECK(b64("foobar") == "Zm9vYmFy");
+        CHECK(b64("\xfb\xff") == "+/8=");
+    }
+
+    TEST_CASE("021 - byte spans render as a hex dump", "[021][bytes]") {
+        std::string text{"Hello, world!\n\x01\x02\x03 tail"};
+        uspan u{reinterpret_cast<const unsigned char*>(text.data()), text.size()};
+
+        CHECK(fmt::format("{:dump}", u) ==
+              "\n00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 01 02  |Hello, world!...|"
+              "\n00000010  03 20 74 61 69 6c                                 |. tail|");
+        CHECK(fmt::format("{:dump.4}", u) ==
+              "\n00000000  48 65 6c 6c                                       |Hell|\n...(+18 bytes)");
+    }
+
+    TEST_CASE("021 - encoding matches the reference across chunks", "[021][bytes]") {
+        std::mt19937 rng{21};
+        std::uniform_int_distribution<int> byte{0, 255};
+        std::vector<unsigned char> data(1000);
+        for (auto& b : data)
+            b = static_cast<unsigned char>(byte(rng));
+
+        for (size_t size : {1uz, 15uz, 16uz, 17uz, 191uz, 192uz, 193uz, 577uz, 1000uz}) {
+            uspan u{data.data(), size};
+            INFO("Size: " << size);
+            CHECK(fmt::format("{}", u) == reference_hex(u, "0123456789abcdef"));
+            CHECK(fmt::format("{:X}", u) == reference_hex(u, "0123456789ABCDEF"));
+            CHECK(fmt::format("{:b64}", u) == reference_base64(u));
+
+            auto dump = fmt::format("{:dump}", u);
+            CHECK(std::ranges::count(dump, '\n') == static_cast<long>((size + 15) / 16));
+            auto last_line = (size - 1) / 16 * 16;
+            CHECK(dump.contains("\n{:08x}  {:02x} "_format(last_line, data[last_line])));
+        }
+    }
+
+    TEST_CASE("021 - invalid byte span formats are rejected", "[021][bytes]") {
+        const unsigned char bytes[]{1, 2};
+        uspan u{bytes};
+        CHECK_THROWS_AS(fmt::format(fmt::runtime("{:q}"), u), fmt::format_error);
+        CHECK_THROWS_AS(fmt::format(fmt::runtime("{:x.}"), u), fmt::format_error);
+        CHECK_THROWS_AS(fmt::format(fmt::runtime("{:b64x}"), u), fmt::format_error);
+    }
+
+    TEST_CASE("021 - byte spans are encoded when logged", "[021][bytes]") {
+        util::capture_test_logs(LogLevel::info);
+        const unsigned char packet[]{0xde, 0xad, 0xbe, 0xef};
+        unlog::info("packet {:X} / {:b64}", uspan{packet}, uspan{packet});
+        util::CHECK_CONTAINS("packet DEADBEEF / 3q2+7w==");
+    }
+}  // namespace un::log::test
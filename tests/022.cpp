@@ -0,0 +1,77 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    namespace {
+        // Formats only through format_to, so the formatter never builds a string for it
+        struct endpoint {
+            std::string_view host;
+            uint16_t port;
+
+            fmt::appender format_to(fmt::appender out) const { return "{}:{}"_format_to(out, host, port); }
+
+            static constexpr auto to_string_formattable = true;
+        };
+
+        struct legacy_endpoint {
+            std::string_view host;
+            uint16_t port;
+
+            std::string to_string() const { return "{}:{}"_format(host, port); }
+
+            static constexpr auto to_string_formattable = true;
+        };
+    }  // namespace
+
+    TEST_CASE("022 - _format_to appends to buffers and iterators", "[022][format]") {
+        fmt::memory_buffer buf;
+        "{}-{}"_format_to(buf, 1, "a");
+        "|{:>4}"_format_to(buf, 7);
+        CHECK(fmt::to_string(buf) == "1-a|   7");
+
+        spdlog::memory_buf_t log_buf;
+        "{} {}"_format_to(log_buf, "spdlog", 2);
+        CHECK(fmt::to_string(log_buf) == "spdlog 2");
+
+        std::string s{"> "};
+        auto end = "{:02x}"_format_to(std::back_inserter(s), 255);
+        *end = '!';
+        CHECK(s == "> ff!");
+
+        std::array<char, 8> fixed{};
+        auto* last = "{}"_format_to(fixed.data(), 1234);
+        CHECK(std::string_view{fixed.data(), last} == "1234");
+    }
+
+    TEST_CASE("022 - _format_view reuses the thread's buffer", "[022][format]") {
+        auto first = "{} {}"_format_view("a fairly long first message to grow the buffer", 1);
+        CHECK(first == "a fairly long first message to grow the buffer 1");
+        CHECK(first.data()[first.size()] == '\0');
+        auto* data = first.data();
+
+        auto second = "short {}"_format_view(2);
+        CHECK(second == "short 2");
+        CHECK(second.data() == data);
+        CHECK(std::strlen(second.data()) == second.size());
+
+        std::string other_thread;
+        std::thread{[&other_thread] { other_thread = "{}"_format_view("elsewhere"); }}.join();
+        CHECK(other_thread == "elsewhere");
+        CHECK("short {}"_format_view(2).data() == data);
+    }
+
+    TEST_CASE("022 - to_string_formattable types may format in place", "[022][format]") {
+        endpoint ep{"localhost", 8080};
+        CHECK(fmt::format("{}", ep) == "localhost:8080");
+        CHECK(fmt::format("[{:>16}]", ep) == "[  localhost:8080]");
+        CHECK(fmt::format("[{:<15}]", legacy_endpoint{"host", 1}) == "[host:1         ]");
+
+        auto conf = Config::make_default("format-conf");
+        CHECK(fmt::format("{}", conf) == conf.to_string());
+        CHECK(conf.to_string() == "Config[ name=format-conf | type=cout ]");
+
+        util::capture_test_logs(LogLevel::info);
+        unlog::info("connecting to {} and {}", ep, legacy_endpoint{"backup", 9});
+        util::CHECK_CONTAINS("connecting to localhost:8080 and backup:9");
+    }
+}  // namespace un::log::test
@@ -0,0 +1,80 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    static_assert(detail::pattern_segments<"[%H:%M] %v">.size() == 6);
+    static_assert(detail::pattern_segments<"100%% %v">.size() == 4);
+    static_assert(detail::pattern_segments<"">.empty());
+    static_assert(DEFAULT_COMPILED_PATTERN.text == detail::default_pattern.sv());
+
+    namespace {
+        struct rendered {
+            std::string text;
+            size_t color_start;
+            size_t color_end;
+        };
+
+        rendered render(spdlog::formatter& formatter, const spdlog::details::log_msg& msg) {
+            spdlog::memory_buf_t buf;
+            formatter.format(msg, buf);
+            return {fmt::to_string(buf), msg.color_range_start, msg.color_range_end};
+        }
+
+        rendered render_runtime(std::string_view pattern, const spdlog::details::log_msg& msg) {
+            spdlog::pattern_formatter formatter;
+            formatter.add_flag<startup_elapsed_flag>('*');
+            formatter.set_pattern(std::string{pattern});
+            return render(formatter, msg);
+        }
+
+        void check_matches_runtime(const compiled_pattern& compiled) {
+            INFO("Pattern: " << compiled.text);
+            auto formatter = compiled.make();
+            auto start = startup_time();
+            // within one second, across a second and minute boundary, and without a source location
+            for (auto offset : {0ms, 7ms, 999ms, 1001ms, 61'250ms, 3'723'004ms}) {
+                for (bool with_source : {true, false}) {
+                    spdlog::source_loc loc{};
+                    if (with_source)
+                        loc = {"/src/net/socket.cpp", 42, "connect"};
+                    spdlog::details::log_msg msg{start + offset, loc, "compiled", LogLevel::warn, "payload 100%"};
+                    msg.thread_id = 4242;
+
+                    auto expected = render_runtime(compiled.text, msg);
+                    auto actual = render(*formatter, msg);
+                    INFO("Expected: " << expected.text << "Actual: " << actual.text);
+                    CHECK(actual.text == expected.text);
+                    CHECK(actual.color_start == expected.color_start);
+                    CHECK(actual.color_end == expected.color_end);
+                }
+            }
+        }
+    }  // namespace
+
+    TEST_CASE("023 - compiled default patterns match the runtime formatter", "[023][pattern]") {
+        check_matches_runtime(DEFAULT_COMPILED_PATTERN);
+        check_matches_runtime(DEFAULT_COMPILED_PATTERN_COLOR);
+    }
+
+    TEST_CASE("023 - compiled patterns cover the supported flags", "[023][pattern]") {
+        check_matches_runtime("%Y-%m-%d %H:%M:%S.%e|%f|%F"_pattern);
+        check_matches_runtime("%L %l [%n] %v (%s:%# in %! from %g)"_pattern);
+        check_matches_runtime("<%t:%P> %^%l%$ %*: 100%% %v"_pattern);
+        check_matches_runtime("%v"_pattern);
+    }
+
+    TEST_CASE("023 - a compiled pattern from the config formats the sink", "[023][pattern]") {
+        set_default_level(LogLevel::info);
+        std::ostringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        Config conf{"compiled-sink", Type::cout, Flags::threadsafe, 0, 0};
+        conf.compiled = "%l|%s|%v"_pattern;
+        detail::add_sink(conf, sink);
+
+        unlog::warn("compiled {}", 23);
+        unlog::flush();
+        master_sink->remove_sink(sink);
+
+        CHECK(out.str() == "warning|023.cpp|compiled 23\n");
+    }
+}  // namespace un::log::test
@@ -0,0 +1,75 @@
+#include "utils.hpp"
+
+namespace un::log::test {
+
+    // "[%H:%M:%S." is rendered once per second, then %e and the rest per message
+    static_assert(detail::pattern_plan<detail::default_pattern>[0].cached);
+    static_assert(detail::pattern_plan<detail::default_pattern>[0].size == 7);
+    static_assert(detail::pattern_plan<detail::default_pattern>[1].flag == 'e');
+    static_assert(not detail::pattern_plan<"%v">[0].cached);
+
+    namespace {
+        std::string render(spdlog::formatter& formatter, const spdlog::details::log_msg& msg) {
+            spdlog::memory_buf_t buf;
+            formatter.format(msg, buf);
+            return fmt::to_string(buf);
+        }
+
+        void check_matches_runtime(const compiled_pattern& compiled, bool utc) {
+            INFO("Pattern: " << compiled.text << ", utc: " << utc);
+            auto formatter = compiled.make(utc);
+            spdlog::pattern_formatter runtime{utc ? spdlog::pattern_time_type::utc : spdlog::pattern_time_type::local};
+            runtime.add_flag<startup_elapsed_flag>('*');
+            runtime.set_pattern(std::string{compiled.text});
+
+            // several messages within a second, then forwards and backwards across seconds, days and years
+            auto base = spdlog::log_clock::time_point{std::chrono::seconds{1'735'689'599}};
+            for (auto offset : std::initializer_list<std::chrono::nanoseconds>{
+                         0ns, 1ns, 999'999ns, 123'456'789ns, 999'999'999ns, 1s, 1s + 5ms, -3s, 86'400s + 7us, 0ns}) {
+                spdlog::details::log_msg msg{base + offset, {}, "cached", LogLevel::info, "tick"};
+                INFO("Offset: " << offset.count());
+                CHECK(render(*formatter, msg) == render(runtime, msg));
+            }
+        }
+    }  // namespace
+
+    TEST_CASE("024 - cached time runs match the runtime formatter", "[024][pattern]") {
+        for (bool utc : {false, true}) {
+            check_matches_runtime(DEFAULT_COMPILED_PATTERN, utc);
+            check_matches_runtime(DEFAULT_COMPILED_PATTERN_COLOR, utc);
+            check_matches_runtime("%Y-%m-%dT%H:%M:%S.%f %v"_pattern, utc);
+            check_matches_runtime("%H%M%S%F|%d/%m/%Y %l %H"_pattern, utc);
+        }
+    }
+
+    TEST_CASE("024 - utc sinks render UTC times", "[024][pattern]") {
+        set_default_level(LogLevel::info);
+        std::ostringstream compiled_out, runtime_out;
+        auto compiled_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(compiled_out);
+        auto runtime_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(runtime_out);
+
+        Config compiled_conf{"utc-compiled", Type::cout, Flags::threadsafe, 0, 0};
+        compiled_conf.compiled = "%Y-%m-%d %H:%M|%v"_pattern;
+        compiled_conf.utc = true;
+        Config runtime_conf{"utc-runtime", Type::cout, Flags::threadsafe, 0, 0, "%Y-%m-%d %H:%M|%v"};
+        runtime_conf.utc = true;
+        detail::add_sink(compiled_conf, compiled_sink);
+        detail::add_sink(runtime_conf, runtime_sink);
+
+        auto utc_minute = [] {
+            auto tm = spdlog::details::os::gmtime(spdlog::log_clock::to_time_t(spdlog::log_clock::now()));
+            return "{:04}-{:02}-{:02} {:02}:{:02}|utc\n"_format(
+                    tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min);
+        };
+        auto before = utc_minute();
+        unlog::info("utc");
+        unlog::flush();
+        auto after = utc_minute();
+        master_sink->remove_sink(compiled_sink);
+        master_sink->remove_sink(runtime_sink);
+
+        INFO("Compiled: " << compiled_out.str() << "Runtime: " << runtime_out.str());
+        CHECK((compiled_out.str() == before or compiled_out.str() == after));
+        CHECK((runtime_out.str() == before or runtime_out.str() == after));
+    }
+}  // namespace un::log::test
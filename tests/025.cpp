@@ -0,0 +1,174 @@
+#include "utils.hpp"
+
+#include "unlog/shm.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace un::log::test {
+
+    namespace {
+        std::string test_channel(std::string_view test) { return "test025-{}-{}"_format(test, ::getpid()); }
+
+        // Collects what the collector delivers to the master sink
+        struct delivered {
+            std::ostringstream out;
+            std::shared_ptr<spdlog::sinks::ostream_sink_mt> sink{std::make_shared<spdlog::sinks::ostream_sink_mt>(out)};
+
+            explicit delivered(std::string pattern) {
+                set_default_level(LogLevel::trace);
+                detail::add_sink(Config{"shm-collected", Type::cout, Flags::threadsafe, 0, 0, std::move(pattern)}, sink);
+            }
+
+            ~delivered() { master_sink->remove_sink(sink); }
+
+            std::string text() {
+                sink->flush();
+                return out.str();
+            }
+        };
+
+        spdlog::details::log_msg message(spdlog::log_clock::time_point time, std::string_view text) {
+            return {time, {"/src/app/worker.cpp", 17, "work"}, "shm-app", LogLevel::info, text};
+        }
+
+        bool segment_exists(std::string_view channel, pid_t pid) {
+            return fs::exists("/dev/shm{}"_format(shm::segment_name(channel, pid)));
+        }
+    }  // namespace
+
+    TEST_CASE("025 - the collector merges producer processes in timestamp order", "[025][shm]") {
+        auto channel = test_channel("merge");
+        auto start = spdlog::log_clock::now();
+        auto sink = std::make_shared<shm_sink>(ShmPolicy{channel});
+
+        // the child writes the odd messages and exits without closing its ring
+        pid_t child = ::fork();
+        REQUIRE(child >= 0);
+        if (child == 0) {
+            shm_sink child_sink{ShmPolicy{channel}};
+            for (int i : {1, 3, 5})
+                child_sink.log(message(start + std::chrono::milliseconds{i}, "message {}"_format(i)));
+            ::_exit(0);
+        }
+        for (int i : {0, 2, 4})
+            sink->log(message(start + std::chrono::milliseconds{i}, "message {}"_format(i)));
+        int status{0};
+        REQUIRE(::waitpid(child, &status, 0) == child);
+        REQUIRE(segment_exists(channel, child));
+
+        delivered collected{"%n|%l|%s:%#|%!|%v"};
+        shm_collector collector{channel};
+        CHECK(collector.poll() == 6);
+
+        std::string expected;
+        for (int i = 0; i < 6; ++i)
+            expected += "shm-app|info|worker.cpp:17|work|message {}\n"_format(i);
+        CHECK(collected.text() == expected);
+
+        // the child's ring is drained and its process gone: removed; ours stays until the sink closes it
+        CHECK(collector.producers() == 1);
+        CHECK_FALSE(segment_exists(channel, child));
+        sink.reset();
+        CHECK_FALSE(segment_exists(channel, ::getpid()));
+        CHECK(collector.poll() == 0);
+        CHECK(collector.producers() == 0);
+    }
+
+    TEST_CASE("025 - records wrap around the ring", "[025][shm]") {
+        auto channel = test_channel("wrap");
+        shm_sink sink{ShmPolicy{channel, 4096}};
+        delivered collected{"%v"};
+        shm_collector collector{channel};
+
+        // sizes that leave padding at the end of the buffer on most turns
+        std::string expected;
+        for (size_t round = 0; round < 40; ++round) {
+            for (size_t i = 0; i < 3; ++i) {
+                auto text = "{}.{}:{}"_format(round, i, std::string(100 + 37 * ((round + i) % 11), 'x'));
+                sink.log(message(spdlog::log_clock::now(), text));
+                expected += text + "\n";
+            }
+            REQUIRE(collector.poll() == 3);
+        }
+        CHECK(collected.text() == expected);
+    }
+
+    TEST_CASE("025 - a full ring drops messages and the collector reports them", "[025][shm]") {
+        auto channel = test_channel("full");
+        shm_sink sink{ShmPolicy{channel, 4096}};
+        delivered collected{"%l|%v"};
+        shm_collector collector{channel};
+
+        std::string text(900, 'y');
+        for (int i = 0; i < 10; ++i)
+            sink.log(message(spdlog::log_clock::now(), text));
+        // larger than half the ring: never fits
+        sink.log(message(spdlog::log_clock::now(), std::string(3000, 'z')));
+
+        CHECK(collector.poll() == 4);
+        auto out = collected.text();
+        INFO("Collected: " << out);
+        CHECK(out.contains("warning|shm: 7 messages from process {} were dropped"_format(::getpid())));
+
+        // space is available again once the collector has caught up
+        sink.log(message(spdlog::log_clock::now(), "after"));
+        CHECK(collector.poll() == 1);
+        CHECK(collected.text().ends_with("info|after\n"));
+    }
+
+    TEST_CASE("025 - the collector rejects records whose names are not terminated", "[025][shm]") {
+        auto channel = test_channel("unterminated");
+        shm_sink sink{ShmPolicy{channel, 4096}};
+        delivered collected{"%s:%#|%v"};
+        shm_collector collector{channel};
+        sink.log(message(spdlog::log_clock::now(), "corrupt"));
+
+        // overwrite the NUL after the file name of the first record, as a misbehaving producer might
+        auto path = "/dev/shm{}"_format(shm::segment_name(channel, ::getpid()));
+        int fd = ::open(path.c_str(), O_RDWR);
+        REQUIRE(fd >= 0);
+        auto mapped = shm::DATA_OFFSET + 4096;
+        auto* base = static_cast<char*>(::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        ::close(fd);
+        REQUIRE(base != MAP_FAILED);
+        shm::record_header record;
+        std::memcpy(&record, base + shm::DATA_OFFSET, sizeof(record));
+        REQUIRE(record.file_size > 0);
+        base[shm::DATA_OFFSET + sizeof(record) + record.name_size + record.file_size] = 'x';
+        ::munmap(base, mapped);
+
+        CHECK(collector.poll() == 0);
+        sink.log(message(spdlog::log_clock::now(), "intact"));
+        CHECK(collector.poll() == 1);
+        CHECK(collected.text() == "worker.cpp:17|intact\n");
+    }
+
+    TEST_CASE("025 - the collector thread delivers until stopped", "[025][shm]") {
+        auto channel = test_channel("thread");
+        shm_sink sink{ShmPolicy{channel}};
+        delivered collected{"%v"};
+        shm_collector collector{channel, 1ms};
+        collector.start();
+
+        for (int i = 0; i < 100; ++i)
+            sink.log(message(spdlog::log_clock::now(), "tick {}"_format(i)));
+        collector.stop();
+
+        auto out = collected.text();
+        CHECK(out.starts_with("tick 0\n"));
+        CHECK(out.ends_with("tick 99\n"));
+    }
+
+    TEST_CASE("025 - shm configs", "[025][shm]") {
+        auto conf = Config::make_shm("orders", "shm-conf", 1 << 16);
+        CHECK(conf.shm_log());
+        CHECK(conf.shm.channel == "orders");
+        CHECK(conf.shm.ring_size == 1 << 16);
+        CHECK(conf.to_string() == "Config[ name=shm-conf | type=shm ]");
+
+        CHECK_THROWS_AS(shm_sink{ShmPolicy{"a/b"}}, std::invalid_argument);
+    }
+}  // namespace un::log::test
@@ -4,4 +4,10 @@ namespace un::log::test {
 
     std::stringstream util::stream = std::stringstream{};
 
+    void capture_sink::sink_it_(const spdlog::details::log_msg& msg) {
+        spdlog::memory_buf_t formatted;
+        formatter_->format(msg, formatted);
+        util::stream.write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
+    }
+
 }
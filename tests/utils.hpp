@@ -3,54 +3,92 @@
 #include "unlog.hpp"
 
 #include <catch2/catch_test_macros.hpp>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/null_sink.h>
 #include <spdlog/sinks/ostream_sink.h>
 
+#include <mutex>
 #include <ostream>
+#include <thread>
 
 namespace un::log::test {
 
     using namespace un::log::literals;
 
+    // Writes to util::stream under one lock shared by every capture sink, so the stream can be read while backend
+    // threads still deliver to it
+    struct capture_mutex {
+        static inline std::mutex mutex;
+
+        void lock() { mutex.lock(); }
+        void unlock() { mutex.unlock(); }
+    };
+
+    class capture_sink final : public spdlog::sinks::base_sink<capture_mutex> {
+      protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override;
+        void flush_() override {}
+    };
+
     struct util {
         static std::stringstream stream;
 
         static auto reset() {
+            std::lock_guard lock{capture_mutex::mutex};
             stream = {};
             stream.clear();
         }
 
+        // What the capture sinks have written so far
+        static std::string contents() {
+            std::lock_guard lock{capture_mutex::mutex};
+            return stream.str();
+        }
+
         static auto capture_test_logs(LogLevel level = get_default_level()) {
             unlog::flush();  // clear any previous test case logs in buffer
             reset();
             set_default_level(level);
-            detail::add_sink(std::make_shared<spdlog::sinks::ostream_sink_mt>(stream));
+            detail::add_sink(std::make_shared<capture_sink>());
         }
 
         static auto capture_test_logs(const Config& conf, LogLevel level = get_default_level()) {
             unlog::flush();  // clear any previous test case logs in buffer
             reset();
             set_default_level(level);
-            detail::add_sink(conf, std::make_shared<spdlog::sinks::ostream_sink_mt>(stream));
+            detail::add_sink(conf, std::make_shared<capture_sink>());
         }
 
         static auto CHECK_CONTAINS(const std::string& msg) {
-            INFO("Contents: " << stream.str());
-            CHECK(stream.str().contains(msg));
+            INFO("Contents: " << contents());
+            CHECK(contents().contains(msg));
         }
 
         static auto REQUIRE_CONTAINS(const std::string& msg) {
-            INFO("Contents: " << stream.str());
-            REQUIRE(stream.str().contains(msg));
+            INFO("Contents: " << contents());
+            REQUIRE(contents().contains(msg));
+        }
+
+        // Async loggers deliver on the backend thread; poll until the message arrives or the timeout expires
+        static bool WAIT_CONTAINS(const std::string& msg, std::chrono::milliseconds timeout = 1s) {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            do {
+                unlog::flush();
+                if (contents().contains(msg))
+                    return true;
+                std::this_thread::sleep_for(1ms);
+            } while (std::chrono::steady_clock::now() < deadline);
+            return false;
         }
 
         static auto CHECK_EMPTY() {
-            INFO("Contents: " << stream.str());
-            CHECK(stream.str().empty());
+            INFO("Contents: " << contents());
+            CHECK(contents().empty());
         }
 
         static auto REQUIRE_EMPTY() {
-            INFO("Contents: " << stream.str());
-            REQUIRE(stream.str().empty());
+            INFO("Contents: " << contents());
+            REQUIRE(contents().empty());
         }
     };
 
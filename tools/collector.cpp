@@ -0,0 +1,62 @@
+// unlog-collector: delivers the messages of every process logging to a shared-memory channel (Type::Shm) to stdout
+// or a file, in timestamp order, until interrupted. %* measures from the collector's own start.
+//
+//     unlog-collector [-c CHANNEL] [-o FILE] [-p PATTERN]
+
+#include "unlog.hpp"
+#include "unlog/shm.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    volatile std::sig_atomic_t interrupted = 0;
+
+    void on_signal(int) { interrupted = 1; }
+
+    int usage(const char* argv0) {
+        std::fprintf(stderr, "Usage: %s [-c CHANNEL] [-o FILE] [-p PATTERN]\n", argv0);
+        return 2;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string channel{"unlog"};
+    std::optional<std::string> output, pattern;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            channel = argv[++i];
+        else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            pattern = argv[++i];
+        else
+            return usage(argv[0]);
+    }
+
+    try {
+        auto conf = output ? un::log::Config::make_file(*output, "unlog-collector")
+                           : un::log::Config{"unlog-collector", un::log::Type::cout, un::log::Flags::threadsafe, 0, 0};
+        conf.format = pattern;
+        un::log::make_logger(conf, true);
+
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+
+        un::log::shm_collector collector{channel};
+        while (not interrupted) {
+            if (collector.poll() == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            un::log::master_sink->flush();
+        }
+        collector.poll();
+        un::log::master_sink->flush();
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+    return 0;
+}
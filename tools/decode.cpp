@@ -0,0 +1,71 @@
+// unlog-decode: renders binary logs (Type::Binary) back to text with any pattern the spdlog formatter supports,
+// including unlog's %* flag, which is measured from the start time of the process that wrote the log.
+//
+//     unlog-decode [-p PATTERN] FILE...
+
+#include "unlog/binary.hpp"
+#include "unlog/pattern.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    int usage(const char* argv0) {
+        std::fprintf(stderr, "Usage: %s [-p PATTERN] FILE...\n", argv0);
+        return 2;
+    }
+
+    std::unique_ptr<spdlog::pattern_formatter> make_formatter(
+            const std::string& pattern, spdlog::log_clock::time_point origin) {
+        auto formatter = std::make_unique<spdlog::pattern_formatter>();
+        formatter->add_flag<un::log::startup_elapsed_flag>('*', origin);
+        formatter->set_pattern(pattern);
+        return formatter;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string pattern = un::log::DEFAULT_PATTERN;
+    std::vector<un::log::fs::path> files;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            pattern = argv[++i];
+        else if (argv[i][0] == '-')
+            return usage(argv[0]);
+        else
+            files.emplace_back(argv[i]);
+    }
+    if (files.empty())
+        return usage(argv[0]);
+
+    int status = 0;
+    spdlog::memory_buf_t out;
+
+    for (auto& file : files) {
+        try {
+            un::log::binary_reader reader{file};
+            std::unique_ptr<spdlog::pattern_formatter> formatter;
+            spdlog::log_clock::time_point origin{};
+
+            bool complete = reader.read([&](const spdlog::details::log_msg& msg) {
+                // a new header (an appended run) moves the %* origin
+                if (not formatter or reader.started_at() != origin) {
+                    origin = reader.started_at();
+                    formatter = make_formatter(pattern, origin);
+                }
+                out.clear();
+                formatter->format(msg, out);
+                std::fwrite(out.data(), 1, out.size(), stdout);
+            });
+
+            if (not complete)
+                std::fprintf(stderr, "%s: stream ends partway through a frame\n", file.c_str());
+        }
+        catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: %s\n", file.c_str(), e.what());
+            status = 1;
+        }
+    }
+    return status;
+}